@@ -15,12 +15,17 @@
  * Le connessioni possono essere inserite anche solo una volta, cioè basta mettere:
  * <A;B;3> non serve anche <B;A;3>
  *
+ * I nomi dei router vengono salvati una sola volta e trasformati in ID interi
+ * (0, 1, 2, ...), il grafo viene tenuto in formato CSR (compressed sparse row):
+ * per ogni nodo gli archi uscenti sono contigui in memoria, quindi Dijkstra non
+ * deve più scorrere tutta la lista delle connessioni confrontando stringhe.
+ *
  * Avvio: per far partire il programma avviarlo, inserire una scelta dal menu, prima di
  * tutto va creata almeno una connessione, e poi seguire le istruzioni.
  *
- * Problemi: il controllo dell'input non è ancora ottimale e se quando si vuole
- * inserire un nuovo file il programma non controlla se il file esiste nella cartella
- * perchè non so come controllarlo sia su Linux che su Windows.
+ * Problemi: il controllo dell'input da tastiera non è ancora ottimale. Le righe
+ * dei file che non rispettano il formato vengono saltate e segnalate con il
+ * loro numero di riga.
  *
  * Autore: Gabriel Duta
  */
@@ -29,23 +34,106 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/* Tabella dei nomi dei router: ogni nome è salvato una sola volta in un unico
+   buffer di caratteri e gli viene associato un ID intero denso */
+struct tabellaNomi {
+    char *caratteri;        // Tutti i nomi uno dopo l'altro, separati da '\0'
+    size_t usati;
+    size_t capacitaCaratteri;
+    size_t *inizio;         // inizio[id] = posizione del nome id in caratteri
+    int numNomi;
+    int capacitaNomi;
+    int *slot;              // Hash table ad indirizzamento aperto (-1 = libero)
+    unsigned int *hashSlot; // Hash del nome in ogni slot, evita di confrontare i nomi
+    int capacitaSlot;
+};
+
+/* Link diretto che connette due router, identificati dal loro ID. Un arco
+   rimosso ha partenza ARCO_RIMOSSO e in arrivo la prossima posizione libera */
+#define ARCO_RIMOSSO -1
+struct arco {
+    int partenza;
+    int arrivo;
+    int costo;
+    int area;               // Area del link (quarto campo della riga), 0 se non indicata
+    int succ;               // Arco successivo con la stessa partenza e lo stesso arrivo, -1 se è l'ultimo
+};
+
+/* Grafo in formato CSR: gli archi uscenti dal nodo i sono quelli con indice
+   compreso tra offset[i] e offset[i + 1] - 1 */
+struct csr {
+    int numNodi;
+    int numArchi;
+    int *offset;
+    int *arrivo;
+    int *costo;
+    /* Archi entranti, costruiti solo quando servono (aggiornaEntrate) */
+    int *offsetEntrata;
+    int *partenzaEntrata;
+    int *costoEntrata;
+    int costoMinimo;        // Costi estremi degli archi, scelgono la coda di calcolaTabella
+    int costoMassimo;
+};
 
-/* Link che connette due router */
-struct connessione {
-    char routerPartenza[15];
-    char routerArrivo[15];
-    int costoLink;
+/* Hash table degli archi diretti presenti con il numero di archi paralleli
+   e la posizione del primo, serve per controllare i duplicati e trovare un
+   arco in O(1). Le chiavi che arrivano a 0 archi vengono tolte */
+#define ARCO_LIBERO (~0ull)
+struct insiemeArchi {
+    unsigned long long *chiavi;     // (partenza << 32) | arrivo, ARCO_LIBERO se vuoto
+    int *conteggio;
+    int *primo;                     // Posizione in rete.archi del primo arco, catena con succ
+    int numChiavi;
+    int capacita;
 };
-/* Linked list per le connessioni tra router */
-struct Links {
-    struct connessione connessione;
-    struct Links *next;
+
+/* Topologia di rete: la lista degli archi in ordine di inserimento è quella
+   che viene modificata, il CSR viene corretto sul posto quando si può e
+   ricostruito solo quando serve. Un arco tolto sul posto lascia nella sua
+   riga un buco, l'arco i -> i di costo 0, che non cambia nessun percorso e
+   può essere riusato da un arco aggiunto alla stessa riga. Nel CSR un buco
+   non si distingue da un vero link i -> i di costo 0: chi legge il CSR come
+   elenco dei link usa aggiornaCSRCompatto, chi conta gli archi di un nodo
+   toglie rete.buchi e chi cerca un link usa l'insieme degli archi */
+struct grafo {
+    struct arco *archi;
+    int numArchi;           // Archi presenti
+    int numSlot;            // Posizioni usate in archi, compresi i buchi liberi
+    int capacitaArchi;
+    int primoLibero;        // Lista delle posizioni libere da riusare, -1 se vuota
+    struct insiemeArchi presenti;
+    struct csr csr;
+    bool csrValido;
+    bool entrateValide;
+    int *buchi;             // Buchi in ogni riga del CSR, NULL se non si può correggere sul posto
+    int *buchiEntrata;      // Buchi in ogni riga degli archi entranti
+    int numBuchi;
+    unsigned long long *generazioneArea;    // Aumenta ad ogni modifica di un link dell'area
+    int numAree;            // Area più alta usata + 1
+    int capacitaAree;
 };
 
 /* Entry della tabella di instradamento */
 struct entry {
-    char nextHop[15];
-    char destinazione[15];
+    int nextHop;
+    int destinazione;
     int costo;
 };
 /* Linked list per la tabella di instradamento*/
@@ -54,38 +142,967 @@ struct llTabella {
     struct llTabella *next;
 };
 
-/* Linked list per gestire la priority queue */
-struct priority {
-    char nodo[15];
-    int valore;
-    struct priority *next;
+/* Arietà del heap usato come priority queue, si sceglie in compilazione
+   (es. gcc -DARIETA_HEAP=8): con più figli per nodo l'albero è più basso e
+   le decrease-key costano meno, ma ogni estrazione confronta più figli */
+#ifndef ARIETA_HEAP
+#define ARIETA_HEAP 4
+#endif
+#if ARIETA_HEAP != 2 && ARIETA_HEAP != 4 && ARIETA_HEAP != 8
+#error "ARIETA_HEAP deve essere 2, 4 oppure 8"
+#endif
+
+/* Heap d-ario indicizzato per gestire la priority queue: posizione permette
+   di trovare un nodo nel heap in O(1) e quindi di fare decrease-key in O(log V) */
+struct heap {
+    int *nodi;              // nodi[i] = nodo che si trova in posizione i
+    int *valori;            // valori[i] = priorità del nodo in posizione i
+    int *posizione;         // posizione[nodo] = indice nel heap, -1 se assente
+    int dimensione;
+};
+
+/* Coda monotona per costi interi non negativi, scelta da tipoCoda in base al
+   costo massimo degli archi. Con costi piccoli è una coda di Dial: un bucket
+   per ogni costo, usati in modo circolare perché i nodi in coda hanno priorità
+   tra base e base + costoMassimo. Con costi grandi è un radix heap: il bucket
+   b contiene i nodi la cui priorità differisce da base (l'ultima estratta) a
+   partire dal bit b - 1. Le liste dei bucket usano gli array del heap, che
+   durante calcolaTabella non viene usato: nodi[] è il successivo, valori[] il
+   precedente e posizione[] il bucket del nodo (-1 se non è in coda) */
+#define CODA_HEAP 0
+#define CODA_DIAL 1
+#define CODA_RADIX 2
+#define LIMITE_DIAL 256         // Bucket della coda di Dial, si usa se costoMassimo < LIMITE_DIAL
+#define BUCKET_RADIX 33
+struct codaBucket {
+    int *testa;             // testa[b] = primo nodo del bucket b, -1 se vuoto
+    int numBucket;
+    int base;
+    int dimensione;
+};
+
+/* Corsie del calcolo multi-sorgente: ogni nodo ha un vettore di distanze, una
+   per sorgente, e ogni arco viene rilassato per tutte le sorgenti insieme con
+   le estensioni vettoriali di GCC. Il compilatore usa le istruzioni SIMD
+   disponibili (es. -mavx2 per 8 corsie in un registro, -mavx512f per 16),
+   altrimenti codice scalare equivalente */
+#ifndef NUM_CORSIE
+#define NUM_CORSIE 8
+#endif
+#if NUM_CORSIE != 4 && NUM_CORSIE != 8 && NUM_CORSIE != 16
+#error "NUM_CORSIE deve essere 4, 8 oppure 16"
+#endif
+typedef unsigned int corsie __attribute__((vector_size(NUM_CORSIE * sizeof(unsigned int))));
+/* Vettore di interi con segno largo quanto i registri SIMD della macchina
+   per cui si compila, usato da Floyd-Warshall: i confronti tra interi con
+   segno esistono anche in SSE2, quelli senza segno vanno emulati */
+#if defined(__AVX512F__)
+#define BYTE_SIMD 64
+#elif defined(__AVX2__)
+#define BYTE_SIMD 32
+#else
+#define BYTE_SIMD 16
+#endif
+typedef int corsieSegno __attribute__((vector_size(BYTE_SIMD)));
+
+/* Stato del calcolo di NUM_CORSIE tabelle in una sola visita del grafo */
+struct statoMultiplo {
+    int numNodi;
+    corsie *distanza;       // distanza[nodo][l] = costo dalla sorgente l, INT_MAX se non raggiunto
+    corsie *nextHop;
+    struct heap coda;       // Priorità: minimo tra le distanze abbassate dall'ultima estrazione
+};
+
+/* Floyd-Warshall a blocchi per le reti piccole e dense: matrici delle
+   distanze e dei next hop di tutte le coppie, elaborate a blocchi di
+   BLOCCO_FW x BLOCCO_FW che stanno nelle cache L1/L2 */
+#define BLOCCO_FW 64
+#define LIMITE_NODI_FW 4096     // Oltre, le due matrici occupano più di 128 MB
+/* Matrice in automatico se archi * DENSITA_FW >= nodi^2: Floyd-Warshall
+   elabora BYTE_SIMD / 4 colonne per istruzione, con registri più larghi
+   conviene anche su reti meno dense (SSE2 da 1/8 degli archi possibili,
+   AVX-512 da 1/32) */
+#define DENSITA_FW (BYTE_SIMD / 2)
+#define INFINITO_FW (INT_MAX / 2)  // Distanza dei nodi non raggiungibili, la somma di due non va in overflow
+#define MATRICE_AUTO 0
+#define MATRICE_SI 1
+#define MATRICE_NO 2
+struct matriceFW {
+    int numNodi;
+    int lato;                   // numNodi arrotondato a un multiplo di BLOCCO_FW
+    int *distanza;              // distanza[i * lato + j], INFINITO_FW se j non è raggiungibile da i
+    int *nextHop;
+    int numThread;
+    int numAvviati;             // Thread avviati, dà ad ogni thread il suo indice
+    double tempo;               // Durata del calcolo, per le statistiche
+    pthread_barrier_t barriera;
+};
+
+/* Contatori di Dijkstra e tempi delle fasi (in secondi), raccolti solo se
+   le statistiche sono attive */
+struct statisticheSPF {
+    long long tabelle;
+    long long nodiEstratti;
+    long long archiRilassati;       // Archi uscenti dei nodi estratti
+    long long decreaseKey;          // Nodi già in coda a cui è stato abbassato il costo
+    int piccoCoda;                  // Dimensione massima raggiunta dalla priority queue
+    long long byteAllocati;
+    double caricamento;
+    double costruzione;             // Costruzione del CSR
+    double calcolo;
+    double stampa;
+};
+#define STATISTICHE_SPENTE 0
+#define STATISTICHE_TESTO 1
+#define STATISTICHE_JSON 2
+
+/* Stato della costruzione di una tabella: un elemento per ogni nodo, indicizzato
+   con l'ID, così durante Dijkstra ogni accesso è O(1). La tabella nel formato
+   della linked list viene creata solo alla fine */
+struct statoTabella {
+    int *distanza;          // Costo minimo trovato, INT_MAX se non raggiunto
+    int *nextHop;
+    int *precedente;        // Nodo precedente nel percorso minimo
+    int *ordine;            // Nodi raggiunti, nell'ordine in cui sono stati trovati
+    int numRaggiunti;
+    int numNodi;
+    struct heap coda;
+    struct codaBucket bucket;
+    struct statisticheSPF contatori;    // Statistiche dell'ultima tabella calcolata
+};
+
+/* Buffer di caratteri che cresce automaticamente, usato per preparare
+   l'output senza fare una printf per ogni riga */
+struct buffer {
+    char *dati;
+    size_t usati;
+    size_t capacita;
+};
+
+/* Stato della lettura di un file di topologia */
+struct letturaFile {
+    const char *nomeFile;
+    int riga;               // Numero della riga che si sta leggendo
+    int righeErrate;
+};
+
+/* Intestazione dello snapshot binario della topologia. Dopo l'intestazione
+   ci sono, ognuna allineata a 8 byte: i caratteri dei nomi, inizio dei nomi,
+   slot e hashSlot della hash table dei nomi, offset, arrivo e costo del CSR.
+   Gli array vengono usati direttamente dalla memoria mappata */
+#define MAGIC_SNAPSHOT "DIJKSNAP"
+#define VERSIONE_SNAPSHOT 1
+#define ORDINE_BYTE 0x01020304u
+struct intestazioneSnapshot {
+    char magic[8];
+    unsigned int versione;
+    unsigned int ordineByte;        // Per riconoscere snapshot di macchine big endian
+    unsigned long long numNodi;
+    unsigned long long numArchi;
+    unsigned long long dimensioneCaratteri;
+    unsigned long long capacitaSlot;
+    unsigned long long checksum;    // Checksum di tutto quello che segue l'intestazione
+};
+
+/* Snapshot attualmente mappato in memoria, dati è NULL se non c'è */
+struct snapshot {
+    void *dati;
+    size_t dimensione;
+};
+
+/* Albero dei cammini minimi di una sorgente tenuto in cache: oltre alla
+   tabella vengono salvati i figli di ogni nodo (lista doppiamente concatenata
+   tra fratelli), così quando un link cambia si trova subito il sottoalbero
+   da riparare senza rifare Dijkstra da zero */
+struct alberoSPF {
+    int sorgente;
+    struct statoTabella stato;
+    int *primoFiglio;
+    int *fratelloSucc;
+    int *fratelloPrec;
+    unsigned long long generazione;     // Generazione della topologia a cui l'albero è aggiornato
+    struct alberoSPF *prec, *succ;      // Lista LRU
+};
+
+/* Cache degli alberi calcolati, con un limite di memoria: quando viene
+   superato si eliminano gli alberi usati meno di recente. Un albero è valido
+   solo se la sua generazione è quella attuale della topologia */
+#define BUDGET_CACHE_MB 256
+struct cacheAlberi {
+    struct alberoSPF **perSorgente;     // perSorgente[id] = albero in cache o NULL
+    int numSorgenti;
+    struct alberoSPF *recente, *vecchio;
+    int numAlberi;
+    size_t memoria;
+    size_t budget;
+    long long hit, miss, eliminati, invalidati;
+    int *sottoalbero;                   // Spazio per riparaAumento, riusato tra le chiamate
+    int capacitaSottoalbero;
+};
+
+/* Tabelle (FIB) già mandate ai router: per ogni sorgente il next hop e il
+   costo di ogni destinazione all'ultima scrittura dei delta. Le riparazioni
+   degli alberi in cache segnano le destinazioni toccate, così i delta si
+   trovano ricontrollando solo quelle */
+#define FIB_TESTO 0
+#define FIB_BINARIO 1
+/* Record del formato binario: un byte di tipo seguito da interi a 32 bit
+   nell'ordine dei byte della macchina (come lo snapshot) */
+#define DELTA_NOME 'N'          // id, lunghezza, caratteri: nome di un router non ancora scritto
+#define DELTA_SORGENTE 'S'      // sorgente: le righe seguenti sono della sua tabella
+#define DELTA_AGGIUNTA 'A'      // destinazione, nextHop, costo
+#define DELTA_MODIFICA 'M'      // destinazione, nextHop, costo
+#define DELTA_RITIRO 'W'        // destinazione
+#define DELTA_FINE 'E'          // righe cambiate nel gruppo: fine di una scrittura
+struct fibSorgente {
+    int *nextHop;           // -1 se la destinazione non era nella tabella
+    int *costo;
+    int numNodi;            // Destinazioni con spazio allocato
+    int *sporchi;           // Destinazioni da ricontrollare
+    int numSporchi;
+    unsigned char *segnato; // La destinazione è già in sporchi
+    bool tutto;             // Da ricontrollare tutta (albero ricalcolato da zero)
+};
+struct statoFib {
+    bool attiva;
+    int formato;            // FIB_TESTO o FIB_BINARIO
+    FILE *output;
+    struct fibSorgente *perSorgente;
+    int numSorgenti;
+    int nomiScritti;        // Nomi già scritti nel formato binario
+    long long righe;        // Righe cambiate scritte in tutto
+    long long byte;
+};
+
+/* Tabelle di tutti i router in forma compatta, in un file mappato in
+   memoria. Per ogni coppia (sorgente, destinazione) un campo di bitVicino
+   bit contiene la posizione + 1 del next hop tra gli archi uscenti della
+   sorgente nel CSR (0 se la destinazione non è raggiungibile o è la
+   sorgente) e, se i costi sono salvati, un campo di bitCosto bit contiene
+   costo - costoBase. Ogni riga inizia su una parola da 64 bit. Dopo
+   l'intestazione ci sono le righe dei next hop e poi quelle dei costi; non
+   c'è checksum sui dati, così il file viene mappato senza leggerlo tutto */
+#define MAGIC_FIB "DIJKFIBC"
+#define VERSIONE_FIB 1
+struct intestazioneFib {
+    char magic[8];
+    unsigned int versione;
+    unsigned int ordineByte;
+    unsigned long long impronta;        // Rete per cui è stata costruita (improntaTopologia)
+    unsigned long long numNodi;
+    unsigned int bitVicino;
+    unsigned int bitCosto;              // 0 se i costi non sono salvati
+    long long costoBase;
+    unsigned long long paroleVicino;    // Parole da 64 bit di una riga dei next hop
+    unsigned long long paroleCosto;     // Parole da 64 bit di una riga dei costi
+};
+struct fibCompatta {
+    void *dati;             // Mappa del file, NULL se non c'è
+    size_t dimensione;
+    int numNodi;
+    int bitVicino;
+    int bitCosto;
+    long long costoBase;
+    size_t paroleVicino;
+    size_t paroleCosto;
+    unsigned long long *vicini;
+    unsigned long long *costi;
+    const int *offset;      // CSR della rete, per tradurre le posizioni in router
+    const int *arrivo;
+};
+
+/* Lavoro condiviso dai thread che costruiscono la FIB compatta */
+struct lavoroFibCompatta {
+    const struct csr *g;
+    struct fibCompatta *f;
+    int corsie;
+    int prossima;           // Prima sorgente non ancora presa da un thread
+    long long costoMinimo;  // Costi estremi trovati, per stringere bitCosto alla fine
+    long long costoMassimo;
+    pthread_mutex_t mutex;
+};
+
+/* Guasto simulato dall'analisi di resilienza: un link (nei due versi) o,
+   con arrivo -1, un router con tutti i suoi link. I contatori sommano le
+   coppie (sorgente, destinazione) di tutte le sorgenti analizzate */
+struct guasto {
+    int partenza;
+    int arrivo;
+    long long cambiate;         // Coppie con next hop o costo diverso
+    long long aumentate;        // Coppie con costo aumentato
+    long long aumentoTotale;
+    int aumentoMassimo;
+    long long irraggiungibili;  // Coppie rimaste senza percorso
+};
+
+/* Vista di un thread dell'analisi di resilienza: la rete resta quella
+   condivisa, gli archi del guasto vengono saltati, e i costi ricalcolati
+   esistono solo per i nodi dei sottoalberi staccati */
+struct vistaGuasto {
+    int *distanza;
+    int *nextHop;
+    int *segno;                 // segno[nodo] == turno se il nodo è staccato
+    int turno;
+    int *sottoalbero;
+    struct heap coda;
+};
+
+/* Lavoro condiviso dai thread dell'analisi di resilienza */
+struct lavoroResilienza {
+    const struct csr *g;
+    struct alberoSPF **alberi;  // Alberi di base delle sorgenti, solo letti
+    int numAlberi;
+    struct guasto *guasti;
+    int numGuasti;
+    int prossimo;               // Primo guasto non ancora preso da un thread
+    long long toccati;          // Nodi ricalcolati in tutto
+    pthread_mutex_t mutex;
+};
+
+/* Coordinate dei router, lette dalle righe @router;x;y dei file di
+   topologia, usate da A* per stimare il costo rimanente */
+struct coordinate {
+    double *x;
+    double *y;
+    bool *presente;
+    int capacita;
+    int numPresenti;
+    double scala;                       // Costo minimo per unità di distanza dei link
+    bool scalaValida;
+    unsigned long long generazione;     // Generazione della topologia per cui scala è valida
+};
+
+/* Gerarchia di contrazione: ogni nodo ha un rango e tiene solo gli archi
+   verso nodi di rango maggiore, uscenti (Su, per la ricerca da partenza) ed
+   entranti (Giu, per la ricerca da arrivo). mezzo è il nodo contratto da cui
+   è nata una scorciatoia, -1 per gli archi originali. */
+struct gerarchia {
+    int numNodi;
+    int *rango;
+    int *offsetSu;
+    int *arrivoSu;
+    int *costoSu;
+    int *mezzoSu;
+    int *offsetGiu;
+    int *partenzaGiu;
+    int *costoGiu;
+    int *mezzoGiu;
+    int *arcoAvanti;                    // Arco con cui le ricerche hanno raggiunto ogni nodo
+    int *arcoIndietro;
+    unsigned long long impronta;        // Impronta della rete per cui è stata costruita
+    unsigned long long generazione;
+    bool valida;
+};
+
+/* Archi di un nodo durante la costruzione della gerarchia */
+struct archiCH {
+    int *vicino;
+    int *costo;
+    int *mezzo;
+    int numero;
+    int capacita;
+};
+
+/* Stato della costruzione della gerarchia */
+#define LIMITE_TESTIMONE 500            // Nodi estratti al massimo da una ricerca testimone
+#define LIMITE_TESTIMONE_SIMULA 50      // Idem quando la contrazione è solo simulata
+#define LIMITE_AGGIORNA_VICINI 64       // Coppie di archi oltre cui la priorità di un vicino resta pigra
+struct costruzioneCH {
+    int numNodi;
+    struct archiCH *uscenti;            // Solo archi tra nodi non ancora contratti, tranne
+    struct archiCH *entranti;           // quelli dei nodi contratti, che restano fissi
+    int *viciniContratti;
+    int *livello;
+    int *obiettivo;                     // Vale turno per i nodi che la ricerca testimone deve trovare
+    int turno;
+    struct statoTabella testimone;
+};
+
+/* Intestazione del file della gerarchia, stesso schema dello snapshot */
+#define MAGIC_GERARCHIA "DIJKGERA"
+#define VERSIONE_GERARCHIA 1
+struct intestazioneGerarchia {
+    char magic[8];
+    unsigned int versione;
+    unsigned int ordineByte;
+    unsigned long long impronta;
+    unsigned long long numNodi;
+    unsigned long long numSu;
+    unsigned long long numGiu;
+    unsigned long long checksum;
+};
+
+/* Lista di nodi che cresce automaticamente */
+struct listaNodi {
+    int *nodi;
+    int numero;
+    int capacita;
+};
+
+/* Dati condivisi tra i thread della modalità batch */
+struct lavoroBatch {
+    const struct csr *g;
+    const int *sorgenti;    // Router di cui calcolare la tabella
+    int numSorgenti;
+    int prossima;           // Prossima sorgente da assegnare ad un thread
+    int daScrivere;         // Prossima sorgente da scrivere, l'output resta in ordine
+    int corsie;             // Sorgenti calcolate in una sola visita (1 = calcolaTabella)
+    const struct matriceFW *matrice;    // Se non è NULL le tabelle vengono copiate da qui
+    const struct reteAree *aree;        // Se non è NULL le tabelle usano l'SPF a aree
+    FILE *output;
+    pthread_mutex_t mutex;
+    pthread_cond_t turno;
+};
+
+/* Delta-stepping parallelo per una sola tabella su grafi grandi: i nodi sono
+   divisi in bucket larghi delta in base alla distanza provvisoria e quelli
+   dello stesso bucket vengono elaborati insieme da tutti i thread, prima
+   con gli archi leggeri (costo < delta, possono riportare nodi nel bucket)
+   e poi una volta sola con quelli pesanti. Ogni thread ha le sue liste per i
+   bucket, così gli inserimenti non richiedono lock */
+#define SOGLIA_DELTA 50000      // Nodi oltre cui il menu usa il delta-stepping (con --thread)
+#define BLOCCO_DELTA 64         // Nodi della frontiera presi da un thread alla volta
+#define MAX_BUCKET_DELTA 1024   // Limite ai bucket circolari, delta viene alzato di conseguenza
+struct deltaStepping {
+    const struct csr *g;
+    unsigned long long *etichetta;  // (distanza << 32) | precedente, abbassata con compare-and-swap
+    int delta;
+    int numThread;
+    int numBucket;                  // Bucket circolari, costoMassimo / delta + 2
+    struct listaNodi *bucket;       // bucket[t * numBucket + b]: nodi inseriti dal thread t
+    struct listaNodi *prossimi;     // prossimi[t]: nodi da rielaborare nel bucket corrente
+    struct listaNodi *elaborati;    // elaborati[t]: nodi di cui rilassare gli archi pesanti
+    struct listaNodi frontiera;     // Nodi elaborati in parallelo nel passo attuale
+    int *fase;                      // Ultimo passo in cui il nodo è entrato nella frontiera
+    int numFase;
+    int corrente;                   // Bucket in elaborazione
+    int prossimoBlocco;             // Prossima posizione della frontiera da assegnare
+    int numAvviati;                 // Thread avviati, dà ad ogni thread il suo indice
+    bool pesanti;                   // Nel passo attuale si rilassano gli archi pesanti
+    bool fine;
+    int piccoFrontiera;
+    long long estratti;
+    long long rilassati;
+    long long aggiornamenti;
+    pthread_barrier_t barriera;
+};
+
+/* Versione immutabile della rete letta dai thread del server: lo scrittore
+   modifica la lista degli archi e i nomi globali, poi pubblica una copia
+   del CSR in una nuova versione. I nomi vengono copiati solo se ne sono
+   comparsi di nuovi, altrimenti sono condivisi con la versione precedente */
+struct versioneRete {
+    struct csr csr;                 // Solo offset, arrivo e costo
+    struct tabellaNomi *nomi;
+    unsigned long long numero;      // generazioneTopologia al momento della pubblicazione
+    unsigned long long epoca;       // Epoca in cui è stata sostituita
+    bool liberaNomi;                // La versione successiva ha una sua copia dei nomi
+    struct versioneRete *succ;      // Lista delle versioni sostituite
+};
+
+/* Recupero delle versioni a epoche: un lettore annuncia l'epoca globale
+   prima di prendere la versione attuale, una versione sostituita
+   all'epoca e può essere liberata quando nessun lettore è fermo ad
+   un'epoca minore di e */
+struct epocheRete {
+    unsigned long long globale;     // Parte da 1, aumenta ad ogni sostituzione
+    unsigned long long *lettori;    // Epoca di ogni lettore, 0 se non sta leggendo
+    int numLettori;
+    struct versioneRete *attuale;
+    struct versioneRete *ritirate;  // Versioni sostituite non ancora liberate
+};
+
+/* Ricerca limitata: tabella parziale dei router entro un costo, entro un
+   numero di hop o dei più vicini. I router visitati hanno un indice locale
+   dato da una hash table, così la memoria è proporzionale ai router
+   visitati e non alla rete */
+#define SENZA_LIMITE -1
+struct limitiRicerca {
+    int costo;              // Costo massimo delle destinazioni, SENZA_LIMITE se non c'è
+    int hop;                // Numero massimo di hop dei percorsi, SENZA_LIMITE se non c'è
+    int numero;             // Destinazioni più vicine da trovare, SENZA_LIMITE se non c'è
+};
+struct statoLimitato {
+    int *slot;              // Indice locale del router nello slot, -1 se libero
+    int capacitaSlot;       // Potenza di 2, almeno il doppio dei router visitati
+    int *nodo;              // ID globale di ogni indice locale
+    int *distanza;
+    int *nextHop;
+    int *ordine;            // Destinazioni trovate (indici locali) in ordine di costo
+    int numVisitati;
+    int numRisultati;
+    int capacita;
+    struct heap coda;       // Su indici locali
+    /* Con il limite di hop: router migliorati nell'ultimo giro e il loro
+       nodo, costo e next hop alla fine di quel giro */
+    int *frontiera;
+    int *nodoGiro;
+    int *costoGiro;
+    int *hopGiro;
+    int *giro;              // Ultimo giro in cui il router è entrato nella frontiera
+};
+
+/* Server su socket Unix: ogni thread accetta una connessione alla volta e
+   risponde insieme a tutte le richieste complete arrivate con una lettura.
+   Le tabelle vengono calcolate sulla versione pubblicata della rete senza
+   lock; le modifiche consecutive vengono applicate con mutexScrittura e
+   pubblicate insieme in una sola nuova versione */
+#define ATTESA_SERVER 64                // Connessioni in coda per accept
+#define LIMITE_RICHIESTA (1 << 20)      // Byte senza '\n' oltre cui la connessione viene chiusa
+#define ACCESSO_NESSUNO 0
+#define ACCESSO_LETTURA 1
+#define ACCESSO_SCRITTURA 2
+struct lavoratoreServer {
+    int ascolto;                // Socket su cui fare accept, condiviso
+    int indice;                 // Posizione del thread in epoche.lettori
+    struct statoTabella stato;  // Stato di Dijkstra del thread, riusato tra le richieste
+    struct statoLimitato limitato;  // Stato delle richieste VICINI
+    struct buffer entrata;      // Byte letti e non ancora elaborati
+    struct buffer uscita;       // Risposte spedite alla fine di ogni lettura
+    int accesso;                // Accesso alla rete tenuto ora
+    const struct versioneRete *versione;    // Versione letta, con ACCESSO_LETTURA
+    bool modificata;            // Il gruppo di modifiche ha cambiato la rete
+};
+
+/* Rinumerazione dei router dopo il caricamento: nodi vicini nel grafo
+   ricevono ID vicini, così le distanze lette rilassando gli archi di un
+   nodo stanno nelle stesse righe di cache. I nomi non cambiano */
+#define ORDINE_NESSUNO 0        // ID nell'ordine in cui i router compaiono nei file
+#define ORDINE_BFS 1            // Ordine di visita in ampiezza
+#define ORDINE_RCM 2            // Cuthill-McKee inverso, vicini in ordine di grado
+#define ORDINE_GRADO 3          // Grado decrescente, i router più collegati all'inizio
+
+/* SPF a aree, come le aree OSPF: i router con link in più aree sono router
+   di bordo. Per ogni area si calcolano i cammini interni da ognuno dei suoi
+   router di bordo (sommari); la tabella di un router è Dijkstra nella sua
+   area, Dijkstra sul grafo dei router di bordo (con i sommari come archi) e
+   una combinazione area per area. Quando cambia un link vengono ricalcolati
+   solo i sommari della sua area. Richiede costi positivi */
+#define LIMITE_AREE 65536
+struct area {
+    int numNodi;
+    int *globale;               // ID globale di ogni router dell'area
+    struct csr csr;             // Link dell'area con ID locali
+    int numBordi;
+    int *bordi;                 // ID locali dei router di bordo
+    int *distanzaBordi;         // [r * numNodi + x]: costo nell'area dal bordo r al router x
+    int *precedenteBordi;       // Precedente (locale) di x nel cammino dal bordo r
+    unsigned long long generazione;     // rete.generazioneArea per cui è costruita
+    bool sommariValidi;
+};
+struct reteAree {
+    int numAree;                // Posizioni in aree, comprese quelle vuote
+    int numAreeUsate;
+    struct area *aree;
+    int *offsetAppartiene;      // Aree del router i: da offsetAppartiene[i] a offsetAppartiene[i + 1] - 1
+    int *areaAppartiene;
+    int *localeAppartiene;      // ID del router nell'area
+    int numNodi;
+    int numBordi;
+    int maxNodiArea;
+    int *indiceBordo;           // Posizione del router tra quelli di bordo, -1 se interno
+    int *nodoBordo;             // ID globale di ogni router di bordo
+    struct csr sopra;           // Grafo dei router di bordo, un arco per ogni sommario finito
+    int *areaSopra;             // Area del sommario di ogni arco
+    int *rigaSopra;             // Riga del bordo di partenza in distanzaBordi dell'area
+    int *localeSopra;           // ID locale del bordo di arrivo nell'area
+    unsigned long long generazione;     // generazioneTopologia per cui è costruita
+    bool valida;
+    long long ricalcoli;        // Aree di cui sono stati ricalcolati i sommari
+    double tempoSommari;
+};
+/* Memoria di lavoro di calcolaTabellaAree, una per thread */
+struct statoAree {
+    struct statoTabella locale;         // Dijkstra nell'area della sorgente
+    int *migliore;                      // Costo migliore dei router dell'area che si sta combinando
+    int *rigaMigliore;                  // Riga dei sommari che lo realizza, -1 per quella locale
+    int capacitaNodi;
+    struct heap coda;                   // Dijkstra sul grafo dei router di bordo
+    int *distanzaSopra;
+    int *arcoSopra;                     // Arco del grafo dei bordi usato, -1 per i bordi dell'area di partenza
+    int capacitaBordi;
+};
+
+/* Arena: la memoria viene presa a blocchi grandi e restituita tutta insieme
+   in O(1), usata per le tabelle e per lo stato di Dijkstra temporaneo */
+struct bloccoArena {
+    struct bloccoArena *next;
+    size_t dimensione;
+    size_t usati;
+    char dati[];
+};
+struct arena {
+    struct bloccoArena *primo;
+    struct bloccoArena *attuale;
+    size_t allocati;        // Byte presi con malloc, i blocchi non vengono mai liberati
 };
 
 /* Dichiarazione funzioni */
 void aggiungiFile();
-struct Links *inserisciConnessione(struct Links *l, struct connessione connessione);
-struct llTabella *inizializzaTabella(struct llTabella *tabella, char start[15]);
-struct priority *inserisciPriority(struct priority *p, char nodo[15], int valore);
-struct priority *rimuoviPriority(struct priority *p, char nodo[15]);
-struct llTabella *sostituisciTabella(struct llTabella *t, struct entry e);
-int costoRouterPrecedente(struct llTabella *tabella, char nodo[10]);
-bool containsPriority(struct priority *p, char nodo[10]);
-bool containsTabella(struct llTabella *t, char nodo[10]);
-bool contieneContrario(struct Links *l, struct connessione conn);
+bool caricaFile(const char *nomeFile);
+void leggiABlocchi(struct letturaFile *l, int fd);
+const char *analizzaBlocco(struct letturaFile *l, const char *inizio, const char *fine, bool ultimo);
+void analizzaRiga(struct letturaFile *l, const char *inizio, const char *fine);
+void analizzaCoordinate(struct letturaFile *l, const char *inizio, const char *fine);
+void rigaErrata(struct letturaFile *l);
+void fineLettura(struct letturaFile *l);
+int internaNome(const char *nome);
+int internaNomeLungo(const char *nome, size_t lunghezza);
+int cercaNome(const char *nome);
+int cercaNomeIn(const struct tabellaNomi *t, const char *nome);
+const char *nomeIn(const struct tabellaNomi *t, int id);
+const char *nomeNodo(int id);
+char *leggiParola();
+void inserisciArco(int partenza, int arrivo, int costo);
+bool rimuoviArco(int partenza, int arrivo, int *costo);
+void compattaArchi();
+bool modificaCostoArco(int partenza, int arrivo, int costo, int *vecchioCosto);
+const struct csr *aggiornaCSR();
+const struct csr *aggiornaCSRCompatto();
+const struct csr *aggiornaEntrate();
+bool aggiungiArcoCSR(int partenza, int arrivo, int costo);
+bool togliArcoCSR(int partenza, int arrivo, int costo);
+bool cambiaCostoCSR(int partenza, int arrivo, int vecchioCosto, int nuovoCosto);
+void allargaCostiEstremi(struct csr *g, int costo);
+struct llTabella *inizializzaTabella(struct llTabella *tabella, int start);
+void liberaTabella();
+void creaHeap(struct heap *h, int numNodi, struct arena *a);
+void liberaHeap(struct heap *h);
+void inserisciHeap(struct heap *h, int nodo, int valore);
+int estraiMinimo(struct heap *h);
+void creaStato(struct statoTabella *s, int numNodi);
+void creaStatoArena(struct statoTabella *s, int numNodi, struct arena *a);
+void *allocaArena(struct arena *a, size_t n);
+void resetArena(struct arena *a);
+void *allocaMemoria(struct arena *a, size_t n);
+long leggiMemoriaProcesso(const char *campo);
+void stampaMemoria();
+void liberaStato(struct statoTabella *s);
+void calcolaTabella(const struct csr *g, int start, struct statoTabella *s);
+void creaStatoMultiplo(struct statoMultiplo *m, int numNodi);
+void liberaStatoMultiplo(struct statoMultiplo *m);
+void calcolaTabelleMultiple(const struct csr *g, const int *sorgenti, int numSorgenti, struct statoMultiplo *m, struct statoTabella *stati);
+bool usaMatrice(const struct csr *g, int numSorgenti);
+void creaMatrice(struct matriceFW *m, const struct csr *g);
+void liberaMatrice(struct matriceFW *m);
+void aggiornaBloccoFW(struct matriceFW *m, int bi, int bj, int bk);
+void *threadFW(void *argomento);
+void calcolaMatrice(struct matriceFW *m, const struct csr *g, int numThread);
+void tabellaDaMatrice(const struct matriceFW *m, int start, struct statoTabella *s);
+void aggiornaCostiEstremi(struct csr *g);
+int tipoCoda(const struct csr *g);
+const char *nomeCoda(int tipo);
+void preparaBucket(struct statoTabella *s, int tipo, const struct csr *g);
+void collegaBucket(struct statoTabella *s, int nodo, int b);
+void scollegaBucket(struct statoTabella *s, int nodo);
+int indiceBucket(const struct statoTabella *s, int tipo, int valore);
+void inserisciBucket(struct statoTabella *s, int tipo, int nodo);
+int estraiBucket(struct statoTabella *s, int tipo);
+bool contieneContrario(int partenza, int arrivo);
+int contaArco(int partenza, int arrivo);
+void aggiungiArcoInsieme(int posizione);
+void togliArcoInsieme(int posizione);
+int primoArco(int partenza, int arrivo);
+void ricostruisciInsiemeArchi();
 void mostraTabella();
 int menu();
-bool containsStart(char start[15]);
+bool containsStart(int start);
 void aggiuntaConnessione();
 bool rimuoviConnessione();
 void mostraNodi();
-const char * getNextHop(struct llTabella *t, char dest[15]);
+double secondi();
+int benchHeap(int numFile, char **file);
+unsigned long long numeroCasuale(unsigned long long *seme);
+int casualeTra(unsigned long long *seme, int minimo, int massimo);
+void scriviLink(struct buffer *b, char prefissoA, int a, char prefissoB, int c, int costo);
+void svuotaBuffer(struct buffer *b, FILE *fl, bool sempre);
+bool generaTopologia(FILE *fl, const char *tipo, int n, int grado, unsigned long long seme, bool coordinate);
+int modalitaGenera(int argc, char **argv);
+int confrontaTempi(const void *a, const void *b);
+bool misuraTopologia(int numFile, char **file, int campioni, int numThread);
+int modalitaBench(int argc, char **argv, bool suite);
+void riservaBuffer(struct buffer *b, size_t n);
+void aggiungiStringa(struct buffer *b, const char *stringa);
+void aggiungiIntero(struct buffer *b, int n);
+void scriviTabella(struct buffer *b, int start, const struct statoTabella *s);
+void scriviRighe(struct buffer *b, const struct tabellaNomi *t, const struct statoTabella *s);
+void calcolaTabelleParallelo(const int *sorgenti, int numSorgenti, int numThread, FILE *output);
+int modalitaBatch(int argc, char **argv);
+void raccogliFrontiera(struct deltaStepping *d, struct listaNodi *liste, int passo, bool filtra);
+bool abbassaEtichetta(unsigned long long *etichetta, unsigned long long nuova);
+void prossimaFrontiera(struct deltaStepping *d);
+void rilassaFrontiera(struct deltaStepping *d, int t, long long *rilassati, long long *aggiornamenti);
+void *threadDelta(void *argomento);
+int deltaAutomatico(const struct csr *g);
+void calcolaTabellaDelta(const struct csr *g, int start, struct statoTabella *s, int numThread, int delta);
+void calcolaTabellaSingola(const struct csr *g, int start, struct statoTabella *s);
+int confrontaTabelle(const struct csr *g, int start, const struct statoTabella *a, const struct statoTabella *b, int *alternativi);
+int modalitaDelta(int argc, char **argv);
+bool salvaSnapshot(const char *nomeFile);
+bool caricaSnapshot(const char *nomeFile);
+void staccaSnapshot();
+int compilaSnapshot(int argc, char **argv);
+struct llTabella *tabellaDaStato(const struct statoTabella *s);
+void allargaStato(struct statoTabella *s, int numNodi);
+struct alberoSPF *creaAlbero(int start);
+void ricalcolaAlbero(struct alberoSPF *a);
+void liberaAlbero(struct alberoSPF *a);
+struct alberoSPF *alberoPerSorgente(int start);
+void eliminaAlbero(struct alberoSPF *a);
+void mostraStatisticheCache();
+int propagaAlbero(const struct csr *g, struct alberoSPF *a);
+void propagaSottoalbero(const struct csr *g, struct alberoSPF *a);
+int riparaDiminuzione(const struct csr *g, struct alberoSPF *a, int partenza, int arrivo, int costo);
+int riparaAumento(const struct csr *g, struct alberoSPF *a, int partenza, int arrivo, int vecchioCosto);
+int aggiornaAlberi(int partenza, int arrivo, int vecchioCosto, int nuovoCosto);
+void stampaAggiornamento(int toccati);
+void modificaCosto();
+void sommaStatistiche(struct statisticheSPF *dest, const struct statisticheSPF *src);
+void contaAllocazione(size_t n);
+void stampaStringaJSON(FILE *fl, const char *stringa);
+void stampaStatistiche(FILE *fl, const char *sorgente, const struct statisticheSPF *st);
+void impostaCoordinate(int nodo, double x, double y);
+bool aggiornaScala();
+int stimaCosto(int nodo, int arrivo);
+int potenziale(int nodo, int partenza, int arrivo);
+void azzeraRicerca(struct statoTabella *s, int numNodi);
+void raggiungiNodo(struct statoTabella *s, int nodo, int costo, int precedente, int priorita);
+int cercaPercorso(int partenza, int arrivo, int **percorso, int *numHop, int *estratti);
+void stampaPercorso(int partenza, int arrivo, int costo, const int *percorso, int numHop, int estratti, const char *metodo);
+void mostraPercorso();
+int modalitaPercorso(int argc, char **argv);
+void aggiungiArcoCH(struct archiCH *l, int vicino, int costo, int mezzo);
+void togliArcoCH(struct archiCH *l, int vicino);
+void ricercaTestimone(struct costruzioneCH *c, int u, int v, int limiteCosto, int limiteNodi, int numObiettivi);
+int contraiNodo(struct costruzioneCH *c, int v, bool simula);
+int prioritaCH(struct costruzioneCH *c, int v);
+void cambiaPriorita(struct heap *h, int nodo, int valore);
+void compattaArchiCH(struct archiCH *liste, int numNodi, int **offset, int **vicino, int **costo, int **mezzo);
+void liberaGerarchia(struct gerarchia *ch);
+void costruisciGerarchia();
+unsigned long long improntaTopologia();
+void sezioniGerarchia(struct gerarchia *ch, int ***array, size_t *numeri);
+bool salvaGerarchia(const char *nomeFile);
+bool caricaGerarchia(const char *nomeFile);
+const struct gerarchia *aggiornaGerarchia();
+void aggiungiNodoLista(struct listaNodi *l, int nodo);
+void espandiArco(const struct gerarchia *ch, int u, int w, int mezzo, struct listaNodi *percorso);
+bool nodoBloccato(const struct statoTabella *s, int nodo, const int *offset, const int *vicino, const int *costo);
+int cercaPercorsoGerarchia(const struct gerarchia *ch, int partenza, int arrivo, int **percorso, int *numHop, int *estratti);
+int trovaPercorso(int partenza, int arrivo, int **percorso, int *numHop, int *estratti, const char **metodo);
+int benchPercorsi(int argc, char **argv);
+void inserisciArcoArea(int partenza, int arrivo, int costo, int area);
+int areaComune(int partenza, int arrivo);
+void segnaArea(int area);
+void ricostruisciArea(struct area *a, const int *archi, int numArchi, int *locale);
+void calcolaSommari(struct area *a);
+const struct reteAree *aggiornaAree();
+void preparaStatoAree(struct statoAree *sa, const struct reteAree *r);
+void liberaStatoAree(struct statoAree *sa);
+void calcolaTabellaAree(const struct reteAree *r, int start, struct statoAree *sa, struct statoTabella *s);
+int benchAree(int argc, char **argv);
+void mostraVicini();
+void segnaFib(int sorgente, int nodo);
+void segnaFibTutto(int sorgente);
+void allargaFib(struct fibSorgente *f, int numNodi);
+void scriviRigaDelta(struct buffer *b, int tipo, int destinazione, int nextHop, int costo);
+long long scriviDeltaFib();
+void rinumeraFib(const int *nuovo);
+int modalitaDeltaFib(int argc, char **argv);
+int bitNecessari(unsigned long long valore);
+unsigned long long leggiCampo(const unsigned long long *parole, unsigned long long posizione, int bit);
+void scriviCampo(unsigned long long *parole, unsigned long long posizione, int bit, unsigned long long valore);
+void *threadFibCompatta(void *argomento);
+void restringiCosti(struct fibCompatta *f, long long costoMinimo, long long costoMassimo);
+bool costruisciFibCompatta(const char *nomeFile, bool costi, int numThread);
+bool apriFibCompatta(const char *nomeFile, bool costi);
+void chiudiFibCompatta();
+int cercaFibCompatta(const struct fibCompatta *f, int sorgente, int destinazione, int *costo);
+int modalitaFibCompatta(int argc, char **argv);
+bool arcoGuasto(const struct guasto *gu, int partenza, int arrivo);
+int valutaGuasto(const struct csr *g, const struct alberoSPF *a, struct guasto *gu, struct vistaGuasto *v);
+void *threadResilienza(void *argomento);
+int leggiGuasti(const char *nomeFile, struct guasto **guasti);
+int tuttiLink(const struct csr *g, struct guasto **guasti);
+void scriviGuasto(struct buffer *b, const struct guasto *gu);
+int modalitaResilienza(int argc, char **argv);
+void azzeraStatoLimitato(struct statoLimitato *s);
+void liberaStatoLimitato(struct statoLimitato *s);
+int indiceLimitato(struct statoLimitato *s, int nodo);
+void calcolaTabellaLimitata(const struct csr *g, int start, const struct limitiRicerca *limiti, struct statoLimitato *s);
+void scriviRigheLimitate(struct buffer *b, const struct tabellaNomi *t, const struct statoLimitato *s);
+int modalitaVicini(int argc, char **argv);
+int tipoOrdine(const char *nome);
+const char *nomeOrdine(int tipo);
+int confrontaChiavi(const void *a, const void *b);
+void visitaOrdine(const struct csr *g, int partenza, bool perGrado, bool *visitato, int *ordine, int *numOrdinati, unsigned long long *chiavi);
+void calcolaOrdine(const struct csr *g, int tipo, int *ordine);
+int confrontaArchi(const void *a, const void *b);
+void rinumeraNodi(const int *ordine);
+void riordinaRete(int tipo);
+double distanzaMediaArchi(const struct csr *g);
+int apriContatore(unsigned int tipo, unsigned long long config);
+long long leggiContatore(int fd);
+int benchOrdine(int argc, char **argv);
+struct tabellaNomi *copiaNomi();
+void pubblicaVersione();
+void liberaVersione(struct versioneRete *v);
+void liberaVersioniRitirate();
+const struct versioneRete *entraLettura(int lettore);
+void esciLettura(int lettore);
+void cambiaAccesso(struct lavoratoreServer *l, int accesso);
+bool eseguiRichiesta(struct lavoratoreServer *l, char *riga);
+void serviConnessione(struct lavoratoreServer *l, int fd);
+bool spedisciTutto(int fd, const char *dati, size_t dimensione);
+void *threadServer(void *argomento);
+void chiudiServer(int segnale);
+int modalitaServer(int argc, char **argv);
 
+/* Nomi dei router presenti nella rete */
+struct tabellaNomi nomi;
 /* Rapresentazione di un database con le connessioni di rete (topologia) */
-struct Links *links;
+struct grafo rete = {.primoLibero = -1};
+/* Memoria delle tabelle restituite da inizializzaTabella e tabellaDaStato,
+   liberata tutta insieme da liberaTabella */
+struct arena arenaTabelle;
+/* Memoria temporanea di ogni costruzione di una tabella */
+struct arena arenaScratch;
+/* Statistiche di Dijkstra di tutto il programma, formatoStatistiche le
+   attiva e sceglie come stamparle */
+struct statisticheSPF statistiche;
+int formatoStatistiche = STATISTICHE_SPENTE;
+/* Coda usata da calcolaTabella, -1 per sceglierla in base ai costi (tipoCoda) */
+int codaForzata = -1;
+pthread_mutex_t mutexStatistiche = PTHREAD_MUTEX_INITIALIZER;
+/* Thread per il calcolo di una singola tabella con il delta-stepping, usati
+   solo con almeno SOGLIA_DELTA nodi (1 = sempre Dijkstra sequenziale) */
+int threadTabella = 1;
+/* Sorgenti calcolate insieme da ogni thread della modalità batch */
+int corsieBatch = NUM_CORSIE;
+/* Calcolo di tutte le tabelle con Floyd-Warshall: MATRICE_AUTO lo sceglie
+   in base alla densità della rete (usaMatrice) */
+int sceltaMatrice = MATRICE_AUTO;
+/* Coordinate dei router e stati delle ricerche di un percorso, riusati tra
+   una ricerca e l'altra */
+struct coordinate posizioni;
+struct statoTabella ricercaAvanti, ricercaIndietro;
+/* Gerarchia di contrazione per i percorsi, usata solo se usaGerarchia è
+   true; fileGerarchia è il file da cui caricarla e in cui salvarla */
+struct gerarchia gerarchia;
+bool usaGerarchia = false;
+const char *fileGerarchia = NULL;
+/* Snapshot binario da cui è stata caricata la topologia */
+struct snapshot mappa;
+/* Alberi dei cammini minimi già calcolati */
+struct cacheAlberi cache = {NULL, 0, NULL, NULL, 0, 0, (size_t)BUDGET_CACHE_MB << 20, 0, 0, 0, 0, NULL, 0};
+/* Aumenta ad ogni modifica della topologia, invalida gli alberi in cache */
+unsigned long long generazioneTopologia;
+/* Delta delle tabelle, con --fib nel menu e in --delta-fib */
+struct statoFib fib;
+/* Tabelle compatte di tutti i router aperte con --fib-compatta */
+struct fibCompatta fibCompatta;
+/* Aree della rete per l'SPF a aree, costruite da aggiornaAree */
+struct reteAree aree;
+struct statoAree statoAreeMenu;
+/* Rinumerazione dei router applicata dopo il caricamento (riordinaRete) */
+int ordineNodi = ORDINE_NESSUNO;
+/* Versioni della rete pubblicate per i thread del server */
+struct epocheRete epoche = {1, NULL, 0, NULL, NULL};
+/* Preso da chi modifica la rete e dalle ricerche dei percorsi, che usano
+   ricercaAvanti/ricercaIndietro e la rete globale */
+pthread_mutex_t mutexScrittura = PTHREAD_MUTEX_INITIALIZER;
+/* Percorso del socket del server, rimosso all'uscita */
+const char *socketServer = NULL;
 
 int main(int argc, char** argv) {
     int scelta;
-    struct Links *t;
+
+    /* Micro-benchmark della priority queue: ./dijkstra --bench-heap rete.txt ... */
+    if(argc > 2 && strcmp(argv[1], "--bench-heap") == 0)
+        return benchHeap(argc - 2, argv + 2);
+    /* Generatore di topologie: ./dijkstra --genera griglia 10000 ... */
+    if(argc > 3 && strcmp(argv[1], "--genera") == 0)
+        return modalitaGenera(argc - 2, argv + 2);
+    /* Benchmark: ./dijkstra --bench rete.txt ... oppure --bench-suite [nodi] */
+    if(argc > 2 && strcmp(argv[1], "--bench") == 0)
+        return modalitaBench(argc - 2, argv + 2, false);
+    if(argc > 1 && strcmp(argv[1], "--bench-suite") == 0)
+        return modalitaBench(argc - 2, argv + 2, true);
+    /* Tabelle di tutti i router senza menu: ./dijkstra --batch rete.txt ... */
+    if(argc > 1 && strcmp(argv[1], "--batch") == 0)
+        return modalitaBatch(argc - 2, argv + 2);
+    /* Dijkstra contro delta-stepping parallelo: ./dijkstra --delta [-j thread] rete.txt ... */
+    if(argc > 2 && strcmp(argv[1], "--delta") == 0)
+        return modalitaDelta(argc - 2, argv + 2);
+    /* Percorso tra due router: ./dijkstra --percorso R1 R2 rete.txt ... */
+    if(argc > 3 && strcmp(argv[1], "--percorso") == 0)
+        return modalitaPercorso(argc - 2, argv + 2);
+    /* Confronto dei metodi per i percorsi: ./dijkstra --bench-percorsi rete.txt ... */
+    if(argc > 2 && strcmp(argv[1], "--bench-percorsi") == 0)
+        return benchPercorsi(argc - 2, argv + 2);
+    /* Server di richieste su socket Unix: ./dijkstra --server rete.sock rete.txt ... */
+    if(argc > 2 && strcmp(argv[1], "--server") == 0)
+        return modalitaServer(argc - 2, argv + 2);
+    /* Confronto delle rinumerazioni dei router: ./dijkstra --bench-ordine rete.txt ... */
+    if(argc > 2 && strcmp(argv[1], "--bench-ordine") == 0)
+        return benchOrdine(argc - 2, argv + 2);
+    /* Tabella parziale dei router vicini: ./dijkstra --vicini R -c 20 rete.txt ... */
+    if(argc > 3 && strcmp(argv[1], "--vicini") == 0)
+        return modalitaVicini(argc - 2, argv + 2);
+    /* Delta delle tabelle dopo ogni gruppo di modifiche: ./dijkstra --delta-fib rete.txt ... < modifiche */
+    if(argc > 2 && strcmp(argv[1], "--delta-fib") == 0)
+        return modalitaDeltaFib(argc - 2, argv + 2);
+    /* Tabelle compatte di tutti i router: ./dijkstra --fib-compatta rete.fib rete.txt ... < richieste */
+    if(argc > 3 && strcmp(argv[1], "--fib-compatta") == 0)
+        return modalitaFibCompatta(argc - 2, argv + 2);
+    /* Effetto dei guasti di link e router: ./dijkstra --resilienza [-f guasti.txt] rete.txt ... */
+    if(argc > 2 && strcmp(argv[1], "--resilienza") == 0)
+        return modalitaResilienza(argc - 2, argv + 2);
+    /* Confronto tra SPF a aree e Dijkstra: ./dijkstra --bench-aree rete.txt ... */
+    if(argc > 2 && strcmp(argv[1], "--bench-aree") == 0)
+        return benchAree(argc - 2, argv + 2);
+    /* Creazione di uno snapshot binario: ./dijkstra --compila rete.snap rete.txt ... */
+    if(argc > 2 && strcmp(argv[1], "--compila") == 0)
+        return compilaSnapshot(argc - 2, argv + 2);
+    /* Opzioni del menu: --snapshot rete.snap per partire da uno snapshot,
+       --cache-mb N per il limite di memoria della cache delle tabelle,
+       --statistiche testo|json per attivare i contatori di Dijkstra,
+       --gerarchia file per cercare i percorsi con la gerarchia di contrazione,
+       --thread N per calcolare le tabelle delle reti grandi con il delta-stepping,
+       --ordine bfs|rcm|grado per rinumerare i router dopo ogni caricamento,
+       --fib file (o --fib-binario file) per scrivere i delta delle tabelle di
+       tutti i router dopo ogni modifica */
+    for(scelta = 1; scelta + 1 < argc; scelta += 2) {
+        if(strcmp(argv[scelta], "--snapshot") == 0 && !caricaSnapshot(argv[scelta + 1])) {
+            fprintf(stderr, "Impossibile caricare lo snapshot %s\n", argv[scelta + 1]);
+            return (EXIT_FAILURE);
+        }
+        if(strcmp(argv[scelta], "--cache-mb") == 0)
+            cache.budget = (size_t)atoi(argv[scelta + 1]) << 20;
+        if(strcmp(argv[scelta], "--gerarchia") == 0) {
+            usaGerarchia = true;
+            fileGerarchia = argv[scelta + 1];
+        }
+        if(strcmp(argv[scelta], "--thread") == 0)
+            threadTabella = atoi(argv[scelta + 1]);
+        if(strcmp(argv[scelta], "--ordine") == 0 && tipoOrdine(argv[scelta + 1]) >= 0)
+            ordineNodi = tipoOrdine(argv[scelta + 1]);
+        if(strcmp(argv[scelta], "--statistiche") == 0)
+            formatoStatistiche = strcmp(argv[scelta + 1], "json") == 0 ? STATISTICHE_JSON : STATISTICHE_TESTO;
+        if(strcmp(argv[scelta], "--fib") == 0 || strcmp(argv[scelta], "--fib-binario") == 0) {
+            fib.output = fopen(argv[scelta + 1], "wb");
+            if(fib.output == NULL) {
+                fprintf(stderr, "Impossibile creare il file %s\n", argv[scelta + 1]);
+                return (EXIT_FAILURE);
+            }
+            fib.attiva = true;
+            fib.formato = strcmp(argv[scelta], "--fib") == 0 ? FIB_TESTO : FIB_BINARIO;
+        }
+    }
+    riordinaRete(ordineNodi);
+    /* Le prime tabelle vengono scritte per intero, come aggiunte */
+    if(fib.attiva && nomi.numNomi > 0)
+        scriviDeltaFib();
 
     printf("Algoritmo di Dijkstra\nCon gestione dinamica della topologia di rete");
     do{
@@ -101,8 +1118,21 @@ int main(int argc, char** argv) {
                 break;
             case 5: rimuoviConnessione();
                 break;
+            case 6: modificaCosto();
+                break;
+            case 7: mostraStatisticheCache();
+                break;
+            case 8: mostraPercorso();
+                break;
+            case 9: mostraVicini();
+                break;
         }
-    }while(scelta != 6);
+        /* Dopo ogni modifica della rete i delta di tutte le tabelle */
+        if(fib.attiva && (scelta == 1 || scelta == 4 || scelta == 5 || scelta == 6))
+            scriviDeltaFib();
+    }while(scelta != 10);
+    if(fib.attiva)
+        fclose(fib.output);
 
     return (EXIT_SUCCESS);
 }
@@ -122,16 +1152,21 @@ int menu() {
     printf("\n3) Visualizza tabella di un nodo;");
     printf("\n4) Aggiungi una nuova connessione alla rete;");
     printf("\n5) Rimuovi una connessione dalla rete;");
-    printf("\n6) Esci.\nInserisci scelta: ");
+    printf("\n6) Modifica il costo di una connessione;");
+    printf("\n7) Visualizza statistiche della cache e della memoria;");
+    printf("\n8) Cerca il percorso tra due router;");
+    printf("\n9) Visualizza i router vicini ad un nodo;");
+    printf("\n10) Esci.\nInserisci scelta: ");
     do{
-        scanf("%d", &scelta);
+        if(scanf("%d", &scelta) != 1)
+            exit(EXIT_SUCCESS);
         controllo = true;
         /* Controllo che il database delle connessioni non sia vuoto */
-        if((scelta == 2 || scelta == 5) && links == NULL) {
+        if((scelta == 2 || scelta == 5 || scelta == 6 || scelta == 8 || scelta == 9) && aggiornaCSR()->numArchi == rete.numBuchi) {
             printf("Nessuna entry ancora presente, reinserire scelta: ");
             controllo = false;
         }
-        else if(scelta < 1 || scelta > 6) {
+        else if(scelta < 1 || scelta > 10) {
             printf("Scelta non valida, reinserire: ");
             controllo = false;
         }
@@ -141,15 +1176,34 @@ int menu() {
     return scelta;
 }
 
+/*
+ * Funzione per confrontare due nodi in base al nome, usata da qsort
+ */
+int confrontaNomi(const void *a, const void *b) {
+    return strcmp(nomeNodo(*(const int *)a), nomeNodo(*(const int *)b));
+}
+
+/*
+ * Funzione che stampa tutte le connessioni della rete, in ordine alfabetico
+ * in base al router di partenza
+ */
 void mostraNodi() {
-  struct Links *stampaLinks = links;
+  const struct csr *g = aggiornaCSRCompatto();
+  int *ordine = (int *)malloc(g->numNodi * sizeof(int));
+  int i, j;
+
+  for(i = 0; i < g->numNodi; i++)
+    ordine[i] = i;
+  qsort(ordine, g->numNodi, sizeof(int), confrontaNomi);
   printf("Nodi:\n");
-  while (stampaLinks != NULL) {
-    printf("%s; ", stampaLinks->connessione.routerPartenza);
-    printf("%s; ", stampaLinks->connessione.routerArrivo);
-    printf("%d.\n", stampaLinks->connessione.costoLink);
-    stampaLinks = stampaLinks->next;
+  for(i = 0; i < g->numNodi; i++) {
+    for(j = g->offset[ordine[i]]; j < g->offset[ordine[i] + 1]; j++) {
+      printf("%s; ", nomeNodo(ordine[i]));
+      printf("%s; ", nomeNodo(g->arrivo[j]));
+      printf("%d.\n", g->costo[j]);
+    }
   }
+  free(ordine);
   printf("\nNextHop; destinazione; costo");
   printf("\n\nPremi invio per continuare...\n");
   getchar();
@@ -161,29 +1215,47 @@ void mostraNodi() {
  */
 void mostraTabella() {
     struct llTabella *tabella = NULL;
-    char start[15];
+    struct alberoSPF *albero;
+    double inizio;
+    char *nome;
+    int start;
     bool controllo = true;
 
     /* Inserimento e controllo del nodo di partenza */
     printf("Inserisci nodo di partenza: ");
     do{
-        scanf("%s", start);
+        nome = leggiParola();
+        if(nome == NULL)
+            exit(EXIT_SUCCESS);
+        start = cercaNome(nome);
+        free(nome);
         controllo = true;
-        if(!containsStart(start)) {
+        if(start < 0 || !containsStart(start)) {
             printf("Nodo non esistente, reinserire: ");
             controllo = false;
         }
     }while(!controllo);
-    /* Riempimento tabella */
-    tabella = inizializzaTabella(tabella, start);
+    /* Riempimento tabella, l'albero della sorgente resta in cache e viene
+       aggiornato ad ogni modifica della rete */
+    albero = alberoPerSorgente(start);
+    inizio = secondi();
+    tabella = tabellaDaStato(&albero->stato);
     /* Stampa tabella */
-    printf("\nTabella di %s:\n", start);
+    printf("\nTabella di %s:\n", nomeNodo(start));
     while(tabella != NULL) {
-        printf("%s; %s;", tabella->riga.nextHop, tabella->riga.destinazione);
+        printf("%s; %s;", nomeNodo(tabella->riga.nextHop), nomeNodo(tabella->riga.destinazione));
         printf(" %d\n", tabella->riga.costo);
         tabella = tabella->next;
     }
+    liberaTabella();
     printf("\nNextHop; destinazione; costo");
+    if(formatoStatistiche != STATISTICHE_SPENTE) {
+        /* I contatori sono quelli dell'ultimo calcolo completo dell'albero */
+        printf("\n");
+        albero->stato.contatori.stampa = secondi() - inizio;
+        statistiche.stampa += albero->stato.contatori.stampa;
+        stampaStatistiche(stdout, nomeNodo(start), &albero->stato.contatori);
+    }
     printf("\n\nPremi invio per continuare...\n");
     getchar();
     getchar();
@@ -194,39 +1266,41 @@ void mostraTabella() {
  * dall'utente.
  */
 void aggiuntaConnessione() {
-    struct connessione connessione;
-    char temp[15];
-    struct Links *tempLink = links;
-    bool aggiungi = true;
+    char *partenza, *arrivo;
+    int idPartenza, idArrivo, costo, toccati;
 
     printf("Creazione di una nuova connessione: \n");
     /* Creazione dati link */
     printf("Inserisci nodo di partenza: ");
-    scanf("%s", connessione.routerPartenza);
+    partenza = leggiParola();
     printf("Inserisci nodo di arrivo: ");
-    scanf("%s", connessione.routerArrivo);
+    arrivo = leggiParola();
     printf("Inserisci costo link: ");
-    scanf("%d", &connessione.costoLink);
-    /* Controllo che il link non sia già esistente*/
-    while(tempLink != NULL) {
-        if(strcmp(tempLink->connessione.routerPartenza, connessione.routerPartenza) == 0
-            && strcmp(tempLink->connessione.routerArrivo, connessione.routerArrivo) == 0
-            && tempLink->connessione.costoLink == connessione.costoLink) {
-            aggiungi = false;
-            printf("\nConnessione già esistente!\n");
-            break;
-        }
-        tempLink = tempLink->next;
+    if(partenza == NULL || arrivo == NULL || scanf("%d", &costo) != 1)
+        exit(EXIT_SUCCESS);
+    if(costo < 0) {
+        free(partenza);
+        free(arrivo);
+        printf("\nIl costo non può essere negativo!\n");
+        return;
     }
-    /* Inserimento del link e del suo contrario */
-    if(aggiungi) {
-        links = inserisciConnessione(links, connessione);
-        strcpy(temp, connessione.routerPartenza);
-        strcpy(connessione.routerPartenza, connessione.routerArrivo);
-        strcpy(connessione.routerArrivo, temp);
-        links = inserisciConnessione(links, connessione);
-        printf("\nConnessione aggiunta con successo!\n");
+    idPartenza = internaNome(partenza);
+    idArrivo = internaNome(arrivo);
+    free(partenza);
+    free(arrivo);
+    /* Controllo che il link non sia già esistente con l'insieme degli archi
+       presenti, come nel server */
+    if(contaArco(idPartenza, idArrivo) > 0) {
+        printf("\nConnessione già esistente!\n");
+        return;
     }
+    /* Inserimento del link e del suo contrario */
+    inserisciArco(idPartenza, idArrivo, costo);
+    toccati = aggiornaAlberi(idPartenza, idArrivo, INT_MAX, costo);
+    inserisciArco(idArrivo, idPartenza, costo);
+    toccati += aggiornaAlberi(idArrivo, idPartenza, INT_MAX, costo);
+    printf("\nConnessione aggiunta con successo!\n");
+    stampaAggiornamento(toccati);
 }
 
 /*
@@ -235,394 +1309,7742 @@ void aggiuntaConnessione() {
  * @param start nodo di partenze
  * @return true se il nodo esiste, false altrimenti
  */
-bool containsStart(char start[15]) {
-    struct Links *temp = links;
+bool containsStart(int start) {
+    const struct csr *g = aggiornaCSR();
 
-    while(temp != NULL) {
-        if(strcmp(temp->connessione.routerPartenza, start) == 0)
-            return true;
-        temp = temp->next;
-    }
-    return false;
+    /* I buchi della riga non sono link */
+    return g->offset[start + 1] - g->offset[start] > (rete.buchi != NULL ? rete.buchi[start] : 0);
 }
 
 /*
  * Aggiunta dati alla Linked list che rappresenta il database delle connessioni.
  * I nuovi dati vengono presi da file in questo caso.
- * Non c'è nessun controllo per l'esistenza di un file.
  */
 void aggiungiFile() {
-    char buffer[34], dati[3][15];
-    struct connessione connessione;
-    int i, y, fine;
-    FILE *fl;
-    char nomeFile[30];
-    char temp[15];
+    char *nomeFile;
 
-    /* Nessun controllo per l'esistenza di un file */
     printf("Inserisci nome file: ");
-    scanf("%s", nomeFile);
+    nomeFile = leggiParola();
+    if(nomeFile == NULL)
+        exit(EXIT_SUCCESS);
     printf("\nAggiunta file....");
-    fl = fopen(nomeFile, "r");
-    /* Scorrimento file e inizializzazione lista dei link */
-    while(fgets(buffer, 34, fl) != NULL) {
-        y = 0;
-        fine = 0;
-        i = 0;
-        while(buffer[i] != '\0') {
-            if(buffer[i] != ';')
-                dati[y][i - fine] = buffer[i];
-            else {
-                dati[y][i - fine] = '\0';
-                y++;
-                fine = i + 1;
-            }
-            i++;
+    if(caricaFile(nomeFile)) {
+        riordinaRete(ordineNodi);
+        printf("\nFile aggiunto con successo!");
+    }
+    else
+        printf("\nImpossibile aprire il file %s!", nomeFile);
+    free(nomeFile);
+}
+
+/*
+ * Funzione che legge un file con la topologia e aggiunge le sue connessioni
+ * alla rete. Il file viene mappato in memoria con mmap e analizzato sul
+ * posto, se mmap non è disponibile viene letto a blocchi grandi.
+ *
+ * @param nomeFile percorso del file
+ * @return false se il file non può essere aperto
+ */
+bool caricaFile(const char *nomeFile) {
+    struct letturaFile lettura = {nomeFile, 0, 0};
+    struct stat info;
+    char *dati;
+    int fd;
+    double inizio = secondi();
+
+    fd = open(nomeFile, O_RDONLY);
+    if(fd < 0)
+        return false;
+    if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        dati = (char *)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(dati != MAP_FAILED) {
+            madvise(dati, info.st_size, MADV_SEQUENTIAL);
+            analizzaBlocco(&lettura, dati, dati + info.st_size, true);
+            munmap(dati, info.st_size);
+            close(fd);
+            fineLettura(&lettura);
+            statistiche.caricamento += secondi() - inizio;
+            return true;
         }
-        strcpy(connessione.routerPartenza, dati[0]);
-        strcpy(connessione.routerArrivo, dati[1]);
-        connessione.costoLink = atoi(dati[2]);
+    }
+    leggiABlocchi(&lettura, fd);
+    close(fd);
+    fineLettura(&lettura);
+    statistiche.caricamento += secondi() - inizio;
+    return true;
+}
+
+/*
+ * Funzione che legge un file a blocchi da 1 MB, usata quando non si può
+ * usare mmap (file vuoti, pipe, ...). La riga spezzata alla fine di un
+ * blocco viene spostata all'inizio del buffer e completata col blocco dopo.
+ *
+ * @param l stato della lettura
+ * @param fd file descriptor aperto in lettura
+ */
+void leggiABlocchi(struct letturaFile *l, int fd) {
+    size_t capacita = 1 << 20, usati = 0;
+    char *buffer = (char *)malloc(capacita);
+    const char *resto;
+    ssize_t letti;
 
-        /* Controllo che la connessione non sia già esistente, necessario se
-          vengono aggiunti 2 file che hanno anche connessioni comuni */
-        if(!contieneContrario(links, connessione)) {
-            links = inserisciConnessione(links, connessione);
-            /* Le prossime righe permettono di salvare le connessioni in modo bilaterale
-             (se esiste A;B;3 esiste anche B;A;3) in modo da far funzionare la creazione
-             della tabella senza errori e inoltre permette di dimezzare la lunghezza dei
-             file in quanto ogni connessione può essere scritta una sola volta */
-            strcpy(temp, connessione.routerPartenza);
-            strcpy(connessione.routerPartenza, connessione.routerArrivo);
-            strcpy(connessione.routerArrivo, temp);
-            links = inserisciConnessione(links, connessione);
+    for(;;) {
+        /* Se una sola riga riempie il buffer il buffer viene raddoppiato */
+        if(usati == capacita) {
+            capacita *= 2;
+            buffer = (char *)realloc(buffer, capacita);
         }
+        letti = read(fd, buffer + usati, capacita - usati);
+        if(letti <= 0)
+            break;
+        usati += letti;
+        resto = analizzaBlocco(l, buffer, buffer + usati, false);
+        usati -= resto - buffer;
+        memmove(buffer, resto, usati);
     }
-    fclose(fl);
-    printf("\nFile aggiunto con successo!");
+    analizzaBlocco(l, buffer, buffer + usati, true);
+    free(buffer);
+}
+
+/*
+ * Funzione che analizza tutte le righe complete di un blocco del file.
+ *
+ * @param l stato della lettura
+ * @param inizio inizio del blocco
+ * @param fine fine del blocco (esclusa)
+ * @param ultimo true se dopo il blocco il file è finito, in questo caso
+ *               anche l'ultima riga senza '\n' viene analizzata
+ * @return inizio della prima riga non ancora analizzata
+ */
+const char *analizzaBlocco(struct letturaFile *l, const char *inizio, const char *fine, bool ultimo) {
+    const char *a_capo;
+
+    while(inizio < fine) {
+        a_capo = (const char *)memchr(inizio, '\n', fine - inizio);
+        if(a_capo == NULL) {
+            if(!ultimo)
+                return inizio;
+            a_capo = fine;
+        }
+        l->riga++;
+        analizzaRiga(l, inizio, a_capo);
+        inizio = a_capo < fine ? a_capo + 1 : fine;
+    }
+    return inizio;
 }
 
 /*
- * Funzione per inserire un nuovo elemento nella Linked list.
- * Gli elementi vengono direttamente messi in ordine alfabetico
+ * Funzione che analizza una riga nel formato Router-A;Router-B;costoLink e
+ * aggiunge la connessione, senza copiare la riga. Il costo è un intero non
+ * negativo: ogni riga aggiunge il link nei due versi, quindi un costo
+ * negativo formerebbe un ciclo negativo. Un quarto campo opzionale indica
+ * l'area del link (intero, default 0).
  *
- * @param l Inizio della linked list
- * @param connessione Nuovo elemento da inserire nella lista
- * @return Inizio della nuova linked list
+ * @param l stato della lettura, usato per segnalare le righe errate
+ * @param inizio inizio della riga
+ * @param fine fine della riga, '\n' escluso
  */
-struct Links *inserisciConnessione(struct Links *l, struct connessione connessione) {
-    /* Puntatori d'appoggio */
-    struct Links *pTemp, *testa = l;
+void analizzaRiga(struct letturaFile *l, const char *inizio, const char *fine) {
+    const char *primo, *secondo, *terzo, *fineCosto, *c;
+    long long costo = 0, area = 0;
+    int idPartenza, idArrivo;
 
-    /* Se la lista passata non è vuota viene aggiunto il nuovo elemento */
-    if(l != NULL) {
-        /* Crazione elemento da inserire */
-        pTemp = (struct Links *)malloc(sizeof(struct Links));
-        pTemp->connessione = connessione;
+    /* Vengono ignorati '\r' dei file creati su Windows e le righe vuote */
+    while(fine > inizio && (fine[-1] == '\r' || fine[-1] == ' ' || fine[-1] == '\t'))
+        fine--;
+    if(fine == inizio)
+        return;
+    if(*inizio == '@') {
+        analizzaCoordinate(l, inizio + 1, fine);
+        return;
+    }
 
-        /* Modifica del primo elemento della lista */
-        if(strcmp(pTemp->connessione.routerPartenza, l->connessione.routerPartenza) < 0) {
-            pTemp->next = l;
-            return(pTemp);
+    primo = (const char *)memchr(inizio, ';', fine - inizio);
+    secondo = primo != NULL ? (const char *)memchr(primo + 1, ';', fine - primo - 1) : NULL;
+    if(secondo == NULL || primo == inizio || secondo == primo + 1 || secondo + 1 == fine) {
+        rigaErrata(l);
+        return;
+    }
+    /* Lettura del costo e dell'area, se c'è */
+    c = secondo + 1;
+    terzo = (const char *)memchr(c, ';', fine - c);
+    fineCosto = terzo != NULL ? terzo : fine;
+    if(*c == '+')
+        c++;
+    if(c == fineCosto || (terzo != NULL && terzo + 1 == fine)) {
+        rigaErrata(l);
+        return;
+    }
+    for(; c < fineCosto; c++) {
+        if(*c < '0' || *c > '9' || costo > INT_MAX) {
+            rigaErrata(l);
+            return;
         }
-        else {
-            /* Scorrimento lista */
-            while(l->next != NULL && strcmp(pTemp->connessione.routerPartenza, l->next->connessione.routerPartenza) > 0)
-                l = l->next;
-            /* Inserimento dell'elemento in mezzo o a fine lista */
-            pTemp->next = l->next;
-            l->next = pTemp;
-            return(testa);
+        costo = costo * 10 + (*c - '0');
+    }
+    for(c = terzo != NULL ? terzo + 1 : fine; c < fine; c++) {
+        if(*c < '0' || *c > '9' || area >= LIMITE_AREE) {
+            rigaErrata(l);
+            return;
         }
+        area = area * 10 + (*c - '0');
     }
-    /* Se la lista passata è vuota viene inizializzata */
-    else {
-         /* creazione primo elemento */
-         l = (struct Links *)malloc(sizeof(struct Links));
-         l->connessione = connessione;
-         l->next = NULL;
-         testa = l;
+    if(costo > INT_MAX || area >= LIMITE_AREE) {
+        rigaErrata(l);
+        return;
+    }
+
+    idPartenza = internaNomeLungo(inizio, primo - inizio);
+    idArrivo = internaNomeLungo(primo + 1, secondo - primo - 1);
+    /* Controllo che la connessione non sia già esistente, necessario se
+      vengono aggiunti 2 file che hanno anche connessioni comuni */
+    if(!contieneContrario(idPartenza, idArrivo)) {
+        inserisciArcoArea(idPartenza, idArrivo, (int)costo, (int)area);
+        /* Le prossime righe permettono di salvare le connessioni in modo bilaterale
+         (se esiste A;B;3 esiste anche B;A;3) in modo da far funzionare la creazione
+         della tabella senza errori e inoltre permette di dimezzare la lunghezza dei
+         file in quanto ogni connessione può essere scritta una sola volta */
+        inserisciArcoArea(idArrivo, idPartenza, (int)costo, (int)area);
     }
-    return(testa);
 }
 
 /*
- * Funzione che controlla se nella linked list delle connessioni è già presente
- * il contrario di una connessione (A; B) (B; A).
- * Serve per evitare di aggiungere connessioni inutilmente.
+ * Funzione che legge una riga di coordinate @router;x;y (senza la @)
  *
- * @param l Linked list delle connessioni
- * @param conn connessione da controllare
- * @return true se la connessione contraria esiste, false altrimenti
+ * @param l stato della lettura, per segnalare gli errori
+ * @param inizio primo carattere dopo la @
+ * @param fine fine della riga
  */
-bool contieneContrario(struct Links *l, struct connessione conn) {
-    while(l != NULL) {
-        if(strcmp(l->connessione.routerPartenza, conn.routerArrivo) == 0
-            && strcmp(l->connessione.routerArrivo, conn.routerPartenza) == 0)
-            return true;
-        l = l->next;
+void analizzaCoordinate(struct letturaFile *l, const char *inizio, const char *fine) {
+    const char *primo = (const char *)memchr(inizio, ';', fine - inizio);
+    char numeri[128], *resto, *secondo;
+    double x, y;
+
+    /* I numeri vengono copiati perché la riga nel file mappato non finisce con '\0' */
+    if(primo == NULL || primo == inizio || fine - primo - 1 >= (long)sizeof(numeri)) {
+        rigaErrata(l);
+        return;
     }
-    return false;
+    memcpy(numeri, primo + 1, fine - primo - 1);
+    numeri[fine - primo - 1] = '\0';
+    x = strtod(numeri, &resto);
+    if(resto == numeri || *resto != ';') {
+        rigaErrata(l);
+        return;
+    }
+    secondo = resto + 1;
+    y = strtod(secondo, &resto);
+    if(resto == secondo || *resto != '\0' || !isfinite(x) || !isfinite(y)) {
+        rigaErrata(l);
+        return;
+    }
+    impostaCoordinate(internaNomeLungo(inizio, primo - inizio), x, y);
 }
 
 /*
- * Funzione cha inizializza la tabella di instradamento del router selezionato.
+ * Funzione che segnala una riga non valida con il suo numero, dopo le prime
+ * 20 righe errate viene solo contato il totale
+ */
+void rigaErrata(struct letturaFile *l) {
+    if(l->righeErrate++ < 20)
+        fprintf(stderr, "%s:%d: riga non valida, formato atteso Router-A;Router-B;costoLink[;area]\n",
+                l->nomeFile, l->riga);
+}
+
+/*
+ * Funzione chiamata alla fine della lettura di un file, stampa il numero
+ * totale di righe errate se sono troppe per essere stampate tutte
+ */
+void fineLettura(struct letturaFile *l) {
+    if(l->righeErrate > 20)
+        fprintf(stderr, "%s: %d righe non valide in totale\n", l->nomeFile, l->righeErrate);
+}
+
+/*
+ * Funzione di hash (FNV-1a) per i nomi dei router
+ */
+unsigned int hashNome(const char *nome, size_t lunghezza) {
+    unsigned int h = 2166136261u;
+    size_t i;
+
+    for(i = 0; i < lunghezza; i++) {
+        h ^= (unsigned char)nome[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*
+ * Funzione che cerca la posizione di un nome nella hash table dei nomi.
  *
- * @param tabella Inizio della tabella di instradamento vuota
- * @return Inizio della tabella di instradamento riempita
+ * @param t tabella dei nomi (quella globale o la copia di una versione della rete)
+ * @param nome nome da cercare (non per forza terminato da '\0')
+ * @param lunghezza lunghezza del nome
+ * @return indice dello slot che contiene il nome o del primo slot libero
  */
-struct llTabella *inizializzaTabella(struct llTabella *tabella, char start[15]) {
-    struct llTabella *testa = tabella, *tTemp;
-    struct priority *priorityQueue;
-    struct Links *linksTemp = links;
-    int costo;
-    struct connessione tempLink;
-    struct entry entryTemp;
-    char nodoTemp[15];
-    const char *nextHop;
-
-    /* Inizializzazione del primo elemento della priority queue */
-    priorityQueue = (struct priority *)malloc(sizeof(struct priority));
-    strcpy(priorityQueue->nodo, start);
-    priorityQueue->valore = 0;
-    priorityQueue->next = NULL;
-
-    /* Inserimento primo elemento nella tabella */
-    tabella = (struct llTabella *)malloc(sizeof(struct llTabella));
-    strcpy(tabella->riga.nextHop, start);
-    strcpy(tabella->riga.destinazione, start);
-    tabella->riga.costo = 0;
-    tabella->next = NULL;
-    testa = tabella;
-
-    while(priorityQueue != NULL) {
-        /* Questo while trova il nodo che bisogna analizzare nella linked list
-           delle connessioni */
-        while(linksTemp != NULL && strcmp(linksTemp->connessione.routerPartenza, priorityQueue->nodo) != 0)
-            linksTemp = linksTemp->next;
-        /* In questo while i nodi direttamente connessi a quello preso in considerazione
-           vengono inseriti nella tabella o se già presenti vengono confrontati
-           con il percorso già esistente */
-        while(linksTemp != NULL && strcmp(linksTemp->connessione.routerPartenza, priorityQueue->nodo) == 0) {
-            tempLink = linksTemp->connessione;
-            /* Calcolo costo per raggiungere un nodo connesso al nodo
-               preso in considerazione */
-            costo = costoRouterPrecedente(testa, tempLink.routerPartenza);
-            costo += tempLink.costoLink;
-            /* Righe per trovare in next hop per la destinazione, se la destinazione
-               è direttamente connessa al router di partenza allora la destinazione
-               stessa viene inserita come next hop */
-            if(strcmp(tempLink.routerPartenza, start) != 0)
-                nextHop = getNextHop(testa,tempLink.routerPartenza);
-            else
-                nextHop = tempLink.routerArrivo;
-            /* Inizializzazione entry da inserire nella tabella */
-            strcpy(nodoTemp, tempLink.routerArrivo);
-            strcpy(entryTemp.nextHop, nextHop);
-            strcpy(entryTemp.destinazione, nodoTemp);
-            entryTemp.costo = costo;
-            /* Se il nodo di destinazione non è già presente nella tabella viene inserita per la
-               prima volta */
-            if(!containsTabella(testa, nodoTemp)){
-                tTemp = (struct llTabella *)malloc(sizeof(struct llTabella));
-                tTemp->riga = entryTemp;
-                tTemp->next = NULL;
-                while(tabella->next != NULL)
-                    tabella = tabella->next;
-                tabella->next = tTemp;
-                tabella = tabella->next;
-                priorityQueue = inserisciPriority(priorityQueue, nodoTemp, costo);
-            }
-            /* Se il nodo di destinazione è già presente nella tabella allora
-               viene confrontato con quello temporaneo */
-            else {
-                if(costoRouterPrecedente(testa, nodoTemp) > costo) {
-                    tabella = sostituisciTabella(testa, entryTemp);
-                    priorityQueue = inserisciPriority(priorityQueue, nodoTemp, costo);
-                }
-            }
-            linksTemp = linksTemp->next;
-        }
-        /* Viene rimosso il primo router della tabella in quento è stato completamente
-           analizzato */
-        priorityQueue = rimuoviPriority(priorityQueue, priorityQueue->nodo);
-        linksTemp = links;
+int slotNome(const struct tabellaNomi *t, const char *nome, size_t lunghezza) {
+    unsigned int h = hashNome(nome, lunghezza);
+    int i = h & (t->capacitaSlot - 1);
+    const char *altro;
+
+    while(t->slot[i] != -1) {
+        altro = nomeIn(t, t->slot[i]);
+        if(t->hashSlot[i] == h && memcmp(altro, nome, lunghezza) == 0 && altro[lunghezza] == '\0')
+            break;
+        i = (i + 1) & (t->capacitaSlot - 1);
     }
+    return i;
+}
 
-    return testa;
+/*
+ * Funzione che restituisce l'ID di un router, se il router non è ancora
+ * conosciuto gli viene assegnato un nuovo ID.
+ *
+ * @param nome nome del router
+ * @return ID del router
+ */
+int internaNome(const char *nome) {
+    return internaNomeLungo(nome, strlen(nome));
 }
 
 /*
- * Funzione per trovare il next hop di una destinazione
+ * Come internaNome, ma il nome può non essere terminato da '\0' (ad esempio
+ * un pezzo di una riga del file)
+ *
+ * @param nome nome del router
+ * @param lunghezza lunghezza del nome
+ * @return ID del router
  */
-const char * getNextHop(struct llTabella *t, char dest[15]) {
-    while(t != NULL) {
-        if(strcmp(t->riga.destinazione, dest) == 0)
-            return t->riga.nextHop;
-        t = t->next;
+int internaNomeLungo(const char *nome, size_t lunghezza) {
+    int i, s;
+
+    staccaSnapshot();
+    /* La hash table viene tenuta piena al massimo per metà */
+    if(2 * (nomi.numNomi + 1) > nomi.capacitaSlot) {
+        free(nomi.slot);
+        free(nomi.hashSlot);
+        nomi.capacitaSlot = nomi.capacitaSlot == 0 ? 64 : 2 * nomi.capacitaSlot;
+        nomi.slot = (int *)malloc(nomi.capacitaSlot * sizeof(int));
+        nomi.hashSlot = (unsigned int *)malloc(nomi.capacitaSlot * sizeof(unsigned int));
+        for(i = 0; i < nomi.capacitaSlot; i++)
+            nomi.slot[i] = -1;
+        for(i = 0; i < nomi.numNomi; i++) {
+            s = slotNome(&nomi, nomeNodo(i), strlen(nomeNodo(i)));
+            nomi.slot[s] = i;
+            nomi.hashSlot[s] = hashNome(nomeNodo(i), strlen(nomeNodo(i)));
+        }
+    }
+    s = slotNome(&nomi, nome, lunghezza);
+    if(nomi.slot[s] != -1)
+        return nomi.slot[s];
+
+    /* Nuovo nome */
+    if(nomi.numNomi == nomi.capacitaNomi) {
+        nomi.capacitaNomi = nomi.capacitaNomi == 0 ? 64 : 2 * nomi.capacitaNomi;
+        nomi.inizio = (size_t *)realloc(nomi.inizio, nomi.capacitaNomi * sizeof(size_t));
+    }
+    while(nomi.usati + lunghezza + 1 > nomi.capacitaCaratteri) {
+        nomi.capacitaCaratteri = nomi.capacitaCaratteri == 0 ? 1024 : 2 * nomi.capacitaCaratteri;
+        nomi.caratteri = (char *)realloc(nomi.caratteri, nomi.capacitaCaratteri);
     }
+    memcpy(nomi.caratteri + nomi.usati, nome, lunghezza);
+    nomi.caratteri[nomi.usati + lunghezza] = '\0';
+    nomi.inizio[nomi.numNomi] = nomi.usati;
+    nomi.usati += lunghezza + 1;
+    nomi.slot[s] = nomi.numNomi;
+    nomi.hashSlot[s] = hashNome(nome, lunghezza);
+    return nomi.numNomi++;
 }
 
 /*
- * Funzione che sostituisce una entry nella tabella con quella passata come
- * parametro
+ * Funzione che restituisce l'ID di un router senza aggiungerlo.
  *
- * @param t Linked list
- * @param e entry da inserire al posto di quella vecchia
- * @return la nuova linked list
+ * @param nome nome del router
+ * @return ID del router, -1 se non esiste
  */
-struct llTabella *sostituisciTabella(struct llTabella *t, struct entry e) {
-    struct llTabella *testa = t;
+int cercaNome(const char *nome) {
+    return cercaNomeIn(&nomi, nome);
+}
 
-    while(strcmp(t->riga.destinazione, e.destinazione) != 0)
-        t = t->next;
-    t->riga = e;
-    return testa;
+/*
+ * Come cercaNome, ma in una tabella dei nomi indicata
+ */
+int cercaNomeIn(const struct tabellaNomi *t, const char *nome) {
+    if(t->numNomi == 0)
+        return -1;
+    return t->slot[slotNome(t, nome, strlen(nome))];
 }
 
 /*
- * Funzione che controlla se una destinazione è già presente nella tabella,
- * in modo da poter sapere se bisogna inserirla per la prima volta o sostituire
- * quella vecchia.
- *
- * @param t Linked list
- * @param nodo nome del nodo da controllare
- * @return true se la destinazione è già presente, false altrimenti
+ * Funzione che restituisce il nome di un router dato il suo ID
  */
-bool containsTabella(struct llTabella *t, char nodo[15]) {
-    while(t != NULL && strcmp(t->riga.destinazione, nodo) != 0)
-        t = t->next;
-    if(t == NULL)
-        return false;
-    return true;
+const char *nomeNodo(int id) {
+    return nomeIn(&nomi, id);
+}
+
+/*
+ * Come nomeNodo, ma in una tabella dei nomi indicata
+ */
+const char *nomeIn(const struct tabellaNomi *t, int id) {
+    return t->caratteri + t->inizio[id];
 }
 
 /*
- * Funzione per aggiungere un elemento nella priority queue
+ * Funzione che legge una parola da tastiera senza limiti di lunghezza.
  *
- * @param p Linked list
- * @param nodo nome nodo
- * @param valore costo da start fino al nodo, per determinare la priorità
- * @return Testa della linked list
- */
-struct priority *inserisciPriority(struct priority *p, char nodo[15], int valore) {
-    struct priority *pTemp;
-    struct priority *testa = p;
-
-    p = p->next;
-    /* Controllo se l'elemento è già presente nella priority queue e se presente
-       lo elimina ed inserisce quello nuovo */
-    if(containsPriority(p, nodo))
-        /* L'elemento viene eliminato di principio in quanto questa funzione viene
-           richiamata solo se si trova un percorso più corto per il nodo e quindi
-           di sicuro i suoi dati nella priority cambiano */
-        p = rimuoviPriority(p, nodo);
-
-    pTemp = (struct priority *)malloc(sizeof(struct priority));
-    strcpy(pTemp->nodo, nodo);
-    pTemp->valore = valore;
-    /* Se è presente un solo elemento nella tabella allora quello nuovo viene
-       inserito alla fine */
-    if(p == NULL) {
-        p = pTemp;
-        p->next = NULL;
-        testa->next = p;
-    }
-    /* Se esisitono più elementi nella priority l'elemento viene inserito prima
-       del primo nodo che ha il campo valore maggiore del suo */
-    else {
-        p = testa;
-        while(p->next != NULL && p->next->valore < valore)
-            p = p->next;
-        pTemp->next = p->next;
-        p->next = pTemp;
+ * @return parola letta (da liberare con free), NULL se l'input è finito
+ */
+char *leggiParola() {
+    size_t lunghezza = 0, capacita = 16;
+    char *parola;
+    int c;
+
+    do{
+        c = getchar();
+    }while(c == ' ' || c == '\t' || c == '\n' || c == '\r');
+    if(c == EOF)
+        return NULL;
+    parola = (char *)malloc(capacita);
+    while(c != EOF && c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+        if(lunghezza + 1 == capacita) {
+            capacita *= 2;
+            parola = (char *)realloc(parola, capacita);
+        }
+        parola[lunghezza++] = c;
+        c = getchar();
     }
-    return testa;
+    /* Il carattere di fine parola viene lasciato nell'input come farebbe scanf */
+    if(c != EOF)
+        ungetc(c, stdin);
+    parola[lunghezza] = '\0';
+    return parola;
 }
 
 /*
- * Funzione che rimuove un elemento dalla priority queue.
+ * Funzione per inserire un nuovo arco diretto nella topologia.
+ * Il CSR viene invalidato e verrà ricostruito alla prossima lettura.
  *
- * @param p Linked list
- * @param nodo nome nodo da rimuovere
- * @return Testa della linked list
+ * @param partenza ID del router di partenza
+ * @param arrivo ID del router di arrivo
+ * @param costo costo del link
+ */
+void inserisciArco(int partenza, int arrivo, int costo) {
+    inserisciArcoArea(partenza, arrivo, costo, areaComune(partenza, arrivo));
+}
+
+/*
+ * Come inserisciArco, con l'area del link
  */
-struct priority *rimuoviPriority(struct priority *p, char nodo[15]) {
-    struct priority *testa = p;
+void inserisciArcoArea(int partenza, int arrivo, int costo, int area) {
+    int i;
 
-    /* Controllo se l'elemento da rimuovere dalla priority si trova in testa */
-    if(strcmp(p->nodo, nodo) == 0)
-        return p->next;
+    staccaSnapshot();
+    /* Viene riusata una posizione lasciata libera da un arco rimosso */
+    if(rete.primoLibero != -1) {
+        i = rete.primoLibero;
+        rete.primoLibero = rete.archi[i].arrivo;
+    }
     else {
-        while(strcmp(p->next->nodo, nodo) != 0)
-            p = p->next;
-        p->next = p->next->next;
-        return testa;
+        if(rete.numSlot == rete.capacitaArchi) {
+            rete.capacitaArchi = rete.capacitaArchi == 0 ? 64 : 2 * rete.capacitaArchi;
+            rete.archi = (struct arco *)realloc(rete.archi, rete.capacitaArchi * sizeof(struct arco));
+        }
+        i = rete.numSlot++;
     }
+    rete.archi[i].partenza = partenza;
+    rete.archi[i].arrivo = arrivo;
+    rete.archi[i].costo = costo;
+    rete.archi[i].area = area;
+    rete.numArchi++;
+    segnaArea(area);
+    aggiungiArcoInsieme(i);
+    if(!aggiungiArcoCSR(partenza, arrivo, costo))
+        rete.csrValido = false;
+    generazioneTopologia++;
 }
 
 /*
- * Funzione che controlla se un nodo è già stato inserito nella priority queue
+ * Funzione che rimuove il primo arco diretto partenza -> arrivo.
  *
- * @param p Linked list
- * @param nodo nome del nodo da ricercare
- * @return true se è presente, false al contrario
+ * @param costo se non è NULL ci viene salvato il costo dell'arco rimosso
+ * @return true se l'arco esisteva, false altrimenti
  */
-bool containsPriority(struct priority *p, char nodo[15]) {
-    while(p != NULL && strcmp(p->nodo, nodo) != 0)
-        p = p->next;
-    if(p != NULL)
-        return true;
-    return false;
+bool rimuoviArco(int partenza, int arrivo, int *costo) {
+    int i = primoArco(partenza, arrivo);
+
+    if(i == -1)
+        return false;
+    if(costo != NULL)
+        *costo = rete.archi[i].costo;
+    segnaArea(rete.archi[i].area);
+    togliArcoInsieme(i);
+    if(!togliArcoCSR(partenza, arrivo, rete.archi[i].costo))
+        rete.csrValido = false;
+    /* La posizione va nella lista di quelle libere */
+    rete.archi[i].partenza = ARCO_RIMOSSO;
+    rete.archi[i].arrivo = rete.primoLibero;
+    rete.primoLibero = i;
+    rete.numArchi--;
+    generazioneTopologia++;
+    /* Se più di metà delle posizioni sono libere la lista viene
+       compattata e la memoria in più restituita */
+    if(rete.numSlot > 1024 && rete.numArchi < rete.numSlot / 2)
+        compattaArchi();
+    return true;
+}
+
+/*
+ * Funzione che elimina i buchi lasciati dagli archi rimossi, mantenendo
+ * l'ordine degli altri, e riduce la memoria della lista degli archi
+ */
+void compattaArchi() {
+    int i, j = 0;
+
+    for(i = 0; i < rete.numSlot; i++)
+        if(rete.archi[i].partenza != ARCO_RIMOSSO)
+            rete.archi[j++] = rete.archi[i];
+    rete.numSlot = j;
+    rete.primoLibero = -1;
+    rete.capacitaArchi = j > 64 ? j : 64;
+    rete.archi = (struct arco *)realloc(rete.archi, rete.capacitaArchi * sizeof(struct arco));
+    /* Le posizioni sono cambiate, le catene vanno rifatte */
+    ricostruisciInsiemeArchi();
+}
+
+/*
+ * Funzione che calcola la chiave di un arco diretto per l'insieme degli archi
+ */
+unsigned long long chiaveArco(int partenza, int arrivo) {
+    return ((unsigned long long)(unsigned int)partenza << 32) | (unsigned int)arrivo;
 }
 
 /*
- * Funzione che restituisce il costo per arrivare ad un nodo, in questo caso
- * il router è quello che precede un nodo di destinazione analizzato.
+ * Funzione che calcola lo slot da cui parte la ricerca di una chiave
+ * nell'insieme degli archi
+ */
+int inizioSlotArco(unsigned long long chiave) {
+    return (int)((chiave * 0x9E3779B97F4A7C15ull) >> 32) & (rete.presenti.capacita - 1);
+}
+
+/*
+ * Funzione che cerca la posizione di un arco nell'insieme degli archi.
  *
- * @param tabella linked list che rappresenta la tabella
- * @param nodo destinazione
- * @return
+ * @param chiave chiave dell'arco
+ * @return indice dello slot che contiene l'arco o del primo slot libero
  */
-int costoRouterPrecedente(struct llTabella *tabella, char nodo[15]) {
-    while(strcmp(tabella->riga.destinazione, nodo) != 0) {
-        tabella = tabella->next;
-    }
-    return tabella->riga.costo;
+int slotArco(unsigned long long chiave) {
+    int i = inizioSlotArco(chiave);
+
+    while(rete.presenti.chiavi[i] != ARCO_LIBERO && rete.presenti.chiavi[i] != chiave)
+        i = (i + 1) & (rete.presenti.capacita - 1);
+    return i;
 }
 
-/**
- * Funzione per rimuovere un router dalla rete
+/*
+ * Funzione che restituisce quanti archi diretti partenza -> arrivo esistono
  */
-bool rimuoviConnessione() {
-    char rPartenza[15], rArrivo[15];
-    struct Links *testa = links;
+int contaArco(int partenza, int arrivo) {
+    int s;
 
-    /* Inserimento dati della connessione da rimuovere */
-    printf("Rimozione connessione:\n");
-    printf("Inserisci router di partenza: ");
-    scanf("%s", rPartenza);
-    printf("Inserisci router di arrivo: ");
-    scanf("%s", rArrivo);
-
-    /* Controllo se la connessione da rimuovere si trova in testa o in mezzo alla
-       linked list */
-    if(strcmp(rPartenza, links->connessione.routerPartenza) == 0
-        && strcmp(rArrivo, links->connessione.routerArrivo) == 0) {
-        testa = links->next;
-        printf("\nConnessione rimossa con successo!");
-        links = testa;
-        return true;
-    }
-    while(links->next != NULL) {
-        if(strcmp(rPartenza, links->next->connessione.routerPartenza) == 0
-            && strcmp(rArrivo, links->next->connessione.routerArrivo) == 0) {
-            links->next = links->next->next;
-            printf("\nConnessione rimossa con successo!");
-            links = testa;
-            return true;
+    staccaSnapshot();
+    if(rete.presenti.capacita == 0)
+        return 0;
+    s = slotArco(chiaveArco(partenza, arrivo));
+    return rete.presenti.chiavi[s] == ARCO_LIBERO ? 0 : rete.presenti.conteggio[s];
+}
+
+/*
+ * Funzione che aggiunge all'insieme l'arco in una posizione di rete.archi:
+ * la catena degli archi con la stessa chiave resta in ordine di posizione,
+ * così il primo è quello che troverebbe una scansione della lista.
+ *
+ * @param posizione posizione dell'arco in rete.archi
+ */
+void aggiungiArcoInsieme(int posizione) {
+    struct insiemeArchi vecchio = rete.presenti;
+    unsigned long long chiave = chiaveArco(rete.archi[posizione].partenza, rete.archi[posizione].arrivo);
+    int i, s, *anello;
+
+    /* L'insieme viene tenuto pieno al massimo per metà */
+    if(2 * (rete.presenti.numChiavi + 1) > rete.presenti.capacita) {
+        rete.presenti.capacita = vecchio.capacita == 0 ? 256 : 2 * vecchio.capacita;
+        rete.presenti.chiavi = (unsigned long long *)malloc(rete.presenti.capacita * sizeof(unsigned long long));
+        rete.presenti.conteggio = (int *)malloc(rete.presenti.capacita * sizeof(int));
+        rete.presenti.primo = (int *)malloc(rete.presenti.capacita * sizeof(int));
+        for(i = 0; i < rete.presenti.capacita; i++)
+            rete.presenti.chiavi[i] = ARCO_LIBERO;
+        for(i = 0; i < vecchio.capacita; i++) {
+            if(vecchio.chiavi[i] != ARCO_LIBERO) {
+                s = slotArco(vecchio.chiavi[i]);
+                rete.presenti.chiavi[s] = vecchio.chiavi[i];
+                rete.presenti.conteggio[s] = vecchio.conteggio[i];
+                rete.presenti.primo[s] = vecchio.primo[i];
+            }
         }
-        links = links->next;
+        free(vecchio.chiavi);
+        free(vecchio.conteggio);
+        free(vecchio.primo);
     }
-    links = testa;
-    printf("\nConnessione non esistente!\n");
+    s = slotArco(chiave);
+    if(rete.presenti.chiavi[s] == ARCO_LIBERO) {
+        rete.presenti.chiavi[s] = chiave;
+        rete.presenti.conteggio[s] = 0;
+        rete.presenti.primo[s] = -1;
+        rete.presenti.numChiavi++;
+    }
+    anello = &rete.presenti.primo[s];
+    while(*anello != -1 && *anello < posizione)
+        anello = &rete.archi[*anello].succ;
+    rete.archi[posizione].succ = *anello;
+    *anello = posizione;
+    rete.presenti.conteggio[s]++;
+}
+
+/*
+ * Funzione che toglie dall'insieme l'arco in una posizione di rete.archi.
+ * Quando la chiave resta senza archi viene tolta spostando indietro le
+ * chiavi successive della stessa sequenza (niente lapidi), così sotto un
+ * flusso di link aggiunti e rimossi l'insieme non cresce.
+ *
+ * @param posizione posizione dell'arco in rete.archi
+ */
+void togliArcoInsieme(int posizione) {
+    int s = slotArco(chiaveArco(rete.archi[posizione].partenza, rete.archi[posizione].arrivo));
+    int maschera = rete.presenti.capacita - 1, j, k, *anello;
+
+    anello = &rete.presenti.primo[s];
+    while(*anello != posizione)
+        anello = &rete.archi[*anello].succ;
+    *anello = rete.archi[posizione].succ;
+    if(--rete.presenti.conteggio[s] > 0)
+        return;
+    for(j = (s + 1) & maschera; rete.presenti.chiavi[j] != ARCO_LIBERO; j = (j + 1) & maschera) {
+        /* La chiave in j può andare in s solo se il suo slot iniziale non
+           sta tra s (escluso) e j */
+        k = inizioSlotArco(rete.presenti.chiavi[j]);
+        if(s <= j ? (s < k && k <= j) : (s < k || k <= j))
+            continue;
+        rete.presenti.chiavi[s] = rete.presenti.chiavi[j];
+        rete.presenti.conteggio[s] = rete.presenti.conteggio[j];
+        rete.presenti.primo[s] = rete.presenti.primo[j];
+        s = j;
+    }
+    rete.presenti.chiavi[s] = ARCO_LIBERO;
+    rete.presenti.numChiavi--;
+}
+
+/*
+ * Funzione che restituisce la posizione in rete.archi del primo arco
+ * diretto partenza -> arrivo
+ *
+ * @return posizione dell'arco, -1 se non esiste
+ */
+int primoArco(int partenza, int arrivo) {
+    int s;
+
+    staccaSnapshot();
+    if(rete.presenti.capacita == 0)
+        return -1;
+    s = slotArco(chiaveArco(partenza, arrivo));
+    return rete.presenti.chiavi[s] == ARCO_LIBERO ? -1 : rete.presenti.primo[s];
+}
+
+/*
+ * Funzione che ricostruisce l'insieme degli archi quando le posizioni in
+ * rete.archi cambiano (compattazione, rinumerazione)
+ */
+void ricostruisciInsiemeArchi() {
+    int i;
+
+    free(rete.presenti.chiavi);
+    free(rete.presenti.conteggio);
+    free(rete.presenti.primo);
+    memset(&rete.presenti, 0, sizeof(rete.presenti));
+    for(i = 0; i < rete.numSlot; i++)
+        if(rete.archi[i].partenza != ARCO_RIMOSSO)
+            aggiungiArcoInsieme(i);
+}
+/*
+ * Funzione che cambia il costo del primo arco diretto partenza -> arrivo.
+ *
+ * @param vecchioCosto ci viene salvato il costo precedente
+ * @return true se l'arco esisteva, false altrimenti
+ */
+bool modificaCostoArco(int partenza, int arrivo, int costo, int *vecchioCosto) {
+    int i = primoArco(partenza, arrivo);
+
+    if(i == -1)
+        return false;
+    *vecchioCosto = rete.archi[i].costo;
+    rete.archi[i].costo = costo;
+    segnaArea(rete.archi[i].area);
+    if(!cambiaCostoCSR(partenza, arrivo, *vecchioCosto, costo))
+        rete.csrValido = false;
+    generazioneTopologia++;
+    return true;
+}
+
+/*
+ * Funzione che ricostruisce il CSR dalla lista degli archi se è stata
+ * modificata (counting sort sul nodo di partenza, O(V + E)).
+ *
+ * @return grafo in formato CSR aggiornato
+ */
+const struct csr *aggiornaCSR() {
+    struct csr *g = &rete.csr;
+    int i, *posizione;
+    double inizio;
+
+    /* Anche un nuovo nome senza archi richiede di allargare offset */
+    if(rete.csrValido && g->numNodi == nomi.numNomi)
+        return g;
+    inizio = secondi();
+    g->numNodi = nomi.numNomi;
+    g->numArchi = rete.numArchi;
+    g->offset = (int *)realloc(g->offset, (g->numNodi + 1) * sizeof(int));
+    g->arrivo = (int *)realloc(g->arrivo, (g->numArchi + 1) * sizeof(int));
+    g->costo = (int *)realloc(g->costo, (g->numArchi + 1) * sizeof(int));
+    /* Conteggio del grado uscente di ogni nodo */
+    memset(g->offset, 0, (g->numNodi + 1) * sizeof(int));
+    for(i = 0; i < rete.numSlot; i++)
+        if(rete.archi[i].partenza != ARCO_RIMOSSO)
+            g->offset[rete.archi[i].partenza + 1]++;
+    for(i = 0; i < g->numNodi; i++)
+        g->offset[i + 1] += g->offset[i];
+    /* Inserimento degli archi mantenendo l'ordine di inserimento */
+    posizione = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    memcpy(posizione, g->offset, (g->numNodi + 1) * sizeof(int));
+    for(i = 0; i < rete.numSlot; i++) {
+        if(rete.archi[i].partenza == ARCO_RIMOSSO)
+            continue;
+        g->arrivo[posizione[rete.archi[i].partenza]] = rete.archi[i].arrivo;
+        g->costo[posizione[rete.archi[i].partenza]++] = rete.archi[i].costo;
+    }
+    free(posizione);
+    aggiornaCostiEstremi(g);
+    /* Il CSR ricostruito non ha buchi */
+    rete.buchi = (int *)realloc(rete.buchi, (g->numNodi + 1) * sizeof(int));
+    memset(rete.buchi, 0, (g->numNodi + 1) * sizeof(int));
+    rete.numBuchi = 0;
+    rete.csrValido = true;
+    rete.entrateValide = false;
+    statistiche.costruzione += secondi() - inizio;
+    return g;
+}
+
+/*
+ * Come aggiornaCSR, ma senza buchi: se ce ne sono il CSR viene ricostruito.
+ * Serve a chi usa il CSR come elenco dei link (elenco del menu, snapshot,
+ * impronta della topologia, gerarchia, FIB compatta, riordino dei nodi,
+ * versioni pubblicate dal server).
+ *
+ * @return grafo in formato CSR aggiornato e senza buchi
+ */
+const struct csr *aggiornaCSRCompatto() {
+    if(rete.numBuchi > 0)
+        rete.csrValido = false;
+    return aggiornaCSR();
+}
+
+/*
+ * Funzione che aggiunge sul posto l'arco partenza -> arrivo al CSR (e agli
+ * archi entranti se sono validi), riusando un buco della riga di partenza.
+ * Costa quanto il grado dei nodi toccati.
+ *
+ * @param partenza router di partenza dell'arco
+ * @param arrivo router di arrivo dell'arco
+ * @param costo costo dell'arco
+ * @return false se il CSR va ricostruito
+ */
+bool aggiungiArcoCSR(int partenza, int arrivo, int costo) {
+    struct csr *g = &rete.csr;
+    int i;
+
+    if(!rete.csrValido || g->numNodi != nomi.numNomi || rete.buchi == NULL || rete.buchi[partenza] == 0)
+        return false;
+    for(i = g->offset[partenza]; g->arrivo[i] != partenza || g->costo[i] != 0; i++)
+        ;
+    g->arrivo[i] = arrivo;
+    g->costo[i] = costo;
+    rete.buchi[partenza]--;
+    rete.numBuchi--;
+    allargaCostiEstremi(g, costo);
+    if(!rete.entrateValide)
+        return true;
+    /* Senza un buco nella riga di arrivo vengono ricostruiti solo gli archi entranti */
+    if(rete.buchiEntrata[arrivo] == 0) {
+        rete.entrateValide = false;
+        return true;
+    }
+    for(i = g->offsetEntrata[arrivo]; g->partenzaEntrata[i] != arrivo || g->costoEntrata[i] != 0; i++)
+        ;
+    g->partenzaEntrata[i] = partenza;
+    g->costoEntrata[i] = costo;
+    rete.buchiEntrata[arrivo]--;
+    return true;
+}
+
+/*
+ * Funzione che toglie sul posto l'arco partenza -> arrivo dal CSR e dagli
+ * archi entranti, lasciando un buco in entrambe le righe. Quando i buchi
+ * sono più della metà degli archi il CSR viene ricostruito.
+ *
+ * @param partenza router di partenza dell'arco
+ * @param arrivo router di arrivo dell'arco
+ * @param costo costo dell'arco
+ * @return false se il CSR va ricostruito
+ */
+bool togliArcoCSR(int partenza, int arrivo, int costo) {
+    struct csr *g = &rete.csr;
+    int i;
+
+    if(!rete.csrValido || g->numNodi != nomi.numNomi || rete.buchi == NULL || 2 * (rete.numBuchi + 1) > g->numArchi)
+        return false;
+    for(i = g->offset[partenza]; i < g->offset[partenza + 1]; i++)
+        if(g->arrivo[i] == arrivo && g->costo[i] == costo)
+            break;
+    if(i == g->offset[partenza + 1])
+        return false;
+    g->arrivo[i] = partenza;
+    g->costo[i] = 0;
+    rete.buchi[partenza]++;
+    rete.numBuchi++;
+    if(!rete.entrateValide)
+        return true;
+    for(i = g->offsetEntrata[arrivo]; g->partenzaEntrata[i] != partenza || g->costoEntrata[i] != costo; i++)
+        ;
+    g->partenzaEntrata[i] = arrivo;
+    g->costoEntrata[i] = 0;
+    rete.buchiEntrata[arrivo]++;
+    return true;
+}
+
+/*
+ * Funzione che cambia sul posto il costo dell'arco partenza -> arrivo nel
+ * CSR e negli archi entranti
+ *
+ * @param partenza router di partenza dell'arco
+ * @param arrivo router di arrivo dell'arco
+ * @param vecchioCosto costo dell'arco prima della modifica
+ * @param nuovoCosto costo dell'arco dopo la modifica
+ * @return false se il CSR va ricostruito
+ */
+bool cambiaCostoCSR(int partenza, int arrivo, int vecchioCosto, int nuovoCosto) {
+    struct csr *g = &rete.csr;
+    int i;
+
+    if(!rete.csrValido || g->numNodi != nomi.numNomi || rete.buchi == NULL)
+        return false;
+    for(i = g->offset[partenza]; i < g->offset[partenza + 1]; i++)
+        if(g->arrivo[i] == arrivo && g->costo[i] == vecchioCosto)
+            break;
+    if(i == g->offset[partenza + 1])
+        return false;
+    g->costo[i] = nuovoCosto;
+    allargaCostiEstremi(g, nuovoCosto);
+    if(!rete.entrateValide)
+        return true;
+    for(i = g->offsetEntrata[arrivo]; g->partenzaEntrata[i] != partenza || g->costoEntrata[i] != vecchioCosto; i++)
+        ;
+    g->costoEntrata[i] = nuovoCosto;
+    return true;
+}
+
+/*
+ * Funzione che controlla se tra le connessioni è già presente il contrario
+ * di una connessione (A; B) (B; A).
+ * Serve per evitare di aggiungere connessioni inutilmente.
+ *
+ * @param partenza ID del router di partenza della connessione da controllare
+ * @param arrivo ID del router di arrivo della connessione da controllare
+ * @return true se la connessione contraria esiste, false altrimenti
+ */
+bool contieneContrario(int partenza, int arrivo) {
+    return contaArco(arrivo, partenza) > 0;
+}
+
+/*
+ * Funzione cha inizializza la tabella di instradamento del router selezionato.
+ *
+ * @param tabella Inizio della tabella di instradamento vuota
+ * @param start ID del router di partenza
+ * @return Inizio della tabella di instradamento riempita
+ */
+struct llTabella *inizializzaTabella(struct llTabella *tabella, int start) {
+    const struct csr *g = aggiornaCSR();
+    struct statoTabella stato;
+
+    /* Lo stato temporaneo viene preso dall'arena e restituito in O(1) */
+    creaStatoArena(&stato, g->numNodi, &arenaScratch);
+    calcolaTabellaSingola(g, start, &stato);
+    tabella = tabellaDaStato(&stato);
+    resetArena(&arenaScratch);
+
+    return tabella;
+}
+
+/*
+ * Funzione che crea la tabella di instradamento nel formato della linked
+ * list a partire dallo stato calcolato da Dijkstra. Le righe sono prese
+ * dall'arena delle tabelle e restano valide fino alla prossima liberaTabella.
+ *
+ * @param s stato con la tabella calcolata
+ * @return Inizio della tabella di instradamento
+ */
+struct llTabella *tabellaDaStato(const struct statoTabella *s) {
+    struct llTabella *testa = NULL, **coda = &testa, *tabella;
+    int i, nodo;
+
+    /* Le righe vengono inserite nell'ordine in cui le destinazioni sono
+       state trovate, tenendo un puntatore alla fine della lista */
+    for(i = 0; i < s->numRaggiunti; i++) {
+        nodo = s->ordine[i];
+        tabella = (struct llTabella *)allocaMemoria(&arenaTabelle, sizeof(struct llTabella));
+        tabella->riga.nextHop = s->nextHop[nodo];
+        tabella->riga.destinazione = nodo;
+        tabella->riga.costo = s->distanza[nodo];
+        tabella->next = NULL;
+        *coda = tabella;
+        coda = &tabella->next;
+    }
+    return testa;
+}
+
+/*
+ * Funzione che alloca lo stato per costruire le tabelle di un grafo con
+ * numNodi nodi. Lo stesso stato può essere riusato per più tabelle.
+ */
+void creaStato(struct statoTabella *s, int numNodi) {
+    creaStatoArena(s, numNodi, NULL);
+}
+
+/*
+ * Come creaStato, ma la memoria viene presa dall'arena a (se non è NULL) e
+ * non va liberata con liberaStato
+ */
+void creaStatoArena(struct statoTabella *s, int numNodi, struct arena *a) {
+    int i;
+
+    s->distanza = (int *)allocaMemoria(a, (numNodi + 1) * sizeof(int));
+    s->nextHop = (int *)allocaMemoria(a, (numNodi + 1) * sizeof(int));
+    s->precedente = (int *)allocaMemoria(a, (numNodi + 1) * sizeof(int));
+    s->ordine = (int *)allocaMemoria(a, (numNodi + 1) * sizeof(int));
+    for(i = 0; i < numNodi; i++)
+        s->distanza[i] = INT_MAX;
+    s->numRaggiunti = 0;
+    s->numNodi = numNodi;
+    creaHeap(&s->coda, numNodi, a);
+    s->bucket.testa = (int *)allocaMemoria(a, LIMITE_DIAL * sizeof(int));
+    for(i = 0; i < LIMITE_DIAL; i++)
+        s->bucket.testa[i] = -1;
+    s->bucket.dimensione = 0;
+}
+
+/*
+ * Funzione che libera la memoria dello stato di una tabella
+ */
+void liberaStato(struct statoTabella *s) {
+    free(s->distanza);
+    free(s->nextHop);
+    free(s->precedente);
+    free(s->ordine);
+    liberaHeap(&s->coda);
+    free(s->bucket.testa);
+}
+
+/*
+ * Algoritmo di Dijkstra: calcola costo, next hop e nodo precedente di ogni
+ * destinazione raggiungibile da start.
+ *
+ * @param g grafo in formato CSR
+ * @param start ID del router di partenza
+ * @param s stato in cui salvare il risultato, quello della tabella precedente
+ *          viene azzerato qui
+ */
+void calcolaTabella(const struct csr *g, int start, struct statoTabella *s) {
+    int costo, nodo, arrivo, i, piccoCoda = 1, dimensione;
+    int tipo = s->bucket.testa != NULL ? tipoCoda(g) : CODA_HEAP;
+    /* Contatori locali, costano poco e vengono salvati solo alla fine */
+    long long estratti = 0, rilassati = 0, aggiornamenti = 0;
+    double inizio = formatoStatistiche != STATISTICHE_SPENTE ? secondi() : 0;
+
+    /* Vengono azzerati solo i nodi raggiunti dalla tabella precedente */
+    for(i = 0; i < s->numRaggiunti; i++)
+        s->distanza[s->ordine[i]] = INT_MAX;
+
+    /* Inserimento primo elemento nella tabella e nella priority queue */
+    s->distanza[start] = 0;
+    s->nextHop[start] = start;
+    s->precedente[start] = start;
+    s->ordine[0] = start;
+    s->numRaggiunti = 1;
+    if(tipo == CODA_HEAP) {
+        inserisciHeap(&s->coda, start, 0);
+    } else {
+        preparaBucket(s, tipo, g);
+        inserisciBucket(s, tipo, start);
+    }
+
+    while((tipo == CODA_HEAP ? s->coda.dimensione : s->bucket.dimensione) > 0) {
+        /* Viene estratto il nodo con costo minore, da qui in poi il suo costo
+           non può più cambiare */
+        nodo = tipo == CODA_HEAP ? estraiMinimo(&s->coda) : estraiBucket(s, tipo);
+        estratti++;
+        rilassati += g->offset[nodo + 1] - g->offset[nodo];
+        /* In questo for i nodi direttamente connessi a quello preso in considerazione
+           vengono inseriti nella tabella o se già presenti vengono confrontati
+           con il percorso già esistente, gli archi uscenti dal nodo sono
+           contigui nel CSR */
+        for(i = g->offset[nodo]; i < g->offset[nodo + 1]; i++) {
+            arrivo = g->arrivo[i];
+            costo = s->distanza[nodo] + g->costo[i];
+            if(costo >= s->distanza[arrivo])
+                continue;
+            /* Se il nodo di destinazione non è già presente nella tabella viene
+               inserito per la prima volta */
+            if(s->distanza[arrivo] == INT_MAX)
+                s->ordine[s->numRaggiunti++] = arrivo;
+            s->distanza[arrivo] = costo;
+            s->precedente[arrivo] = nodo;
+            /* Se la destinazione è direttamente connessa al router di partenza
+               allora la destinazione stessa è il next hop */
+            s->nextHop[arrivo] = nodo == start ? arrivo : s->nextHop[nodo];
+            if(tipo == CODA_HEAP) {
+                inserisciHeap(&s->coda, arrivo, costo);
+                dimensione = s->coda.dimensione;
+            } else {
+                inserisciBucket(s, tipo, arrivo);
+                dimensione = s->bucket.dimensione;
+            }
+            aggiornamenti++;
+            if(dimensione > piccoCoda)
+                piccoCoda = dimensione;
+        }
+    }
+
+    if(formatoStatistiche != STATISTICHE_SPENTE) {
+        memset(&s->contatori, 0, sizeof(s->contatori));
+        s->contatori.tabelle = 1;
+        s->contatori.nodiEstratti = estratti;
+        s->contatori.archiRilassati = rilassati;
+        /* Ogni aggiornamento è un inserimento (nodo raggiunto per la prima
+           volta) oppure un decrease-key */
+        s->contatori.decreaseKey = aggiornamenti - (s->numRaggiunti - 1);
+        s->contatori.piccoCoda = piccoCoda;
+        s->contatori.calcolo = secondi() - inizio;
+    }
+}
+
+/*
+ * Funzione che calcola il costo minimo e massimo degli archi del CSR, usati
+ * per scegliere la coda di calcolaTabella
+ *
+ * @param g grafo in formato CSR appena costruito o caricato
+ */
+void aggiornaCostiEstremi(struct csr *g) {
+    int i;
+
+    g->costoMinimo = g->numArchi > 0 ? g->costo[0] : 0;
+    g->costoMassimo = 0;
+    for(i = 0; i < g->numArchi; i++) {
+        if(g->costo[i] < g->costoMinimo)
+            g->costoMinimo = g->costo[i];
+        if(g->costo[i] > g->costoMassimo)
+            g->costoMassimo = g->costo[i];
+    }
+}
+
+/*
+ * Funzione che allarga i costi estremi del CSR per un arco corretto sul
+ * posto. Quando un arco viene tolto non si stringono: restano più larghi
+ * del vero fino alla prossima ricostruzione, e servono solo a scegliere la
+ * coda e gli algoritmi adatti.
+ *
+ * @param g grafo in formato CSR
+ * @param costo costo dell'arco aggiunto o cambiato
+ */
+void allargaCostiEstremi(struct csr *g, int costo) {
+    if(costo < g->costoMinimo)
+        g->costoMinimo = costo;
+    if(costo > g->costoMassimo)
+        g->costoMassimo = costo;
+}
+
+/*
+ * Funzione che sceglie la priority queue di calcolaTabella: le code a bucket
+ * richiedono costi non negativi (le priorità estratte non diminuiscono mai),
+ * la coda di Dial anche un costo massimo piccolo
+ *
+ * @param g grafo in formato CSR
+ * @return CODA_HEAP, CODA_DIAL oppure CODA_RADIX
+ */
+int tipoCoda(const struct csr *g) {
+    if(g->costoMinimo < 0)
+        return CODA_HEAP;
+    if(codaForzata != -1)
+        return codaForzata == CODA_DIAL && g->costoMassimo >= LIMITE_DIAL ? CODA_RADIX : codaForzata;
+    return g->costoMassimo < LIMITE_DIAL ? CODA_DIAL : CODA_RADIX;
+}
+
+/*
+ * Funzione che restituisce il nome di una priority queue, per i messaggi
+ */
+const char *nomeCoda(int tipo) {
+    if(tipo == CODA_DIAL)
+        return "coda di Dial";
+    if(tipo == CODA_RADIX)
+        return "radix heap";
+    return ARIETA_HEAP == 2 ? "heap binario" : ARIETA_HEAP == 4 ? "heap 4-ario" : "heap 8-ario";
+}
+
+/*
+ * Funzione che prepara la coda a bucket vuota per una nuova tabella. Alla
+ * fine di calcolaTabella la coda è sempre vuota, quindi i bucket sono già
+ * tutti a -1
+ *
+ * @param s stato della tabella
+ * @param tipo CODA_DIAL oppure CODA_RADIX
+ * @param g grafo in formato CSR
+ */
+void preparaBucket(struct statoTabella *s, int tipo, const struct csr *g) {
+    s->bucket.numBucket = tipo == CODA_DIAL ? g->costoMassimo + 1 : BUCKET_RADIX;
+    s->bucket.base = 0;
+    s->bucket.dimensione = 0;
+}
+
+/*
+ * Funzione che aggiunge un nodo in testa alla lista del bucket b
+ */
+void collegaBucket(struct statoTabella *s, int nodo, int b) {
+    int testa = s->bucket.testa[b];
+
+    s->coda.nodi[nodo] = testa;
+    s->coda.valori[nodo] = -1;
+    if(testa != -1)
+        s->coda.valori[testa] = nodo;
+    s->bucket.testa[b] = nodo;
+    s->coda.posizione[nodo] = b;
+}
+
+/*
+ * Funzione che toglie un nodo dalla lista del suo bucket
+ */
+void scollegaBucket(struct statoTabella *s, int nodo) {
+    int successivo = s->coda.nodi[nodo], precedente = s->coda.valori[nodo];
+
+    if(precedente != -1)
+        s->coda.nodi[precedente] = successivo;
+    else
+        s->bucket.testa[s->coda.posizione[nodo]] = successivo;
+    if(successivo != -1)
+        s->coda.valori[successivo] = precedente;
+}
+
+/*
+ * Funzione che calcola il bucket di una priorità: nella coda di Dial è il
+ * resto della divisione per il numero di bucket, nel radix heap è il numero
+ * di bit fino al più alto in cui la priorità differisce da base
+ */
+int indiceBucket(const struct statoTabella *s, int tipo, int valore) {
+    if(tipo == CODA_DIAL)
+        return valore % s->bucket.numBucket;
+    if(valore == s->bucket.base)
+        return 0;
+    return 32 - __builtin_clz((unsigned int)(valore ^ s->bucket.base));
+}
+
+/*
+ * Funzione per aggiungere un nodo alla coda a bucket con priorità uguale alla
+ * sua distanza, se è già presente viene spostato nel bucket giusto
+ * (decrease-key in O(1))
+ *
+ * @param s stato della tabella, la distanza del nodo è già aggiornata
+ * @param tipo CODA_DIAL oppure CODA_RADIX
+ * @param nodo ID nodo
+ */
+void inserisciBucket(struct statoTabella *s, int tipo, int nodo) {
+    if(s->coda.posizione[nodo] != -1)
+        scollegaBucket(s, nodo);
+    else
+        s->bucket.dimensione++;
+    collegaBucket(s, nodo, indiceBucket(s, tipo, s->distanza[nodo]));
+}
+
+/*
+ * Funzione che rimuove dalla coda a bucket un nodo con priorità minima. Nella
+ * coda di Dial si avanza fino al primo bucket non vuoto; nel radix heap, se
+ * il bucket 0 è vuoto, il primo bucket non vuoto viene ridistribuito rispetto
+ * al suo minimo e ogni nodo finisce in un bucket più basso, quindi ogni nodo
+ * viene spostato al massimo 32 volte
+ *
+ * @param s stato della tabella con la coda non vuota
+ * @param tipo CODA_DIAL oppure CODA_RADIX
+ * @return ID del nodo estratto
+ */
+int estraiBucket(struct statoTabella *s, int tipo) {
+    struct codaBucket *q = &s->bucket;
+    int b, nodo, successivo;
+
+    if(tipo == CODA_DIAL) {
+        b = q->base % q->numBucket;
+        while(q->testa[b] == -1) {
+            q->base++;
+            if(++b == q->numBucket)
+                b = 0;
+        }
+    } else {
+        b = 0;
+        if(q->testa[0] == -1) {
+            for(b = 1; q->testa[b] == -1; b++)
+                ;
+            /* Il minimo del bucket diventa la nuova base */
+            q->base = INT_MAX;
+            for(nodo = q->testa[b]; nodo != -1; nodo = s->coda.nodi[nodo])
+                if(s->distanza[nodo] < q->base)
+                    q->base = s->distanza[nodo];
+            nodo = q->testa[b];
+            q->testa[b] = -1;
+            while(nodo != -1) {
+                successivo = s->coda.nodi[nodo];
+                collegaBucket(s, nodo, indiceBucket(s, tipo, s->distanza[nodo]));
+                nodo = successivo;
+            }
+            b = 0;
+        }
+    }
+    nodo = q->testa[b];
+    scollegaBucket(s, nodo);
+    s->coda.posizione[nodo] = -1;
+    q->dimensione--;
+    return nodo;
+}
+
+/*
+ * Funzione che alloca un heap vuoto in grado di contenere tutti i nodi
+ *
+ * @param h heap da inizializzare
+ * @param numNodi numero di nodi del grafo
+ * @param a arena da cui prendere la memoria, NULL per usare malloc
+ */
+void creaHeap(struct heap *h, int numNodi, struct arena *a) {
+    int i;
+
+    h->nodi = (int *)allocaMemoria(a, (numNodi + 1) * sizeof(int));
+    h->valori = (int *)allocaMemoria(a, (numNodi + 1) * sizeof(int));
+    h->posizione = (int *)allocaMemoria(a, (numNodi + 1) * sizeof(int));
+    for(i = 0; i < numNodi; i++)
+        h->posizione[i] = -1;
+    h->dimensione = 0;
+}
+
+/*
+ * Funzione che libera la memoria di un heap
+ */
+void liberaHeap(struct heap *h) {
+    free(h->nodi);
+    free(h->valori);
+    free(h->posizione);
+}
+
+/*
+ * Funzione che sposta verso la radice l'elemento in posizione i finché
+ * il padre ha un valore maggiore
+ */
+void heapSali(struct heap *h, int i) {
+    int nodo = h->nodi[i], valore = h->valori[i], padre;
+
+    while(i > 0) {
+        padre = (i - 1) / ARIETA_HEAP;
+        if(h->valori[padre] <= valore)
+            break;
+        h->nodi[i] = h->nodi[padre];
+        h->valori[i] = h->valori[padre];
+        h->posizione[h->nodi[i]] = i;
+        i = padre;
+    }
+    h->nodi[i] = nodo;
+    h->valori[i] = valore;
+    h->posizione[nodo] = i;
+}
+
+/*
+ * Funzione che sposta verso le foglie l'elemento in posizione i finché
+ * ha un figlio con valore minore
+ */
+void heapScendi(struct heap *h, int i) {
+    int nodo = h->nodi[i], valore = h->valori[i], figlio, minimo, j, fine;
+
+    for(;;) {
+        figlio = i * ARIETA_HEAP + 1;
+        if(figlio >= h->dimensione)
+            break;
+        /* Ricerca del figlio con valore minore */
+        minimo = figlio;
+        fine = figlio + ARIETA_HEAP < h->dimensione ? figlio + ARIETA_HEAP : h->dimensione;
+        for(j = figlio + 1; j < fine; j++)
+            if(h->valori[j] < h->valori[minimo])
+                minimo = j;
+        if(h->valori[minimo] >= valore)
+            break;
+        h->nodi[i] = h->nodi[minimo];
+        h->valori[i] = h->valori[minimo];
+        h->posizione[h->nodi[i]] = i;
+        i = minimo;
+    }
+    h->nodi[i] = nodo;
+    h->valori[i] = valore;
+    h->posizione[nodo] = i;
+}
+
+/*
+ * Funzione per aggiungere un elemento nella priority queue, se il nodo è
+ * già presente la sua priorità viene abbassata (decrease-key)
+ *
+ * @param h heap
+ * @param nodo ID nodo
+ * @param valore costo da start fino al nodo, per determinare la priorità
+ */
+void inserisciHeap(struct heap *h, int nodo, int valore) {
+    int i = h->posizione[nodo];
+
+    if(i == -1) {
+        i = h->dimensione++;
+        h->nodi[i] = nodo;
+    }
+    /* La funzione viene richiamata solo se si trova un percorso più corto per
+       il nodo, quindi l'elemento può solo salire */
+    h->valori[i] = valore;
+    heapSali(h, i);
+}
+
+/*
+ * Funzione che rimuove dalla priority queue il nodo con valore minore
+ *
+ * @param h heap non vuoto
+ * @return ID del nodo estratto
+ */
+int estraiMinimo(struct heap *h) {
+    int minimo = h->nodi[0];
+
+    h->posizione[minimo] = -1;
+    h->dimensione--;
+    if(h->dimensione > 0) {
+        h->nodi[0] = h->nodi[h->dimensione];
+        h->valori[0] = h->valori[h->dimensione];
+        heapScendi(h, 0);
+    }
+    return minimo;
+}
+
+/*
+ * Funzione che alloca lo stato del calcolo multi-sorgente, i vettori sono
+ * allineati alla loro dimensione per le load e store SIMD
+ *
+ * @param m stato da inizializzare
+ * @param numNodi numero di nodi del grafo
+ */
+void creaStatoMultiplo(struct statoMultiplo *m, int numNodi) {
+    size_t dimensione = (size_t)(numNodi + 1) * sizeof(corsie);
+
+    m->numNodi = numNodi;
+    m->distanza = (corsie *)aligned_alloc(sizeof(corsie), dimensione);
+    m->nextHop = (corsie *)aligned_alloc(sizeof(corsie), dimensione);
+    contaAllocazione(2 * dimensione);
+    creaHeap(&m->coda, numNodi, NULL);
+}
+
+/*
+ * Funzione che libera la memoria dello stato multi-sorgente
+ */
+void liberaStatoMultiplo(struct statoMultiplo *m) {
+    free(m->distanza);
+    free(m->nextHop);
+    liberaHeap(&m->coda);
+}
+
+/*
+ * Calcolo di più tabelle in una sola visita: ogni nodo estratto rilassa i
+ * suoi archi per tutte le sorgenti insieme, così la lista di adiacenza viene
+ * letta una volta per NUM_CORSIE tabelle invece che una per tabella. Un nodo
+ * torna in coda quando almeno una delle sue distanze si abbassa, con
+ * priorità uguale alla minore distanza abbassata; quando la coda è vuota
+ * nessuna distanza può più migliorare. Richiede costi non negativi.
+ * Le tabelle sono le stesse di calcolaTabella tranne l'ordine delle righe e,
+ * a parità di costo, il next hop; il precedente non viene calcolato.
+ *
+ * @param g grafo in formato CSR con costi non negativi
+ * @param sorgenti ID dei router di partenza
+ * @param numSorgenti numero di sorgenti, al massimo NUM_CORSIE
+ * @param m stato multi-sorgente
+ * @param stati stato in cui salvare la tabella di ogni sorgente
+ */
+void calcolaTabelleMultiple(const struct csr *g, const int *sorgenti, int numSorgenti, struct statoMultiplo *m, struct statoTabella *stati) {
+    const corsie infinito = (corsie){0} + INT_MAX, nessuno = (corsie){0} + UINT_MAX;
+    corsie origine = nessuno, distanzaNodo, hopNodo, nuova, vecchia, migliore, candidati, nuove, prima, hop;
+    unsigned int chiave;
+    int nodo, arrivo, i, l, estratti = 0, rilassati = 0, aggiornamenti = 0;
+    double inizio = formatoStatistiche != STATISTICHE_SPENTE ? secondi() : 0;
+    struct statoTabella *s;
+
+    for(i = 0; i < g->numNodi; i++)
+        m->distanza[i] = infinito;
+    for(l = 0; l < numSorgenti; l++) {
+        s = &stati[l];
+        for(i = 0; i < s->numRaggiunti; i++)
+            s->distanza[s->ordine[i]] = INT_MAX;
+        origine[l] = sorgenti[l];
+        m->distanza[sorgenti[l]][l] = 0;
+        m->nextHop[sorgenti[l]][l] = sorgenti[l];
+        s->ordine[0] = sorgenti[l];
+        s->numRaggiunti = 1;
+        inserisciHeap(&m->coda, sorgenti[l], 0);
+    }
+
+    while(m->coda.dimensione > 0) {
+        nodo = estraiMinimo(&m->coda);
+        estratti++;
+        rilassati += g->offset[nodo + 1] - g->offset[nodo];
+        distanzaNodo = m->distanza[nodo];
+        /* Per le sorgenti di cui nodo è la partenza il next hop è l'arrivo */
+        hopNodo = m->nextHop[nodo];
+        prima = (corsie)(origine == (corsie){0} + (unsigned int)nodo);
+        for(i = g->offset[nodo]; i < g->offset[nodo + 1]; i++) {
+            arrivo = g->arrivo[i];
+            /* Con gli unsigned INT_MAX + costo resta maggiore di ogni distanza */
+            nuova = distanzaNodo + (unsigned int)g->costo[i];
+            vecchia = m->distanza[arrivo];
+            migliore = (corsie)(nuova < vecchia);
+            /* Minimo delle distanze abbassate: le corsie non migliorate
+               valgono UINT_MAX */
+            candidati = nuova | ~migliore;
+            chiave = candidati[0];
+            for(l = 1; l < NUM_CORSIE; l++)
+                chiave = candidati[l] < chiave ? candidati[l] : chiave;
+            if(chiave == UINT_MAX)
+                continue;
+            aggiornamenti++;
+            /* Destinazioni raggiunte per la prima volta in qualche corsia */
+            nuove = migliore & (corsie)(vecchia == infinito);
+            for(l = 0; l < numSorgenti; l++)
+                if(nuove[l])
+                    stati[l].ordine[stati[l].numRaggiunti++] = arrivo;
+            m->distanza[arrivo] = (nuova & migliore) | (vecchia & ~migliore);
+            hop = (((corsie){0} + (unsigned int)arrivo) & prima) | (hopNodo & ~prima);
+            m->nextHop[arrivo] = (hop & migliore) | (m->nextHop[arrivo] & ~migliore);
+            /* La priorità di un nodo già in coda può solo scendere */
+            if(m->coda.posizione[arrivo] == -1 || (int)chiave < m->coda.valori[m->coda.posizione[arrivo]])
+                inserisciHeap(&m->coda, arrivo, (int)chiave);
+        }
+    }
+
+    for(l = 0; l < numSorgenti; l++) {
+        s = &stati[l];
+        for(i = 0; i < s->numRaggiunti; i++) {
+            nodo = s->ordine[i];
+            s->distanza[nodo] = (int)m->distanza[nodo][l];
+            s->nextHop[nodo] = (int)m->nextHop[nodo][l];
+        }
+        /* I contatori sono della visita comune, divisi tra le sorgenti */
+        if(formatoStatistiche != STATISTICHE_SPENTE) {
+            memset(&s->contatori, 0, sizeof(s->contatori));
+            s->contatori.tabelle = 1;
+            s->contatori.nodiEstratti = estratti / numSorgenti;
+            s->contatori.archiRilassati = rilassati / numSorgenti;
+            s->contatori.decreaseKey = aggiornamenti / numSorgenti;
+            s->contatori.calcolo = (secondi() - inizio) / numSorgenti;
+        }
+    }
+}
+
+/*
+ * Funzione che decide se conviene calcolare tutte le tabelle con
+ * Floyd-Warshall: la rete deve essere piccola (le matrici sono di
+ * numNodi^2 elementi), densa, con costi non negativi e abbastanza piccoli
+ * perché nessun percorso arrivi a INFINITO_FW, e servono le tabelle di quasi
+ * tutti i router
+ *
+ * @param g grafo in formato CSR
+ * @param numSorgenti numero di tabelle richieste
+ * @return true se usare la matrice
+ */
+bool usaMatrice(const struct csr *g, int numSorgenti) {
+    if(g->costoMinimo < 0 || g->numNodi > LIMITE_NODI_FW || sceltaMatrice == MATRICE_NO
+       || (long long)g->costoMassimo * g->numNodi >= INFINITO_FW)
+        return false;
+    if(sceltaMatrice == MATRICE_SI)
+        return true;
+    return 2 * numSorgenti >= g->numNodi && (long long)g->numArchi * DENSITA_FW >= (long long)g->numNodi * g->numNodi;
+}
+
+/*
+ * Funzione che crea le matrici di distanze e next hop con i soli archi
+ * diretti (a parità di partenza e arrivo il più economico). Le righe sono
+ * lunghe lato, multiplo di BLOCCO_FW, e allineate per le istruzioni SIMD.
+ *
+ * @param m matrice da inizializzare
+ * @param g grafo in formato CSR con costi non negativi
+ */
+void creaMatrice(struct matriceFW *m, const struct csr *g) {
+    size_t dimensione;
+    int i, j;
+
+    m->numNodi = g->numNodi;
+    m->lato = (g->numNodi + BLOCCO_FW - 1) / BLOCCO_FW * BLOCCO_FW;
+    if(m->lato == 0)
+        m->lato = BLOCCO_FW;
+    dimensione = (size_t)m->lato * m->lato * sizeof(int);
+    m->distanza = (int *)aligned_alloc(sizeof(corsieSegno), dimensione);
+    m->nextHop = (int *)aligned_alloc(sizeof(corsieSegno), dimensione);
+    contaAllocazione(2 * dimensione);
+    for(i = 0; i < m->lato; i++) {
+        for(j = 0; j < m->lato; j++)
+            m->distanza[(size_t)i * m->lato + j] = INFINITO_FW;
+        if(i < m->numNodi) {
+            m->distanza[(size_t)i * m->lato + i] = 0;
+            m->nextHop[(size_t)i * m->lato + i] = i;
+        }
+    }
+    for(i = 0; i < g->numNodi; i++) {
+        for(j = g->offset[i]; j < g->offset[i + 1]; j++) {
+            if(g->costo[j] < m->distanza[(size_t)i * m->lato + g->arrivo[j]]) {
+                m->distanza[(size_t)i * m->lato + g->arrivo[j]] = g->costo[j];
+                m->nextHop[(size_t)i * m->lato + g->arrivo[j]] = g->arrivo[j];
+            }
+        }
+    }
+}
+
+/*
+ * Funzione che libera la memoria delle matrici
+ */
+void liberaMatrice(struct matriceFW *m) {
+    free(m->distanza);
+    free(m->nextHop);
+}
+
+/*
+ * Funzione che aggiorna il blocco (bi, bj) passando per i nodi intermedi
+ * del blocco bk: distanza[i][j] = min(distanza[i][j], distanza[i][k] +
+ * distanza[k][j]), e se migliora il next hop diventa quello verso k. Le
+ * colonne j vengono elaborate un registro SIMD alla volta; la somma con un
+ * INFINITO_FW è almeno INFINITO_FW e non migliora mai niente.
+ *
+ * @param m matrice
+ * @param bi blocco di righe
+ * @param bj blocco di colonne
+ * @param bk blocco dei nodi intermedi
+ */
+void aggiornaBloccoFW(struct matriceFW *m, int bi, int bj, int bk) {
+    const corsieSegno *rigaK;
+    corsieSegno *riga, *hop, viaK, hopK, nuova, migliore;
+    int distanzaK;
+    int i, j, k;
+
+    /* k resta il ciclo esterno: nei blocchi della riga e della colonna di bk
+       (e in quello diagonale) distanza[i][k] o distanza[k][j] cambiano
+       mentre il blocco viene aggiornato */
+    for(k = bk * BLOCCO_FW; k < (bk + 1) * BLOCCO_FW; k++) {
+        rigaK = (const corsieSegno *)&m->distanza[(size_t)k * m->lato + bj * BLOCCO_FW];
+        for(i = bi * BLOCCO_FW; i < (bi + 1) * BLOCCO_FW; i++) {
+            distanzaK = m->distanza[(size_t)i * m->lato + k];
+            if(distanzaK == INFINITO_FW)
+                continue;
+            riga = (corsieSegno *)&m->distanza[(size_t)i * m->lato + bj * BLOCCO_FW];
+            hop = (corsieSegno *)&m->nextHop[(size_t)i * m->lato + bj * BLOCCO_FW];
+            viaK = (corsieSegno){0} + distanzaK;
+            hopK = (corsieSegno){0} + m->nextHop[(size_t)i * m->lato + k];
+            for(j = 0; j < BLOCCO_FW * (int)sizeof(int) / BYTE_SIMD; j++) {
+                nuova = viaK + rigaK[j];
+                migliore = nuova < riga[j];
+                riga[j] = (nuova & migliore) | (riga[j] & ~migliore);
+                hop[j] = (hopK & migliore) | (hop[j] & ~migliore);
+            }
+        }
+    }
+}
+
+/*
+ * Funzione eseguita da ogni thread di Floyd-Warshall. Per ogni blocco bk
+ * di nodi intermedi: il blocco diagonale (un thread), poi i blocchi della
+ * sua riga e della sua colonna, poi tutti gli altri; i blocchi di ogni fase
+ * sono indipendenti e vengono divisi tra i thread, le fasi sono separate
+ * da una barriera
+ *
+ * @param argomento struct matriceFW condivisa
+ */
+void *threadFW(void *argomento) {
+    struct matriceFW *m = (struct matriceFW *)argomento;
+    int t = __atomic_fetch_add(&m->numAvviati, 1, __ATOMIC_RELAXED);
+    int numBlocchi = m->lato / BLOCCO_FW, altri = numBlocchi - 1, bk, x, bi, bj;
+
+    for(bk = 0; bk < numBlocchi; bk++) {
+        if(t == 0)
+            aggiornaBloccoFW(m, bk, bk, bk);
+        pthread_barrier_wait(&m->barriera);
+        for(x = t; x < 2 * altri; x += m->numThread) {
+            bi = x % altri;
+            bi += bi >= bk;
+            if(x < altri)
+                aggiornaBloccoFW(m, bk, bi, bk);
+            else
+                aggiornaBloccoFW(m, bi, bk, bk);
+        }
+        pthread_barrier_wait(&m->barriera);
+        for(x = t; x < altri * altri; x += m->numThread) {
+            bi = x / altri;
+            bj = x % altri;
+            aggiornaBloccoFW(m, bi + (bi >= bk), bj + (bj >= bk), bk);
+        }
+        pthread_barrier_wait(&m->barriera);
+    }
+    return NULL;
+}
+
+/*
+ * Floyd-Warshall a blocchi: calcola distanze e next hop di tutte le coppie
+ * di router in O(V^3) operazioni, ma vettoriali e su blocchi che stanno in
+ * cache, quindi su reti piccole e dense è più veloce di V Dijkstra
+ *
+ * @param m matrice da calcolare
+ * @param g grafo in formato CSR con costi non negativi
+ * @param numThread numero di thread da usare
+ */
+void calcolaMatrice(struct matriceFW *m, const struct csr *g, int numThread) {
+    pthread_t *thread;
+    int i;
+    double inizio = secondi();
+
+    creaMatrice(m, g);
+    m->numThread = numThread > 1 ? numThread : 1;
+    m->numAvviati = 0;
+    pthread_barrier_init(&m->barriera, NULL, m->numThread);
+    thread = (pthread_t *)malloc(m->numThread * sizeof(pthread_t));
+    for(i = 1; i < m->numThread; i++)
+        pthread_create(&thread[i], NULL, threadFW, m);
+    threadFW(m);
+    for(i = 1; i < m->numThread; i++)
+        pthread_join(thread[i], NULL);
+    free(thread);
+    pthread_barrier_destroy(&m->barriera);
+    m->tempo = secondi() - inizio;
+}
+
+/*
+ * Funzione che copia nello stato di una tabella la riga della matrice di
+ * un router, le destinazioni in ordine di ID. Il precedente non è noto.
+ *
+ * @param m matrice calcolata
+ * @param start ID del router di partenza
+ * @param s stato in cui salvare la tabella
+ */
+void tabellaDaMatrice(const struct matriceFW *m, int start, struct statoTabella *s) {
+    const int *distanza = &m->distanza[(size_t)start * m->lato];
+    const int *nextHop = &m->nextHop[(size_t)start * m->lato];
+    int i;
+
+    for(i = 0; i < s->numRaggiunti; i++)
+        s->distanza[s->ordine[i]] = INT_MAX;
+    s->ordine[0] = start;
+    s->numRaggiunti = 1;
+    for(i = 0; i < m->numNodi; i++) {
+        if(distanza[i] >= INFINITO_FW)
+            continue;
+        if(i != start)
+            s->ordine[s->numRaggiunti++] = i;
+        s->distanza[i] = distanza[i];
+        s->nextHop[i] = nextHop[i];
+        s->precedente[i] = -1;
+    }
+    if(formatoStatistiche != STATISTICHE_SPENTE) {
+        /* Il tempo di Floyd-Warshall viene diviso tra le tabelle */
+        memset(&s->contatori, 0, sizeof(s->contatori));
+        s->contatori.tabelle = 1;
+        s->contatori.calcolo = m->tempo / m->numNodi;
+    }
+}
+
+/**
+ * Funzione per rimuovere un router dalla rete
+ */
+bool rimuoviConnessione() {
+    char *rPartenza, *rArrivo;
+    int idPartenza, idArrivo, costo;
+
+    /* Inserimento dati della connessione da rimuovere */
+    printf("Rimozione connessione:\n");
+    printf("Inserisci router di partenza: ");
+    rPartenza = leggiParola();
+    printf("Inserisci router di arrivo: ");
+    rArrivo = leggiParola();
+    if(rPartenza == NULL || rArrivo == NULL)
+        exit(EXIT_SUCCESS);
+    idPartenza = cercaNome(rPartenza);
+    idArrivo = cercaNome(rArrivo);
+    free(rPartenza);
+    free(rArrivo);
+
+    if(idPartenza >= 0 && idArrivo >= 0 && rimuoviArco(idPartenza, idArrivo, &costo)) {
+        printf("\nConnessione rimossa con successo!\n");
+        stampaAggiornamento(aggiornaAlberi(idPartenza, idArrivo, costo, INT_MAX));
+        return true;
+    }
+    printf("\nConnessione non esistente!\n");
+    return false;
+}
+
+/*
+ * Funzione che libera la memoria delle tabelle di instradamento: le righe
+ * sono nell'arena delle tabelle, che viene svuotata in O(1)
+ */
+void liberaTabella() {
+    resetArena(&arenaTabelle);
+}
+
+/*
+ * Funzione che prende n byte da un'arena. La memoria viene restituita tutta
+ * insieme con resetArena, i blocchi restano all'arena e vengono riusati.
+ *
+ * @param a arena
+ * @param n numero di byte
+ * @return memoria allineata a 16 byte
+ */
+void *allocaArena(struct arena *a, size_t n) {
+    struct bloccoArena *nuovo;
+    size_t dimensione;
+    void *p;
+
+    n = (n + 15) & ~(size_t)15;
+    /* Si passa ai blocchi successivi già allocati finché c'è spazio */
+    while(a->attuale != NULL && a->attuale->usati + n > a->attuale->dimensione && a->attuale->next != NULL) {
+        a->attuale = a->attuale->next;
+        a->attuale->usati = 0;
+    }
+    if(a->attuale == NULL || a->attuale->usati + n > a->attuale->dimensione) {
+        dimensione = a->attuale == NULL ? 1 << 16 : 2 * a->attuale->dimensione;
+        if(dimensione < n)
+            dimensione = n;
+        nuovo = (struct bloccoArena *)malloc(sizeof(struct bloccoArena) + dimensione);
+        nuovo->dimensione = dimensione;
+        nuovo->usati = 0;
+        nuovo->next = NULL;
+        if(a->attuale == NULL)
+            a->primo = nuovo;
+        else
+            a->attuale->next = nuovo;
+        a->attuale = nuovo;
+        a->allocati += dimensione;
+    }
+    p = a->attuale->dati + a->attuale->usati;
+    a->attuale->usati += n;
+    return p;
+}
+
+/*
+ * Funzione che libera in O(1) tutta la memoria presa da un'arena
+ */
+void resetArena(struct arena *a) {
+    a->attuale = a->primo;
+    if(a->primo != NULL)
+        a->primo->usati = 0;
+}
+
+/*
+ * Funzione che restituisce la memoria dall'arena se c'è, altrimenti con malloc
+ */
+void *allocaMemoria(struct arena *a, size_t n) {
+    contaAllocazione(n);
+    return a != NULL ? allocaArena(a, n) : malloc(n);
+}
+
+/*
+ * Funzione che legge un valore in kB da /proc/self/status (solo Linux)
+ *
+ * @param campo nome del campo, ad esempio "VmRSS:"
+ * @return valore in kB, -1 se non disponibile
+ */
+long leggiMemoriaProcesso(const char *campo) {
+    char riga[256];
+    long valore = -1;
+    FILE *fl = fopen("/proc/self/status", "r");
+
+    if(fl == NULL)
+        return -1;
+    while(fgets(riga, sizeof(riga), fl) != NULL)
+        if(strncmp(riga, campo, strlen(campo)) == 0)
+            valore = atol(riga + strlen(campo));
+    fclose(fl);
+    return valore;
+}
+
+/*
+ * Funzione che stampa quanta memoria usa il programma, divisa per strutture
+ */
+void stampaMemoria() {
+    const struct csr *g = aggiornaCSR();
+    size_t csr = 0;
+
+    if(mappa.dati == NULL)
+        csr = (size_t)(g->numNodi + 1) * sizeof(int) + (size_t)(g->numArchi + 1) * 2 * sizeof(int);
+    if(rete.entrateValide)
+        csr *= 2;
+    printf("Memoria:\n");
+    printf("Nomi dei router: %.1f MB\n", (nomi.capacitaCaratteri + nomi.capacitaNomi * sizeof(size_t)
+           + nomi.capacitaSlot * (sizeof(int) + sizeof(unsigned int))) / 1048576.0);
+    printf("Archi: %d usati, %d liberi da riusare, %.1f MB\n", rete.numArchi, rete.numSlot - rete.numArchi,
+           (rete.capacitaArchi * sizeof(struct arco) + rete.presenti.capacita * (sizeof(unsigned long long) + 2 * sizeof(int))) / 1048576.0);
+    printf("CSR: %.1f MB%s\n", csr / 1048576.0, mappa.dati != NULL ? " (snapshot mappato)" : "");
+    printf("Arene delle tabelle: %.1f MB\n", (arenaTabelle.allocati + arenaScratch.allocati) / 1048576.0);
+    if(leggiMemoriaProcesso("VmRSS:") >= 0)
+        printf("RSS attuale: %.1f MB, picco: %.1f MB\n", leggiMemoriaProcesso("VmRSS:") / 1024.0,
+               leggiMemoriaProcesso("VmHWM:") / 1024.0);
+}
+
+/*
+ * Funzione che somma le statistiche di src a quelle di dest
+ */
+void sommaStatistiche(struct statisticheSPF *dest, const struct statisticheSPF *src) {
+    dest->tabelle += src->tabelle;
+    dest->nodiEstratti += src->nodiEstratti;
+    dest->archiRilassati += src->archiRilassati;
+    dest->decreaseKey += src->decreaseKey;
+    if(src->piccoCoda > dest->piccoCoda)
+        dest->piccoCoda = src->piccoCoda;
+    /* byteAllocati viene aumentato anche fuori dal mutex, da contaAllocazione */
+    __atomic_fetch_add(&dest->byteAllocati, src->byteAllocati, __ATOMIC_RELAXED);
+    dest->caricamento += src->caricamento;
+    dest->costruzione += src->costruzione;
+    dest->calcolo += src->calcolo;
+    dest->stampa += src->stampa;
+}
+
+/*
+ * Funzione che conta i byte allocati per le tabelle, chiamata anche dai
+ * thread della modalità batch: una somma atomica, senza mutex
+ */
+void contaAllocazione(size_t n) {
+    if(formatoStatistiche == STATISTICHE_SPENTE)
+        return;
+    __atomic_fetch_add(&statistiche.byteAllocati, (long long)n, __ATOMIC_RELAXED);
+}
+
+/*
+ * Funzione che stampa una stringa in JSON, con i caratteri speciali escapati
+ */
+void stampaStringaJSON(FILE *fl, const char *stringa) {
+    fputc('"', fl);
+    for(; *stringa != '\0'; stringa++) {
+        if(*stringa == '"' || *stringa == '\\')
+            fprintf(fl, "\\%c", *stringa);
+        else if((unsigned char)*stringa < 0x20)
+            fprintf(fl, "\\u%04x", *stringa);
+        else
+            fputc(*stringa, fl);
+    }
+    fputc('"', fl);
+}
+
+/*
+ * Funzione che stampa le statistiche di una tabella o quelle totali, come
+ * testo leggibile o come un oggetto JSON su una riga
+ *
+ * @param fl file su cui stampare
+ * @param sorgente nome del router della tabella, NULL per il totale
+ * @param st statistiche da stampare
+ */
+void stampaStatistiche(FILE *fl, const char *sorgente, const struct statisticheSPF *st) {
+    if(formatoStatistiche == STATISTICHE_JSON) {
+        fprintf(fl, "{");
+        if(sorgente != NULL) {
+            fprintf(fl, "\"sorgente\":");
+            stampaStringaJSON(fl, sorgente);
+            fprintf(fl, ",");
+        }
+        else
+            fprintf(fl, "\"tabelle\":%lld,\"byteAllocati\":%lld,\"caricamentoS\":%.6f,\"costruzioneCsrS\":%.6f,",
+                    st->tabelle, st->byteAllocati, st->caricamento, st->costruzione);
+        fprintf(fl, "\"nodiEstratti\":%lld,\"archiRilassati\":%lld,\"decreaseKey\":%lld,\"piccoCoda\":%d,"
+                "\"calcoloS\":%.6f,\"stampaS\":%.6f}\n", st->nodiEstratti, st->archiRilassati,
+                st->decreaseKey, st->piccoCoda, st->calcolo, st->stampa);
+        return;
+    }
+    if(sorgente != NULL) {
+        fprintf(fl, "Tabella di %s: %lld nodi estratti, %lld archi rilassati, %lld decrease-key, "
+                "coda max %d, calcolo %.1f us, stampa %.1f us\n", sorgente, st->nodiEstratti,
+                st->archiRilassati, st->decreaseKey, st->piccoCoda, st->calcolo * 1e6, st->stampa * 1e6);
+        return;
+    }
+    fprintf(fl, "Statistiche SPF:\n");
+    fprintf(fl, "Tabelle calcolate: %lld\n", st->tabelle);
+    fprintf(fl, "Nodi estratti dalla coda: %lld\n", st->nodiEstratti);
+    fprintf(fl, "Archi rilassati: %lld\n", st->archiRilassati);
+    fprintf(fl, "Decrease-key: %lld\n", st->decreaseKey);
+    fprintf(fl, "Dimensione massima della coda: %d\n", st->piccoCoda);
+    fprintf(fl, "Byte allocati per le tabelle: %lld\n", st->byteAllocati);
+    fprintf(fl, "Tempi: caricamento %.3f s, costruzione CSR %.3f s, calcolo %.3f s, stampa %.3f s\n",
+            st->caricamento, st->costruzione, st->calcolo, st->stampa);
+}
+
+/*
+ * Funzione che restituisce un tempo in secondi, usata per i benchmark
+ */
+double secondi() {
+    struct timespec t;
+
+    timespec_get(&t, TIME_UTC);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/*
+ * Micro-benchmark della priority queue: carica i file indicati e costruisce
+ * la tabella di ogni router con ogni coda utilizzabile (heap, coda di Dial se
+ * il costo massimo è piccolo, radix heap), con il calcolo multi-sorgente e
+ * con Floyd-Warshall, stampando il tempo medio per tabella e controllando
+ * che tutti trovino gli stessi costi.
+ * Per confrontare le arietà del heap compilare con -DARIETA_HEAP=2, 4 e 8.
+ *
+ * @param numFile numero di file della topologia
+ * @param file nomi dei file
+ * @return codice di uscita del programma
+ */
+int benchHeap(int numFile, char **file) {
+    const struct csr *g;
+    struct statoTabella stato;
+    double inizio, tempo;
+    int i, j, tabelle, tipo, automatica;
+    long long somma, primaSomma = 0;
+    bool diversi = false;
+
+    for(i = 0; i < numFile; i++) {
+        if(!caricaFile(file[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", file[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    g = aggiornaCSR();
+    automatica = tipoCoda(g);
+    printf("%d nodi, %d archi, costi da %d a %d\n", g->numNodi, g->numArchi,
+           g->costoMinimo, g->costoMassimo);
+    /* Lo stato viene riusato, così si misura solo Dijkstra e non le malloc */
+    creaStato(&stato, g->numNodi);
+    for(tipo = CODA_HEAP; tipo <= CODA_RADIX; tipo++) {
+        codaForzata = tipo;
+        if(tipoCoda(g) != tipo)
+            continue;
+        tabelle = 0;
+        somma = 0;
+        inizio = secondi();
+        for(i = 0; i < g->numNodi; i++) {
+            if(containsStart(i)) {
+                calcolaTabella(g, i, &stato);
+                tabelle++;
+                for(j = 0; j < stato.numRaggiunti; j++)
+                    somma += stato.distanza[stato.ordine[j]];
+            }
+        }
+        tempo = secondi() - inizio;
+        if(tipo == CODA_HEAP)
+            primaSomma = somma;
+        else if(somma != primaSomma)
+            diversi = true;
+        printf("%-13s %d tabelle in %.3f s (%.1f us per tabella)%s\n", nomeCoda(tipo),
+               tabelle, tempo, tabelle > 0 ? tempo * 1e6 / tabelle : 0.0,
+               tipo == automatica ? " [scelta automatica]" : "");
+    }
+    codaForzata = -1;
+    liberaStato(&stato);
+
+    /* Le stesse tabelle NUM_CORSIE alla volta con il calcolo multi-sorgente */
+    if(g->costoMinimo >= 0) {
+        struct statoTabella stati[NUM_CORSIE];
+        struct statoMultiplo multiplo;
+        int sorgenti[NUM_CORSIE], numero = 0, l;
+
+        for(l = 0; l < NUM_CORSIE; l++)
+            creaStato(&stati[l], g->numNodi);
+        creaStatoMultiplo(&multiplo, g->numNodi);
+        tabelle = 0;
+        somma = 0;
+        inizio = secondi();
+        for(i = 0; i <= g->numNodi; i++) {
+            if(i < g->numNodi && containsStart(i))
+                sorgenti[numero++] = i;
+            if(numero == NUM_CORSIE || (i == g->numNodi && numero > 0)) {
+                calcolaTabelleMultiple(g, sorgenti, numero, &multiplo, stati);
+                for(l = 0; l < numero; l++)
+                    for(j = 0; j < stati[l].numRaggiunti; j++)
+                        somma += stati[l].distanza[stati[l].ordine[j]];
+                tabelle += numero;
+                numero = 0;
+            }
+        }
+        tempo = secondi() - inizio;
+        if(somma != primaSomma)
+            diversi = true;
+        printf("%d sorgenti  %d tabelle in %.3f s (%.1f us per tabella)\n", NUM_CORSIE,
+               tabelle, tempo, tabelle > 0 ? tempo * 1e6 / tabelle : 0.0);
+        for(l = 0; l < NUM_CORSIE; l++)
+            liberaStato(&stati[l]);
+        liberaStatoMultiplo(&multiplo);
+    }
+
+    /* Tutte le tabelle insieme con Floyd-Warshall, se la rete è abbastanza piccola */
+    if(g->costoMinimo >= 0 && g->numNodi <= LIMITE_NODI_FW && (long long)g->costoMassimo * g->numNodi < INFINITO_FW) {
+        struct matriceFW matrice;
+
+        calcolaMatrice(&matrice, g, 1);
+        tabelle = 0;
+        somma = 0;
+        for(i = 0; i < g->numNodi; i++) {
+            if(!containsStart(i))
+                continue;
+            tabelle++;
+            for(j = 0; j < g->numNodi; j++)
+                if(matrice.distanza[(size_t)i * matrice.lato + j] < INFINITO_FW)
+                    somma += matrice.distanza[(size_t)i * matrice.lato + j];
+        }
+        if(somma != primaSomma)
+            diversi = true;
+        printf("Floyd-Warshall %d tabelle in %.3f s (%.1f us per tabella)%s\n", tabelle, matrice.tempo,
+               tabelle > 0 ? matrice.tempo * 1e6 / tabelle : 0.0,
+               usaMatrice(g, g->numNodi) ? " [scelta automatica in batch]" : "");
+        liberaMatrice(&matrice);
+    }
+    if(diversi) {
+        fprintf(stderr, "Le code hanno trovato costi diversi\n");
+        return (EXIT_FAILURE);
+    }
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * Generatore di numeri casuali (splitmix64): a differenza di rand() dà la
+ * stessa sequenza su ogni sistema, così le topologie generate sono riproducibili
+ *
+ * @param seme stato del generatore, viene aggiornato
+ * @return numero casuale a 64 bit
+ */
+unsigned long long numeroCasuale(unsigned long long *seme) {
+    unsigned long long z = (*seme += 0x9E3779B97F4A7C15ull);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Funzione che restituisce un intero casuale in [minimo, massimo]
+ */
+int casualeTra(unsigned long long *seme, int minimo, int massimo) {
+    return minimo + (int)(numeroCasuale(seme) % (unsigned long long)(massimo - minimo + 1));
+}
+
+/*
+ * Funzione che scrive un link nel formato dei file di topologia (A;B;costo).
+ * Il nome di un router è il prefisso seguito dal numero.
+ */
+void scriviLink(struct buffer *b, char prefissoA, int a, char prefissoB, int c, int costo) {
+    riservaBuffer(b, 40);
+    b->dati[b->usati++] = prefissoA;
+    aggiungiIntero(b, a);
+    b->dati[b->usati++] = ';';
+    b->dati[b->usati++] = prefissoB;
+    aggiungiIntero(b, c);
+    b->dati[b->usati++] = ';';
+    aggiungiIntero(b, costo);
+    b->dati[b->usati++] = '\n';
+}
+
+/*
+ * Funzione che svuota il buffer nel file quando supera 1 MB
+ */
+void svuotaBuffer(struct buffer *b, FILE *fl, bool sempre) {
+    if(b->usati >= (1 << 20) || (sempre && b->usati > 0)) {
+        fwrite(b->dati, 1, b->usati, fl);
+        b->usati = 0;
+    }
+}
+
+/*
+ * Funzione che genera una topologia sintetica e la scrive nel formato dei
+ * file di topologia, ogni link compare una volta sola. Tipi disponibili:
+ * griglia     griglia quadrata, ogni router collegato ai vicini (grado ignorato)
+ * casuale     Erdős–Rényi con nodi * grado / 2 link, più un albero casuale
+ *             che rende la rete connessa
+ * scalefree   Barabási–Albert, ogni nuovo router si collega a grado / 2
+ *             router scelti con probabilità proporzionale al loro grado
+ * isp         gerarchia core (C), aggregazione (A) e accesso (R): il core è
+ *             un anello con grado / 2 corde per router, ogni router di
+ *             aggregazione e di accesso è collegato a due router del livello sopra
+ *
+ * @param fl file in cui scrivere
+ * @param tipo tipo di topologia
+ * @param n numero di router
+ * @param grado grado medio desiderato
+ * @param seme seme del generatore casuale
+ * @param coordinate true per scrivere anche le coordinate dei router (solo griglia)
+ * @return false se il tipo non esiste
+ */
+bool generaTopologia(FILE *fl, const char *tipo, int n, int grado, unsigned long long seme, bool coordinate) {
+    struct buffer b = {NULL, 0, 0};
+    int *estremi, numEstremi = 0, scelti[64];
+    int i, j, k, l, lato, m, numCore, numAggregazione;
+    long long numLink;
+
+    if(n < 2)
+        return false;
+    if(strcmp(tipo, "griglia") == 0) {
+        for(lato = 1; (long long)lato * lato < n; lato++);
+        for(i = 0; i < n; i++) {
+            if(coordinate) {
+                riservaBuffer(&b, 40);
+                b.dati[b.usati++] = '@';
+                b.dati[b.usati++] = 'R';
+                aggiungiIntero(&b, i);
+                b.dati[b.usati++] = ';';
+                aggiungiIntero(&b, i % lato);
+                b.dati[b.usati++] = ';';
+                aggiungiIntero(&b, i / lato);
+                b.dati[b.usati++] = '\n';
+            }
+            if(i % lato + 1 < lato && i + 1 < n)
+                scriviLink(&b, 'R', i, 'R', i + 1, casualeTra(&seme, 1, 10));
+            if(i + lato < n)
+                scriviLink(&b, 'R', i, 'R', i + lato, casualeTra(&seme, 1, 10));
+            svuotaBuffer(&b, fl, false);
+        }
+    }
+    else if(strcmp(tipo, "casuale") == 0) {
+        /* Albero casuale: ogni router si collega a uno dei precedenti */
+        for(i = 1; i < n; i++) {
+            scriviLink(&b, 'R', i, 'R', casualeTra(&seme, 0, i - 1), casualeTra(&seme, 1, 100));
+            svuotaBuffer(&b, fl, false);
+        }
+        /* Link casuali fino al grado medio richiesto, i doppioni vengono
+           scartati in lettura */
+        numLink = (long long)n * grado / 2 - (n - 1);
+        for(; numLink > 0; numLink--) {
+            i = casualeTra(&seme, 0, n - 1);
+            j = casualeTra(&seme, 0, n - 2);
+            scriviLink(&b, 'R', i, 'R', j < i ? j : j + 1, casualeTra(&seme, 1, 100));
+            svuotaBuffer(&b, fl, false);
+        }
+    }
+    else if(strcmp(tipo, "scalefree") == 0) {
+        m = grado / 2 < 1 ? 1 : (grado / 2 > 64 ? 64 : grado / 2);
+        if(m >= n)
+            m = n - 1;
+        /* Ogni link compare due volte in estremi, scegliere un elemento a caso
+           equivale a scegliere un router con probabilità proporzionale al grado */
+        estremi = (int *)malloc(((size_t)m * (m + 1) + 2 * (size_t)m * n) * sizeof(int));
+        for(i = 0; i <= m; i++) {
+            for(j = 0; j < i; j++) {
+                scriviLink(&b, 'R', i, 'R', j, casualeTra(&seme, 1, 100));
+                estremi[numEstremi++] = i;
+                estremi[numEstremi++] = j;
+            }
+        }
+        for(i = m + 1; i < n; i++) {
+            for(j = 0; j < m; j++) {
+                /* Vengono evitati i doppioni, dopo qualche tentativo si accetta il link */
+                for(k = 0; k < 8; k++) {
+                    scelti[j] = estremi[numeroCasuale(&seme) % (unsigned long long)numEstremi];
+                    for(l = 0; l < j && scelti[l] != scelti[j]; l++);
+                    if(l == j)
+                        break;
+                }
+            }
+            for(j = 0; j < m; j++) {
+                scriviLink(&b, 'R', i, 'R', scelti[j], casualeTra(&seme, 1, 100));
+                estremi[numEstremi++] = i;
+                estremi[numEstremi++] = scelti[j];
+            }
+            svuotaBuffer(&b, fl, false);
+        }
+        free(estremi);
+    }
+    else if(strcmp(tipo, "isp") == 0) {
+        numCore = n / 200 < 4 ? 4 : n / 200;
+        numAggregazione = n / 20 < numCore ? numCore : n / 20;
+        if(numCore + numAggregazione > n) {
+            numCore = n;
+            numAggregazione = 0;
+        }
+        for(i = 0; i < numCore; i++) {
+            if(numCore > 2 || i == 0)
+                scriviLink(&b, 'C', i, 'C', (i + 1) % numCore, casualeTra(&seme, 1, 5));
+            for(j = 0; j < grado / 2 && numCore > 3; j++) {
+                k = casualeTra(&seme, 0, numCore - 2);
+                scriviLink(&b, 'C', i, 'C', k < i ? k : k + 1, casualeTra(&seme, 1, 5));
+            }
+        }
+        /* Ogni router di aggregazione ha due uplink verso core vicini */
+        for(i = 0; i < numAggregazione; i++) {
+            scriviLink(&b, 'A', i, 'C', i % numCore, casualeTra(&seme, 10, 20));
+            scriviLink(&b, 'A', i, 'C', (i + 1) % numCore, casualeTra(&seme, 10, 20));
+            svuotaBuffer(&b, fl, false);
+        }
+        for(i = 0; i < n - numCore - numAggregazione; i++) {
+            k = casualeTra(&seme, 0, numAggregazione - 1);
+            scriviLink(&b, 'R', i, 'A', k, casualeTra(&seme, 50, 100));
+            if(numAggregazione > 1)
+                scriviLink(&b, 'R', i, 'A', (k + 1) % numAggregazione, casualeTra(&seme, 50, 100));
+            svuotaBuffer(&b, fl, false);
+        }
+    }
+    else {
+        free(b.dati);
+        return false;
+    }
+    svuotaBuffer(&b, fl, true);
+    free(b.dati);
+    return true;
+}
+
+/*
+ * Modalità per generare una topologia sintetica:
+ * ./dijkstra --genera tipo nodi [-g grado] [-s seme] [-o file] [-c]
+ * Con lo stesso seme viene generato sempre lo stesso file, -c aggiunge le
+ * coordinate dei router della griglia.
+ *
+ * @param argc numero di argomenti dopo --genera
+ * @param argv argomenti dopo --genera
+ * @return codice di uscita del programma
+ */
+int modalitaGenera(int argc, char **argv) {
+    char *nomeOutput = NULL;
+    unsigned long long seme = 1;
+    int grado = 4, i;
+    FILE *output = stdout;
+    bool riuscito, coordinate = false;
+
+    for(i = 2; i < argc; i++) {
+        if(strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+            grado = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            seme = strtoull(argv[++i], NULL, 10);
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            nomeOutput = argv[++i];
+        else if(strcmp(argv[i], "-c") == 0)
+            coordinate = true;
+    }
+    if(nomeOutput != NULL && (output = fopen(nomeOutput, "w")) == NULL) {
+        fprintf(stderr, "Impossibile scrivere %s\n", nomeOutput);
+        return (EXIT_FAILURE);
+    }
+    riuscito = generaTopologia(output, argv[0], atoi(argv[1]), grado, seme, coordinate);
+    if(output != stdout)
+        fclose(output);
+    if(!riuscito) {
+        fprintf(stderr, "Topologia non valida, tipi disponibili: griglia, casuale, scalefree, isp (almeno 2 nodi)\n");
+        return (EXIT_FAILURE);
+    }
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * Funzione di confronto per ordinare i tempi con qsort
+ */
+int confrontaTempi(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+ * Funzione che misura i file indicati: tempo di caricamento, latenza di una
+ * tabella (p50 e p99 su un campione di router scelti a caso con seme fisso),
+ * tabelle al secondo calcolate in parallelo sullo stesso campione e picco di memoria
+ *
+ * @param numFile numero di file della topologia
+ * @param file nomi dei file
+ * @param campioni numero di router misurati
+ * @param numThread thread usati per il throughput
+ * @return false se un file non può essere letto
+ */
+bool misuraTopologia(int numFile, char **file, int campioni, int numThread) {
+    const struct csr *g;
+    struct statoTabella stato;
+    unsigned long long seme = 1;
+    double inizio, caricamento, parallelo, *tempi;
+    int *sorgenti, numSorgenti = 0, i;
+    FILE *nulla;
+
+    inizio = secondi();
+    for(i = 0; i < numFile; i++) {
+        if(!caricaFile(file[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", file[i]);
+            return false;
+        }
+    }
+    g = aggiornaCSR();
+    caricamento = secondi() - inizio;
+    riordinaRete(ordineNodi);
+    g = aggiornaCSR();
+
+    sorgenti = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    for(i = 0; i < g->numNodi; i++)
+        if(containsStart(i))
+            sorgenti[numSorgenti++] = i;
+    /* Campione casuale (mescolamento parziale di Fisher-Yates) */
+    if(campioni > numSorgenti)
+        campioni = numSorgenti;
+    for(i = 0; i < campioni; i++) {
+        int j = casualeTra(&seme, i, numSorgenti - 1), temp = sorgenti[i];
+
+        sorgenti[i] = sorgenti[j];
+        sorgenti[j] = temp;
+    }
+
+    tempi = (double *)malloc((campioni + 1) * sizeof(double));
+    creaStato(&stato, g->numNodi);
+    for(i = 0; i < campioni; i++) {
+        inizio = secondi();
+        calcolaTabella(g, sorgenti[i], &stato);
+        tempi[i] = secondi() - inizio;
+    }
+    liberaStato(&stato);
+    qsort(tempi, campioni, sizeof(double), confrontaTempi);
+
+    /* Throughput completo: calcolo e formattazione delle tabelle, scritte su /dev/null */
+    nulla = fopen("/dev/null", "w");
+    inizio = secondi();
+    calcolaTabelleParallelo(sorgenti, campioni, numThread, nulla != NULL ? nulla : stdout);
+    parallelo = secondi() - inizio;
+    if(nulla != NULL)
+        fclose(nulla);
+
+    printf("%s: %d nodi, %d archi\n", file[0], g->numNodi, g->numArchi);
+    printf("  caricamento %.3f s\n", caricamento);
+    if(campioni > 0) {
+        printf("  tabella: p50 %.1f us, p99 %.1f us (%d router)\n", tempi[campioni / 2] * 1e6,
+               tempi[(int)(campioni * 0.99)] * 1e6, campioni);
+        printf("  %.1f tabelle/s con %d thread\n", campioni / parallelo, numThread);
+    }
+    if(leggiMemoriaProcesso("VmHWM:") >= 0)
+        printf("  picco di memoria %.1f MB\n", leggiMemoriaProcesso("VmHWM:") / 1024.0);
+    free(tempi);
+    free(sorgenti);
+    return true;
+}
+
+/*
+ * Modalità benchmark:
+ * ./dijkstra --bench [-n campioni] [-j thread] [-O bfs|rcm|grado] file...
+ * misura i file indicati come un'unica topologia;
+ * ./dijkstra --bench-suite [nodi] [-n campioni] [-j thread]
+ * genera le quattro topologie sintetiche con seme fisso (file bench-tipo-nodi.txt
+ * nella cartella corrente) e le misura una alla volta, ognuna in un processo
+ * separato così il picco di memoria è quello della singola topologia.
+ *
+ * @param argc numero di argomenti dopo --bench o --bench-suite
+ * @param argv argomenti dopo --bench o --bench-suite
+ * @param suite true per --bench-suite
+ * @return codice di uscita del programma
+ */
+int modalitaBench(int argc, char **argv, bool suite) {
+    const char *tipi[] = {"griglia", "casuale", "scalefree", "isp"};
+    char **file = (char **)malloc((argc + 1) * sizeof(char *)), nomeFile[64];
+    int numFile = 0, campioni = 1000, numNodi = 100000, i, stato;
+    int numThread = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    bool riuscito = true;
+    FILE *fl;
+    pid_t figlio;
+
+    for(i = 0; i < argc; i++) {
+        if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            campioni = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            numThread = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-O") == 0 && i + 1 < argc && tipoOrdine(argv[i + 1]) >= 0)
+            ordineNodi = tipoOrdine(argv[++i]);
+        else
+            file[numFile++] = argv[i];
+    }
+    if(numThread < 1)
+        numThread = 1;
+    if(!suite) {
+        riuscito = numFile > 0 && misuraTopologia(numFile, file, campioni, numThread);
+        free(file);
+        return riuscito ? (EXIT_SUCCESS) : (EXIT_FAILURE);
+    }
+
+    if(numFile > 0)
+        numNodi = atoi(file[0]);
+    for(i = 0; i < 4 && riuscito; i++) {
+        snprintf(nomeFile, sizeof(nomeFile), "bench-%s-%d.txt", tipi[i], numNodi);
+        if((fl = fopen(nomeFile, "w")) == NULL) {
+            fprintf(stderr, "Impossibile scrivere %s\n", nomeFile);
+            riuscito = false;
+            break;
+        }
+        riuscito = generaTopologia(fl, tipi[i], numNodi, 8, 1, false);
+        fclose(fl);
+        fflush(stdout);
+        figlio = fork();
+        if(figlio == 0) {
+            file[0] = nomeFile;
+            exit(misuraTopologia(1, file, campioni, numThread) ? (EXIT_SUCCESS) : (EXIT_FAILURE));
+        }
+        if(figlio < 0 || waitpid(figlio, &stato, 0) < 0 || !WIFEXITED(stato) || WEXITSTATUS(stato) != EXIT_SUCCESS)
+            riuscito = false;
+    }
+    free(file);
+    return riuscito ? (EXIT_SUCCESS) : (EXIT_FAILURE);
+}
+
+/*
+ * Funzione che si assicura che nel buffer ci sia spazio per altri n caratteri
+ */
+void riservaBuffer(struct buffer *b, size_t n) {
+    if(b->usati + n <= b->capacita)
+        return;
+    while(b->usati + n > b->capacita)
+        b->capacita = b->capacita == 0 ? 4096 : 2 * b->capacita;
+    b->dati = (char *)realloc(b->dati, b->capacita);
+}
+
+/*
+ * Funzione che aggiunge una stringa in fondo al buffer
+ */
+void aggiungiStringa(struct buffer *b, const char *stringa) {
+    size_t lunghezza = strlen(stringa);
+
+    riservaBuffer(b, lunghezza);
+    memcpy(b->dati + b->usati, stringa, lunghezza);
+    b->usati += lunghezza;
+}
+
+/*
+ * Funzione che aggiunge un intero in fondo al buffer
+ */
+void aggiungiIntero(struct buffer *b, int n) {
+    char cifre[12];
+    int i = 0;
+    unsigned int valore = n < 0 ? -(unsigned int)n : (unsigned int)n;
+
+    riservaBuffer(b, sizeof(cifre));
+    if(n < 0)
+        b->dati[b->usati++] = '-';
+    do{
+        cifre[i++] = '0' + valore % 10;
+        valore /= 10;
+    }while(valore != 0);
+    while(i > 0)
+        b->dati[b->usati++] = cifre[--i];
+}
+
+/*
+ * Funzione che scrive nel buffer la tabella calcolata, nello stesso formato
+ * usato da mostraTabella
+ *
+ * @param b buffer
+ * @param start ID del router di partenza
+ * @param s stato con la tabella calcolata
+ */
+void scriviTabella(struct buffer *b, int start, const struct statoTabella *s) {
+    aggiungiStringa(b, "Tabella di ");
+    aggiungiStringa(b, nomeNodo(start));
+    aggiungiStringa(b, ":\n");
+    scriviRighe(b, &nomi, s);
+    aggiungiStringa(b, "\n");
+}
+
+/*
+ * Funzione che scrive nel buffer le righe "nextHop; destinazione; costo"
+ * di una tabella calcolata, senza intestazione
+ *
+ * @param b buffer
+ * @param t nomi dei router
+ * @param s stato con la tabella calcolata
+ */
+void scriviRighe(struct buffer *b, const struct tabellaNomi *t, const struct statoTabella *s) {
+    int i, nodo;
+
+    for(i = 0; i < s->numRaggiunti; i++) {
+        nodo = s->ordine[i];
+        aggiungiStringa(b, nomeIn(t, s->nextHop[nodo]));
+        aggiungiStringa(b, "; ");
+        aggiungiStringa(b, nomeIn(t, nodo));
+        aggiungiStringa(b, "; ");
+        aggiungiIntero(b, s->distanza[nodo]);
+        aggiungiStringa(b, "\n");
+    }
+}
+
+/*
+ * Funzione eseguita da ogni thread della modalità batch: prende un gruppo
+ * di lavoro->corsie sorgenti alla volta, ne calcola le tabelle con il
+ * proprio stato (in una sola visita se sono più di una) e le scrive quando
+ * arriva il suo turno, così l'output è sempre nello stesso ordine.
+ *
+ * @param argomento struct lavoroBatch condivisa
+ */
+void *threadBatch(void *argomento) {
+    struct lavoroBatch *lavoro = (struct lavoroBatch *)argomento;
+    struct statoTabella stati[NUM_CORSIE];
+    struct statoMultiplo multiplo;
+    struct buffer testo = {NULL, 0, 0};
+    struct statisticheSPF totale;
+    struct statoAree sa;
+    double inizio = 0;
+    int k, l, numero;
+
+    memset(&totale, 0, sizeof(totale));
+    memset(&sa, 0, sizeof(sa));
+    for(l = 0; l < lavoro->corsie; l++)
+        creaStato(&stati[l], lavoro->g->numNodi);
+    if(lavoro->corsie > 1)
+        creaStatoMultiplo(&multiplo, lavoro->g->numNodi);
+    for(;;) {
+        pthread_mutex_lock(&lavoro->mutex);
+        k = lavoro->prossima;
+        lavoro->prossima += lavoro->corsie;
+        pthread_mutex_unlock(&lavoro->mutex);
+        if(k >= lavoro->numSorgenti)
+            break;
+        numero = lavoro->numSorgenti - k < lavoro->corsie ? lavoro->numSorgenti - k : lavoro->corsie;
+
+        if(lavoro->matrice != NULL)
+            tabellaDaMatrice(lavoro->matrice, lavoro->sorgenti[k], &stati[0]);
+        else if(lavoro->aree != NULL)
+            calcolaTabellaAree(lavoro->aree, lavoro->sorgenti[k], &sa, &stati[0]);
+        else if(lavoro->corsie > 1)
+            calcolaTabelleMultiple(lavoro->g, lavoro->sorgenti + k, numero, &multiplo, stati);
+        else
+            calcolaTabella(lavoro->g, lavoro->sorgenti[k], &stati[0]);
+        if(formatoStatistiche != STATISTICHE_SPENTE)
+            inizio = secondi();
+        testo.usati = 0;
+        for(l = 0; l < numero; l++)
+            scriviTabella(&testo, lavoro->sorgenti[k + l], &stati[l]);
+
+        /* Attesa del proprio turno per scrivere */
+        pthread_mutex_lock(&lavoro->mutex);
+        while(lavoro->daScrivere != k)
+            pthread_cond_wait(&lavoro->turno, &lavoro->mutex);
+        pthread_mutex_unlock(&lavoro->mutex);
+        fwrite(testo.dati, 1, testo.usati, lavoro->output);
+        /* Le statistiche delle tabelle vanno su stderr, nello stesso ordine */
+        if(formatoStatistiche != STATISTICHE_SPENTE) {
+            for(l = 0; l < numero; l++) {
+                stati[l].contatori.stampa = (secondi() - inizio) / numero;
+                stampaStatistiche(stderr, nomeNodo(lavoro->sorgenti[k + l]), &stati[l].contatori);
+                sommaStatistiche(&totale, &stati[l].contatori);
+            }
+        }
+        pthread_mutex_lock(&lavoro->mutex);
+        lavoro->daScrivere += numero;
+        pthread_cond_broadcast(&lavoro->turno);
+        pthread_mutex_unlock(&lavoro->mutex);
+    }
+    free(testo.dati);
+    for(l = 0; l < lavoro->corsie; l++)
+        liberaStato(&stati[l]);
+    if(lavoro->corsie > 1)
+        liberaStatoMultiplo(&multiplo);
+    liberaStatoAree(&sa);
+    pthread_mutex_lock(&mutexStatistiche);
+    sommaStatistiche(&statistiche, &totale);
+    pthread_mutex_unlock(&mutexStatistiche);
+    return NULL;
+}
+
+/*
+ * Funzione che calcola le tabelle dei router indicati usando più thread.
+ *
+ * @param sorgenti ID dei router
+ * @param numSorgenti numero di router
+ * @param numThread numero di thread da usare
+ * @param output file in cui scrivere le tabelle
+ */
+void calcolaTabelleParallelo(const int *sorgenti, int numSorgenti, int numThread, FILE *output) {
+    struct lavoroBatch lavoro;
+    struct matriceFW matrice;
+    pthread_t *thread;
+    int i;
+
+    lavoro.g = aggiornaCSR();
+    /* Il calcolo multi-sorgente richiede costi non negativi */
+    lavoro.corsie = corsieBatch < 1 || lavoro.g->costoMinimo < 0 ? 1 : corsieBatch > NUM_CORSIE ? NUM_CORSIE : corsieBatch;
+    /* Su reti piccole e dense tutte le tabelle vengono calcolate prima con
+       Floyd-Warshall, poi i thread si limitano a copiarle e scriverle */
+    lavoro.matrice = NULL;
+    if(usaMatrice(lavoro.g, numSorgenti)) {
+        calcolaMatrice(&matrice, lavoro.g, numThread);
+        lavoro.matrice = &matrice;
+        lavoro.corsie = 1;
+    }
+    /* Con le aree nel file ogni tabella usa i sommari dei router di bordo */
+    lavoro.aree = lavoro.matrice == NULL && sceltaMatrice != MATRICE_NO ? aggiornaAree() : NULL;
+    if(lavoro.aree != NULL)
+        lavoro.corsie = 1;
+    lavoro.sorgenti = sorgenti;
+    lavoro.numSorgenti = numSorgenti;
+    lavoro.prossima = 0;
+    lavoro.daScrivere = 0;
+    lavoro.output = output;
+    pthread_mutex_init(&lavoro.mutex, NULL);
+    pthread_cond_init(&lavoro.turno, NULL);
+    if(numThread > numSorgenti)
+        numThread = numSorgenti > 0 ? numSorgenti : 1;
+    thread = (pthread_t *)malloc(numThread * sizeof(pthread_t));
+    for(i = 0; i < numThread; i++)
+        pthread_create(&thread[i], NULL, threadBatch, &lavoro);
+    for(i = 0; i < numThread; i++)
+        pthread_join(thread[i], NULL);
+    free(thread);
+    pthread_mutex_destroy(&lavoro.mutex);
+    pthread_cond_destroy(&lavoro.turno);
+    if(lavoro.matrice != NULL)
+        liberaMatrice(&matrice);
+}
+
+/*
+ * Modalità batch, senza menu:
+ * ./dijkstra --batch [-j thread] [-m corsie] [-a auto|matrice|dijkstra] [-O bfs|rcm|grado] [-r R1,R2,...] [-o output] [-s snapshot] [-S testo|json] file...
+ * Carica lo snapshot e i file indicati e scrive la tabella di tutti i router (o solo di
+ * quelli passati con -r) calcolandole in parallelo, ogni thread calcola insieme le
+ * tabelle di -m router (default NUM_CORSIE, 1 per una visita per tabella). Con -a si
+ * sceglie se usare Floyd-Warshall (default: solo su reti piccole e dense), con -O si rinumerano i
+ * router dopo il caricamento (l'ordine delle tabelle segue i nuovi ID). Con -S su stderr vengono
+ * scritte le statistiche di ogni tabella e quelle totali.
+ *
+ * @param argc numero di argomenti dopo --batch
+ * @param argv argomenti dopo --batch
+ * @return codice di uscita del programma
+ */
+int modalitaBatch(int argc, char **argv) {
+    const struct csr *g;
+    char *router = NULL, *nomeOutput = NULL, *nome;
+    int numThread = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int *sorgenti, numSorgenti = 0, i, id;
+    FILE *output = stdout;
+
+    /* Lettura delle opzioni, quello che rimane sono i file */
+    for(i = 0; i < argc; i++) {
+        if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            numThread = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            router = argv[++i];
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            nomeOutput = argv[++i];
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+            corsieBatch = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-O") == 0 && i + 1 < argc && tipoOrdine(argv[i + 1]) >= 0)
+            ordineNodi = tipoOrdine(argv[++i]);
+        else if(strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            i++;
+            sceltaMatrice = strcmp(argv[i], "matrice") == 0 ? MATRICE_SI : strcmp(argv[i], "dijkstra") == 0 ? MATRICE_NO : MATRICE_AUTO;
+        }
+        else if(strcmp(argv[i], "-S") == 0 && i + 1 < argc)
+            formatoStatistiche = strcmp(argv[++i], "json") == 0 ? STATISTICHE_JSON : STATISTICHE_TESTO;
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if(!caricaSnapshot(argv[++i])) {
+                fprintf(stderr, "Impossibile caricare lo snapshot %s\n", argv[i]);
+                return (EXIT_FAILURE);
+            }
+        }
+        else if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    if(numThread < 1)
+        numThread = 1;
+
+    riordinaRete(ordineNodi);
+    g = aggiornaCSR();
+    sorgenti = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    if(router == NULL) {
+        for(i = 0; i < g->numNodi; i++)
+            if(containsStart(i))
+                sorgenti[numSorgenti++] = i;
+    }
+    else {
+        /* Lista di router separati da virgola */
+        for(nome = strtok(router, ","); nome != NULL; nome = strtok(NULL, ",")) {
+            id = cercaNome(nome);
+            if(id < 0 || !containsStart(id)) {
+                fprintf(stderr, "Nodo non esistente: %s\n", nome);
+                free(sorgenti);
+                return (EXIT_FAILURE);
+            }
+            if(numSorgenti < g->numNodi)
+                sorgenti[numSorgenti++] = id;
+        }
+    }
+
+    if(nomeOutput != NULL && (output = fopen(nomeOutput, "w")) == NULL) {
+        fprintf(stderr, "Impossibile scrivere %s\n", nomeOutput);
+        free(sorgenti);
+        return (EXIT_FAILURE);
+    }
+    calcolaTabelleParallelo(sorgenti, numSorgenti, numThread, output);
+    if(output != stdout)
+        fclose(output);
+    if(formatoStatistiche != STATISTICHE_SPENTE)
+        stampaStatistiche(stderr, NULL, &statistiche);
+    free(sorgenti);
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * Funzione che abbassa in modo atomico l'etichetta di un nodo se la nuova
+ * distanza è minore, insieme al precedente che l'ha trovata
+ *
+ * @param etichetta etichetta condivisa del nodo
+ * @param nuova (distanza << 32) | precedente
+ * @return true se la distanza è stata abbassata
+ */
+bool abbassaEtichetta(unsigned long long *etichetta, unsigned long long nuova) {
+    unsigned long long vecchia = __atomic_load_n(etichetta, __ATOMIC_RELAXED);
+
+    /* Il precedente viene scritto solo quando la distanza diminuisce: chi
+       arriva dopo con lo stesso costo non lo cambia, così i precedenti
+       formano sempre un albero anche con archi di costo 0 */
+    while((nuova >> 32) < (vecchia >> 32))
+        if(__atomic_compare_exchange_n(etichetta, &vecchia, nuova, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return true;
+    return false;
+}
+
+/*
+ * Funzione che sposta nella frontiera i nodi delle liste dei thread, una
+ * volta sola per nodo, e svuota le liste
+ *
+ * @param d stato condiviso del delta-stepping
+ * @param liste lista del primo thread
+ * @param passo distanza tra le liste di due thread consecutivi
+ * @param filtra true per scartare i nodi che non sono più nel bucket corrente
+ */
+void raccogliFrontiera(struct deltaStepping *d, struct listaNodi *liste, int passo, bool filtra) {
+    struct listaNodi *l;
+    int t, i, nodo;
+
+    for(t = 0; t < d->numThread; t++) {
+        l = &liste[t * passo];
+        for(i = 0; i < l->numero; i++) {
+            nodo = l->nodi[i];
+            if(d->fase[nodo] == d->numFase)
+                continue;
+            /* Un nodo abbassato dopo l'inserimento è già stato elaborato
+               in un bucket precedente */
+            if(filtra && (int)(d->etichetta[nodo] >> 32) / d->delta != d->corrente)
+                continue;
+            d->fase[nodo] = d->numFase;
+            aggiungiNodoLista(&d->frontiera, nodo);
+        }
+        l->numero = 0;
+    }
+}
+
+/*
+ * Funzione eseguita da un solo thread tra due passi: sceglie i nodi da
+ * elaborare nel passo successivo. Se nel bucket corrente sono stati
+ * abbassati dei nodi si rielaborano quelli, altrimenti si rilassano gli
+ * archi pesanti dei nodi del bucket, altrimenti si passa al primo bucket
+ * non vuoto. Se tutti i bucket sono vuoti il calcolo è finito.
+ *
+ * @param d stato condiviso del delta-stepping
+ */
+void prossimaFrontiera(struct deltaStepping *d) {
+    int vuoti;
+
+    d->frontiera.numero = 0;
+    d->prossimoBlocco = 0;
+    d->numFase++;
+    d->pesanti = false;
+    raccogliFrontiera(d, d->prossimi, 1, false);
+    if(d->frontiera.numero == 0) {
+        d->pesanti = true;
+        raccogliFrontiera(d, d->elaborati, 1, false);
+    }
+    /* I nodi in coda hanno distanza minore di (corrente + numBucket) * delta,
+       quindi dopo numBucket bucket vuoti di fila non resta niente */
+    for(vuoti = 0; d->frontiera.numero == 0; vuoti++) {
+        if(vuoti == d->numBucket) {
+            d->fine = true;
+            return;
+        }
+        d->pesanti = false;
+        d->corrente++;
+        raccogliFrontiera(d, &d->bucket[d->corrente % d->numBucket], d->numBucket, true);
+    }
+    if(d->frontiera.numero > d->piccoFrontiera)
+        d->piccoFrontiera = d->frontiera.numero;
+}
+
+/*
+ * Funzione con cui un thread elabora la sua parte della frontiera, presa a
+ * blocchi di BLOCCO_DELTA nodi: chi finisce prima prende i blocchi rimasti,
+ * così il lavoro resta bilanciato anche con gradi molto diversi
+ *
+ * @param d stato condiviso del delta-stepping
+ * @param t indice del thread
+ * @param rilassati archi rilassati dal thread, viene aggiornato
+ * @param aggiornamenti distanze abbassate dal thread, viene aggiornato
+ */
+void rilassaFrontiera(struct deltaStepping *d, int t, long long *rilassati, long long *aggiornamenti) {
+    const struct csr *g = d->g;
+    struct listaNodi *prossimi = &d->prossimi[t];
+    long long costo;
+    int inizio, fine, k, i, nodo, arrivo, distanza, b;
+
+    for(;;) {
+        inizio = __atomic_fetch_add(&d->prossimoBlocco, BLOCCO_DELTA, __ATOMIC_RELAXED);
+        if(inizio >= d->frontiera.numero)
+            break;
+        fine = inizio + BLOCCO_DELTA < d->frontiera.numero ? inizio + BLOCCO_DELTA : d->frontiera.numero;
+        for(k = inizio; k < fine; k++) {
+            nodo = d->frontiera.nodi[k];
+            distanza = (int)(__atomic_load_n(&d->etichetta[nodo], __ATOMIC_RELAXED) >> 32);
+            if(!d->pesanti)
+                aggiungiNodoLista(&d->elaborati[t], nodo);
+            for(i = g->offset[nodo]; i < g->offset[nodo + 1]; i++) {
+                /* Archi leggeri nei passi normali, pesanti solo nell'ultimo */
+                if((g->costo[i] >= d->delta) != d->pesanti)
+                    continue;
+                (*rilassati)++;
+                arrivo = g->arrivo[i];
+                costo = (long long)distanza + g->costo[i];
+                if(costo >= INT_MAX || !abbassaEtichetta(&d->etichetta[arrivo], (unsigned long long)costo << 32 | (unsigned int)nodo))
+                    continue;
+                (*aggiornamenti)++;
+                b = (int)costo / d->delta;
+                if(b == d->corrente)
+                    aggiungiNodoLista(prossimi, arrivo);
+                else
+                    aggiungiNodoLista(&d->bucket[t * d->numBucket + b % d->numBucket], arrivo);
+            }
+        }
+    }
+}
+
+/*
+ * Funzione eseguita da ogni thread del delta-stepping: i passi sono separati
+ * da una barriera e tra due passi il thread 0 prepara la frontiera
+ *
+ * @param argomento struct deltaStepping condivisa
+ */
+void *threadDelta(void *argomento) {
+    struct deltaStepping *d = (struct deltaStepping *)argomento;
+    int t = __atomic_fetch_add(&d->numAvviati, 1, __ATOMIC_RELAXED);
+    long long rilassati = 0, aggiornamenti = 0;
+
+    for(;;) {
+        if(t == 0)
+            prossimaFrontiera(d);
+        pthread_barrier_wait(&d->barriera);
+        if(d->fine)
+            break;
+        if(t == 0 && !d->pesanti)
+            d->estratti += d->frontiera.numero;
+        rilassaFrontiera(d, t, &rilassati, &aggiornamenti);
+        pthread_barrier_wait(&d->barriera);
+    }
+    __atomic_fetch_add(&d->rilassati, rilassati, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&d->aggiornamenti, aggiornamenti, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+/*
+ * Funzione che sceglie delta quando non è indicato: circa il costo massimo
+ * diviso il grado medio, così ogni bucket contiene abbastanza nodi da
+ * dividere tra i thread senza rielaborarli troppe volte
+ *
+ * @param g grafo in formato CSR
+ * @return delta, almeno 1
+ */
+int deltaAutomatico(const struct csr *g) {
+    int grado = g->numNodi > 0 ? g->numArchi / g->numNodi : 0;
+
+    return g->costoMassimo / (grado > 1 ? grado : 1) + 1;
+}
+
+/*
+ * Delta-stepping parallelo: calcola lo stesso stato di calcolaTabella
+ * (distanze, next hop, precedenti e destinazioni raggiunte) usando più
+ * thread. Con costi uguali il next hop può essere un altro tra quelli di
+ * pari costo. Con costi negativi si usa calcolaTabella.
+ *
+ * @param g grafo in formato CSR
+ * @param start ID del router di partenza
+ * @param s stato in cui salvare il risultato
+ * @param numThread numero di thread da usare
+ * @param delta larghezza dei bucket, 0 per sceglierla da deltaAutomatico
+ */
+void calcolaTabellaDelta(const struct csr *g, int start, struct statoTabella *s, int numThread, int delta) {
+    struct deltaStepping d;
+    pthread_t *thread;
+    int i, nodo, precedente;
+    double inizio = formatoStatistiche != STATISTICHE_SPENTE ? secondi() : 0;
+
+    if(g->costoMinimo < 0) {
+        calcolaTabella(g, start, s);
+        return;
+    }
+    memset(&d, 0, sizeof(d));
+    d.g = g;
+    d.numThread = numThread > 1 ? numThread : 1;
+    d.delta = delta > 0 ? delta : deltaAutomatico(g);
+    if(g->costoMassimo / d.delta + 2 > MAX_BUCKET_DELTA)
+        d.delta = g->costoMassimo / (MAX_BUCKET_DELTA - 2) + 1;
+    d.numBucket = g->costoMassimo / d.delta + 2;
+    d.etichetta = (unsigned long long *)malloc((g->numNodi + 1) * sizeof(unsigned long long));
+    d.fase = (int *)calloc(g->numNodi + 1, sizeof(int));
+    d.bucket = (struct listaNodi *)calloc((size_t)d.numThread * d.numBucket, sizeof(struct listaNodi));
+    d.prossimi = (struct listaNodi *)calloc(d.numThread, sizeof(struct listaNodi));
+    d.elaborati = (struct listaNodi *)calloc(d.numThread, sizeof(struct listaNodi));
+    contaAllocazione((size_t)(g->numNodi + 1) * (sizeof(unsigned long long) + sizeof(int)));
+    for(i = 0; i < g->numNodi; i++)
+        d.etichetta[i] = (unsigned long long)INT_MAX << 32;
+    d.etichetta[start] = (unsigned int)start;
+    aggiungiNodoLista(&d.bucket[0], start);
+    d.corrente = -1;
+
+    pthread_barrier_init(&d.barriera, NULL, d.numThread);
+    thread = (pthread_t *)malloc(d.numThread * sizeof(pthread_t));
+    for(i = 1; i < d.numThread; i++)
+        pthread_create(&thread[i], NULL, threadDelta, &d);
+    threadDelta(&d);
+    for(i = 1; i < d.numThread; i++)
+        pthread_join(thread[i], NULL);
+    free(thread);
+    pthread_barrier_destroy(&d.barriera);
+
+    /* Copia del risultato nello stato, le destinazioni in ordine di ID */
+    for(i = 0; i < s->numRaggiunti; i++)
+        s->distanza[s->ordine[i]] = INT_MAX;
+    s->ordine[0] = start;
+    s->numRaggiunti = 1;
+    for(i = 0; i < g->numNodi; i++) {
+        s->distanza[i] = (int)(d.etichetta[i] >> 32);
+        s->precedente[i] = (int)(d.etichetta[i] & 0xffffffffu);
+        s->nextHop[i] = -1;
+        if(s->distanza[i] != INT_MAX && i != start)
+            s->ordine[s->numRaggiunti++] = i;
+    }
+    /* Il next hop è quello del precedente: si risale finché non è noto e
+       poi si scende assegnandolo, ogni nodo viene visitato una volta */
+    s->nextHop[start] = start;
+    d.frontiera.numero = 0;
+    for(i = 1; i < s->numRaggiunti; i++) {
+        for(nodo = s->ordine[i]; s->nextHop[nodo] == -1; nodo = s->precedente[nodo])
+            aggiungiNodoLista(&d.frontiera, nodo);
+        while(d.frontiera.numero > 0) {
+            nodo = d.frontiera.nodi[--d.frontiera.numero];
+            precedente = s->precedente[nodo];
+            s->nextHop[nodo] = precedente == start ? nodo : s->nextHop[precedente];
+        }
+    }
+
+    if(formatoStatistiche != STATISTICHE_SPENTE) {
+        memset(&s->contatori, 0, sizeof(s->contatori));
+        s->contatori.tabelle = 1;
+        s->contatori.nodiEstratti = d.estratti;
+        s->contatori.archiRilassati = d.rilassati;
+        s->contatori.decreaseKey = d.aggiornamenti - (s->numRaggiunti - 1);
+        s->contatori.piccoCoda = d.piccoFrontiera;
+        s->contatori.calcolo = secondi() - inizio;
+    }
+    for(i = 0; i < d.numThread * d.numBucket; i++)
+        free(d.bucket[i].nodi);
+    for(i = 0; i < d.numThread; i++) {
+        free(d.prossimi[i].nodi);
+        free(d.elaborati[i].nodi);
+    }
+    free(d.bucket);
+    free(d.prossimi);
+    free(d.elaborati);
+    free(d.frontiera.nodi);
+    free(d.etichetta);
+    free(d.fase);
+}
+
+/*
+ * Funzione che calcola una singola tabella: se il file indica le aree usa
+ * l'SPF a aree, con --thread e una rete di almeno SOGLIA_DELTA nodi il
+ * delta-stepping, altrimenti Dijkstra
+ */
+void calcolaTabellaSingola(const struct csr *g, int start, struct statoTabella *s) {
+    const struct reteAree *r = g == &rete.csr ? aggiornaAree() : NULL;
+
+    if(r != NULL)
+        calcolaTabellaAree(r, start, &statoAreeMenu, s);
+    else if(threadTabella > 1 && g->numNodi >= SOGLIA_DELTA)
+        calcolaTabellaDelta(g, start, s, threadTabella, 0);
+    else
+        calcolaTabella(g, start, s);
+}
+
+/*
+ * Funzione che confronta due tabelle della stessa sorgente: distanze e
+ * destinazioni devono essere uguali; dove il next hop è diverso quello di b
+ * deve essere un'alternativa di pari costo, cioè il precedente di ogni nodo
+ * deve essere collegato da un arco che realizza la distanza e il next hop
+ * deve essere quello del precedente
+ *
+ * @param g grafo in formato CSR
+ * @param start ID del router di partenza
+ * @param a tabella di riferimento
+ * @param b tabella da controllare
+ * @param alternativi next hop diversi ma di pari costo, viene scritto
+ * @return numero di nodi con risultato sbagliato
+ */
+int confrontaTabelle(const struct csr *g, int start, const struct statoTabella *a, const struct statoTabella *b, int *alternativi) {
+    int errori = 0, nodo, precedente, i;
+    bool arco;
+
+    *alternativi = 0;
+    if(a->numRaggiunti != b->numRaggiunti)
+        errori++;
+    for(nodo = 0; nodo < g->numNodi; nodo++) {
+        if(a->distanza[nodo] != b->distanza[nodo]) {
+            errori++;
+            continue;
+        }
+        if(b->distanza[nodo] == INT_MAX || nodo == start)
+            continue;
+        precedente = b->precedente[nodo];
+        arco = false;
+        for(i = g->offset[precedente]; i < g->offset[precedente + 1] && !arco; i++)
+            arco = g->arrivo[i] == nodo && b->distanza[precedente] + g->costo[i] == b->distanza[nodo];
+        if(!arco || b->nextHop[nodo] != (precedente == start ? nodo : b->nextHop[precedente]))
+            errori++;
+        else if(a->nextHop[nodo] != b->nextHop[nodo])
+            (*alternativi)++;
+    }
+    return errori;
+}
+
+/*
+ * Confronto tra Dijkstra e delta-stepping, senza menu:
+ * ./dijkstra --delta [-j thread] [-d delta] [-n sorgenti] file...
+ * Calcola con i due metodi la tabella di alcune sorgenti casuali (sempre le
+ * stesse), controlla che i risultati coincidano e stampa i tempi.
+ *
+ * @param argc numero di argomenti dopo --delta
+ * @param argv argomenti dopo --delta
+ * @return codice di uscita del programma, EXIT_FAILURE se i risultati sono diversi
+ */
+int modalitaDelta(int argc, char **argv) {
+    const struct csr *g;
+    struct statoTabella sequenziale, parallelo;
+    unsigned long long seme = 1;
+    int numThread = (int)sysconf(_SC_NPROCESSORS_ONLN), delta = 0, numSorgenti = 4;
+    int i, q, start, errori = 0, alternativi, totaleAlternativi = 0;
+    double inizio, tempoSequenziale = 0, tempoParallelo = 0;
+
+    for(i = 0; i < argc; i++) {
+        if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            numThread = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+            delta = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            numSorgenti = atoi(argv[++i]);
+        else if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    g = aggiornaCSR();
+    if(g->numNodi == 0)
+        return (EXIT_FAILURE);
+    if(numThread < 1)
+        numThread = 1;
+    printf("%d nodi, %d archi, %d thread, delta %d\n", g->numNodi, g->numArchi, numThread,
+           delta > 0 ? delta : deltaAutomatico(g));
+    creaStato(&sequenziale, g->numNodi);
+    creaStato(&parallelo, g->numNodi);
+    for(q = 0; q < numSorgenti; q++) {
+        start = casualeTra(&seme, 0, g->numNodi - 1);
+        inizio = secondi();
+        calcolaTabella(g, start, &sequenziale);
+        tempoSequenziale += secondi() - inizio;
+        inizio = secondi();
+        calcolaTabellaDelta(g, start, &parallelo, numThread, delta);
+        tempoParallelo += secondi() - inizio;
+        errori += confrontaTabelle(g, start, &sequenziale, &parallelo, &alternativi);
+        totaleAlternativi += alternativi;
+    }
+    liberaStato(&sequenziale);
+    liberaStato(&parallelo);
+    printf("Dijkstra:       %9.1f ms per tabella\n", tempoSequenziale * 1e3 / numSorgenti);
+    printf("delta-stepping: %9.1f ms per tabella (speedup %.2f)\n", tempoParallelo * 1e3 / numSorgenti,
+           tempoParallelo > 0 ? tempoSequenziale / tempoParallelo : 0.0);
+    printf("%d next hop diversi ma di pari costo, %d errori\n", totaleAlternativi, errori);
+    return errori == 0 ? (EXIT_SUCCESS) : (EXIT_FAILURE);
+}
+
+/*
+ * Funzione che arrotonda una dimensione al multiplo di 8 successivo
+ */
+size_t allinea8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+/*
+ * Checksum dello snapshot (FNV-1a a 64 bit su parole da 8 byte)
+ *
+ * @param dati inizio dei dati, allineato a 8 byte
+ * @param dimensione dimensione in byte, multiplo di 8
+ */
+unsigned long long checksumSnapshot(const void *dati, size_t dimensione) {
+    const unsigned long long *parola = (const unsigned long long *)dati;
+    unsigned long long h = 14695981039346656037ull;
+    size_t i;
+
+    for(i = 0; i < dimensione / 8; i++) {
+        h ^= parola[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/*
+ * Funzione che calcola la dimensione delle sezioni dello snapshot
+ *
+ * @param in intestazione con i numeri di nodi, archi, caratteri e slot
+ * @param sezioni dimensione di ogni sezione (7 sezioni)
+ * @return dimensione totale del file
+ */
+size_t sezioniSnapshot(const struct intestazioneSnapshot *in, size_t sezioni[7]) {
+    size_t totale = sizeof(struct intestazioneSnapshot);
+    int i;
+
+    sezioni[0] = allinea8(in->dimensioneCaratteri);
+    sezioni[1] = allinea8(in->numNodi * sizeof(size_t));
+    sezioni[2] = allinea8(in->capacitaSlot * sizeof(int));
+    sezioni[3] = allinea8(in->capacitaSlot * sizeof(unsigned int));
+    sezioni[4] = allinea8((in->numNodi + 1) * sizeof(int));
+    sezioni[5] = allinea8(in->numArchi * sizeof(int));
+    sezioni[6] = allinea8(in->numArchi * sizeof(int));
+    for(i = 0; i < 7; i++)
+        totale += sezioni[i];
+    return totale;
+}
+
+/*
+ * Funzione che salva la topologia attuale in uno snapshot binario.
+ *
+ * @param nomeFile file da creare
+ * @return false se il file non può essere scritto
+ */
+bool salvaSnapshot(const char *nomeFile) {
+    const struct csr *g = aggiornaCSRCompatto();
+    struct intestazioneSnapshot in;
+    size_t sezioni[7], totale;
+    const void *sorgenti[7];
+    char *dati, *p;
+    FILE *fl;
+    int i;
+
+    memset(&in, 0, sizeof(in));
+    memcpy(in.magic, MAGIC_SNAPSHOT, 8);
+    in.versione = VERSIONE_SNAPSHOT;
+    in.ordineByte = ORDINE_BYTE;
+    in.numNodi = g->numNodi;
+    in.numArchi = g->numArchi;
+    in.dimensioneCaratteri = nomi.usati;
+    in.capacitaSlot = nomi.capacitaSlot;
+    totale = sezioniSnapshot(&in, sezioni);
+
+    /* Il file viene preparato in memoria per calcolare il checksum */
+    dati = (char *)calloc(1, totale);
+    sorgenti[0] = nomi.caratteri;
+    sorgenti[1] = nomi.inizio;
+    sorgenti[2] = nomi.slot;
+    sorgenti[3] = nomi.hashSlot;
+    sorgenti[4] = g->offset;
+    sorgenti[5] = g->arrivo;
+    sorgenti[6] = g->costo;
+    p = dati + sizeof(in);
+    memcpy(p, sorgenti[0], in.dimensioneCaratteri);
+    p += sezioni[0];
+    memcpy(p, sorgenti[1], in.numNodi * sizeof(size_t));
+    p += sezioni[1];
+    memcpy(p, sorgenti[2], in.capacitaSlot * sizeof(int));
+    p += sezioni[2];
+    memcpy(p, sorgenti[3], in.capacitaSlot * sizeof(unsigned int));
+    p += sezioni[3];
+    memcpy(p, sorgenti[4], (in.numNodi + 1) * sizeof(int));
+    p += sezioni[4];
+    for(i = 5; i < 7; i++) {
+        memcpy(p, sorgenti[i], in.numArchi * sizeof(int));
+        p += sezioni[i];
+    }
+    in.checksum = checksumSnapshot(dati + sizeof(in), totale - sizeof(in));
+    memcpy(dati, &in, sizeof(in));
+
+    fl = fopen(nomeFile, "wb");
+    if(fl == NULL) {
+        free(dati);
+        return false;
+    }
+    if(fwrite(dati, 1, totale, fl) != totale) {
+        fclose(fl);
+        free(dati);
+        return false;
+    }
+    free(dati);
+    return fclose(fl) == 0;
+}
+
+/*
+ * Funzione che carica uno snapshot binario: il file viene mappato in memoria
+ * e nomi e CSR puntano direttamente dentro la mappa, senza analizzare nulla.
+ * Si può fare solo se la topologia è ancora vuota.
+ *
+ * @param nomeFile file dello snapshot
+ * @return false se il file non esiste o non è uno snapshot valido
+ */
+bool caricaSnapshot(const char *nomeFile) {
+    struct intestazioneSnapshot in;
+    size_t sezioni[7];
+    struct stat info;
+    char *dati, *p;
+    int fd;
+
+    if(nomi.numNomi > 0 || rete.numArchi > 0) {
+        fprintf(stderr, "%s: lo snapshot va caricato prima di ogni altro file\n", nomeFile);
+        return false;
+    }
+    fd = open(nomeFile, O_RDONLY);
+    if(fd < 0)
+        return false;
+    if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(in)) {
+        close(fd);
+        fprintf(stderr, "%s: snapshot non valido\n", nomeFile);
+        return false;
+    }
+    dati = (char *)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(dati == MAP_FAILED)
+        return false;
+    memcpy(&in, dati, sizeof(in));
+    if(memcmp(in.magic, MAGIC_SNAPSHOT, 8) != 0 || in.versione != VERSIONE_SNAPSHOT
+       || in.ordineByte != ORDINE_BYTE || in.numNodi >= INT_MAX || in.numArchi >= INT_MAX
+       || sezioniSnapshot(&in, sezioni) != (size_t)info.st_size
+       || checksumSnapshot(dati + sizeof(in), info.st_size - sizeof(in)) != in.checksum) {
+        munmap(dati, info.st_size);
+        fprintf(stderr, "%s: snapshot non valido o danneggiato\n", nomeFile);
+        return false;
+    }
+
+    mappa.dati = dati;
+    mappa.dimensione = info.st_size;
+    p = dati + sizeof(in);
+    nomi.caratteri = p;
+    nomi.usati = nomi.capacitaCaratteri = in.dimensioneCaratteri;
+    p += sezioni[0];
+    nomi.inizio = (size_t *)p;
+    nomi.numNomi = nomi.capacitaNomi = in.numNodi;
+    p += sezioni[1];
+    nomi.slot = (int *)p;
+    nomi.capacitaSlot = in.capacitaSlot;
+    p += sezioni[2];
+    nomi.hashSlot = (unsigned int *)p;
+    p += sezioni[3];
+    rete.csr.numNodi = in.numNodi;
+    rete.csr.numArchi = in.numArchi;
+    rete.csr.offset = (int *)p;
+    p += sezioni[4];
+    rete.csr.arrivo = (int *)p;
+    p += sezioni[5];
+    rete.csr.costo = (int *)p;
+    aggiornaCostiEstremi(&rete.csr);
+    /* Il CSR mappato non si può correggere sul posto */
+    free(rete.buchi);
+    rete.buchi = NULL;
+    rete.numBuchi = 0;
+    rete.csrValido = true;
+    rete.entrateValide = false;
+    return true;
+}
+
+/*
+ * Funzione chiamata prima di modificare la topologia: se nomi e CSR puntano
+ * ancora dentro uno snapshot mappato vengono copiati in memoria normale e
+ * viene ricostruita la lista degli archi, poi lo snapshot viene chiuso.
+ */
+void staccaSnapshot() {
+    struct csr *g = &rete.csr;
+    void *dati = mappa.dati;
+    unsigned long long generazione = generazioneTopologia;
+    int *offset, *arrivo, *costo;
+    int i, j;
+
+    if(dati == NULL)
+        return;
+    mappa.dati = NULL;
+    nomi.caratteri = (char *)memcpy(malloc(nomi.usati + 1), nomi.caratteri, nomi.usati);
+    nomi.inizio = (size_t *)memcpy(malloc((nomi.numNomi + 1) * sizeof(size_t)), nomi.inizio, nomi.numNomi * sizeof(size_t));
+    nomi.slot = (int *)memcpy(malloc(nomi.capacitaSlot * sizeof(int)), nomi.slot, nomi.capacitaSlot * sizeof(int));
+    nomi.hashSlot = (unsigned int *)memcpy(malloc(nomi.capacitaSlot * sizeof(unsigned int)), nomi.hashSlot, nomi.capacitaSlot * sizeof(unsigned int));
+    offset = g->offset;
+    arrivo = g->arrivo;
+    costo = g->costo;
+    g->offset = g->arrivo = g->costo = NULL;
+    /* La lista degli archi viene ricostruita dal CSR */
+    for(i = 0; i < g->numNodi; i++)
+        for(j = offset[i]; j < offset[i + 1]; j++)
+            inserisciArco(i, arrivo[j], costo[j]);
+    munmap(dati, mappa.dimensione);
+    aggiornaCSR();
+    /* La topologia non è cambiata, gli alberi in cache restano validi */
+    generazioneTopologia = generazione;
+}
+
+/*
+ * Modalità per creare uno snapshot dai file di testo:
+ * ./dijkstra --compila rete.snap rete1.txt rete2.txt
+ *
+ * @param argc numero di argomenti dopo --compila
+ * @param argv argomenti dopo --compila
+ * @return codice di uscita del programma
+ */
+int compilaSnapshot(int argc, char **argv) {
+    int i;
+
+    for(i = 1; i < argc; i++) {
+        if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    if(!salvaSnapshot(argv[0])) {
+        fprintf(stderr, "Impossibile scrivere %s\n", argv[0]);
+        return (EXIT_FAILURE);
+    }
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * Funzione che costruisce gli archi entranti di ogni nodo (CSR del grafo
+ * trasposto), servono per riparare gli alberi in cache quando un link
+ * viene rimosso o il suo costo aumenta e per la ricerca all'indietro del
+ * percorso tra due router.
+ *
+ * @return grafo in formato CSR con anche gli archi entranti
+ */
+const struct csr *aggiornaEntrate() {
+    struct csr *g = (struct csr *)aggiornaCSR();
+    int i, j, *posizione;
+
+    if(rete.entrateValide)
+        return g;
+    g->offsetEntrata = (int *)realloc(g->offsetEntrata, (g->numNodi + 1) * sizeof(int));
+    g->partenzaEntrata = (int *)realloc(g->partenzaEntrata, (g->numArchi + 1) * sizeof(int));
+    g->costoEntrata = (int *)realloc(g->costoEntrata, (g->numArchi + 1) * sizeof(int));
+    memset(g->offsetEntrata, 0, (g->numNodi + 1) * sizeof(int));
+    for(i = 0; i < g->numArchi; i++)
+        g->offsetEntrata[g->arrivo[i] + 1]++;
+    for(i = 0; i < g->numNodi; i++)
+        g->offsetEntrata[i + 1] += g->offsetEntrata[i];
+    posizione = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    memcpy(posizione, g->offsetEntrata, (g->numNodi + 1) * sizeof(int));
+    for(i = 0; i < g->numNodi; i++) {
+        for(j = g->offset[i]; j < g->offset[i + 1]; j++) {
+            g->partenzaEntrata[posizione[g->arrivo[j]]] = i;
+            g->costoEntrata[posizione[g->arrivo[j]]++] = g->costo[j];
+        }
+    }
+    free(posizione);
+    /* I buchi i -> i finiscono nella riga i degli archi entranti */
+    rete.buchiEntrata = (int *)realloc(rete.buchiEntrata, (g->numNodi + 1) * sizeof(int));
+    memcpy(rete.buchiEntrata, rete.buchi, (g->numNodi + 1) * sizeof(int));
+    rete.entrateValide = true;
+    return g;
+}
+
+/*
+ * Funzione che allarga lo stato di una tabella quando nella rete compaiono
+ * nuovi router
+ */
+void allargaStato(struct statoTabella *s, int numNodi) {
+    int i;
+
+    if(numNodi <= s->numNodi)
+        return;
+    contaAllocazione((size_t)(numNodi - s->numNodi) * 7 * sizeof(int));
+    s->distanza = (int *)realloc(s->distanza, (numNodi + 1) * sizeof(int));
+    s->nextHop = (int *)realloc(s->nextHop, (numNodi + 1) * sizeof(int));
+    s->precedente = (int *)realloc(s->precedente, (numNodi + 1) * sizeof(int));
+    s->ordine = (int *)realloc(s->ordine, (numNodi + 1) * sizeof(int));
+    s->coda.nodi = (int *)realloc(s->coda.nodi, (numNodi + 1) * sizeof(int));
+    s->coda.valori = (int *)realloc(s->coda.valori, (numNodi + 1) * sizeof(int));
+    s->coda.posizione = (int *)realloc(s->coda.posizione, (numNodi + 1) * sizeof(int));
+    for(i = s->numNodi; i < numNodi; i++) {
+        s->distanza[i] = INT_MAX;
+        s->coda.posizione[i] = -1;
+    }
+    s->numNodi = numNodi;
+}
+
+/*
+ * Funzione che calcola quanta memoria occupa un albero in cache
+ */
+size_t memoriaAlbero(const struct alberoSPF *a) {
+    /* distanza, nextHop, precedente, ordine, tre array del heap e tre dei
+       figli, più le teste dei bucket */
+    return sizeof(struct alberoSPF) + (size_t)(a->stato.numNodi + 1) * 10 * sizeof(int)
+           + LIMITE_DIAL * sizeof(int);
+}
+
+/*
+ * Funzione che allarga un albero in cache quando compaiono nuovi router
+ */
+void allargaAlbero(struct alberoSPF *a, int numNodi) {
+    int i, vecchio = a->stato.numNodi;
+
+    if(numNodi <= vecchio)
+        return;
+    cache.memoria -= memoriaAlbero(a);
+    allargaStato(&a->stato, numNodi);
+    a->primoFiglio = (int *)realloc(a->primoFiglio, (numNodi + 1) * sizeof(int));
+    a->fratelloSucc = (int *)realloc(a->fratelloSucc, (numNodi + 1) * sizeof(int));
+    a->fratelloPrec = (int *)realloc(a->fratelloPrec, (numNodi + 1) * sizeof(int));
+    for(i = vecchio; i < numNodi; i++)
+        a->primoFiglio[i] = -1;
+    cache.memoria += memoriaAlbero(a);
+}
+
+/*
+ * Funzione che inserisce figlio tra i figli di padre nell'albero
+ */
+void collegaFiglio(struct alberoSPF *a, int figlio, int padre) {
+    a->fratelloPrec[figlio] = -1;
+    a->fratelloSucc[figlio] = a->primoFiglio[padre];
+    if(a->primoFiglio[padre] != -1)
+        a->fratelloPrec[a->primoFiglio[padre]] = figlio;
+    a->primoFiglio[padre] = figlio;
+}
+
+/*
+ * Funzione che toglie figlio dalla lista dei figli del suo padre attuale
+ */
+void scollegaFiglio(struct alberoSPF *a, int figlio) {
+    if(a->fratelloPrec[figlio] != -1)
+        a->fratelloSucc[a->fratelloPrec[figlio]] = a->fratelloSucc[figlio];
+    else
+        a->primoFiglio[a->stato.precedente[figlio]] = a->fratelloSucc[figlio];
+    if(a->fratelloSucc[figlio] != -1)
+        a->fratelloPrec[a->fratelloSucc[figlio]] = a->fratelloPrec[figlio];
+}
+
+/*
+ * Funzione che alloca un albero vuoto per una sorgente
+ *
+ * @param start ID del router di partenza
+ * @return nuovo albero, da calcolare con ricalcolaAlbero
+ */
+struct alberoSPF *creaAlbero(int start) {
+    const struct csr *g = aggiornaCSR();
+    struct alberoSPF *a = (struct alberoSPF *)malloc(sizeof(struct alberoSPF));
+
+    a->sorgente = start;
+    creaStato(&a->stato, g->numNodi);
+    a->primoFiglio = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    a->fratelloSucc = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    a->fratelloPrec = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    a->prec = a->succ = NULL;
+    return a;
+}
+
+/*
+ * Funzione che calcola da zero l'albero dei cammini minimi della sorgente
+ * e lo segna come aggiornato alla generazione attuale della topologia
+ */
+void ricalcolaAlbero(struct alberoSPF *a) {
+    const struct csr *g = aggiornaCSR();
+    int i, nodo;
+
+    allargaAlbero(a, g->numNodi);
+    calcolaTabellaSingola(g, a->sorgente, &a->stato);
+    segnaFibTutto(a->sorgente);
+    if(formatoStatistiche != STATISTICHE_SPENTE)
+        sommaStatistiche(&statistiche, &a->stato.contatori);
+    for(i = 0; i < g->numNodi; i++)
+        a->primoFiglio[i] = -1;
+    for(i = 1; i < a->stato.numRaggiunti; i++) {
+        nodo = a->stato.ordine[i];
+        collegaFiglio(a, nodo, a->stato.precedente[nodo]);
+    }
+    a->generazione = generazioneTopologia;
+}
+
+/*
+ * Funzione che libera la memoria di un albero
+ */
+void liberaAlbero(struct alberoSPF *a) {
+    liberaStato(&a->stato);
+    free(a->primoFiglio);
+    free(a->fratelloSucc);
+    free(a->fratelloPrec);
+    free(a);
+}
+
+/*
+ * Funzione che toglie un albero dalla lista LRU
+ */
+void staccaLRU(struct alberoSPF *a) {
+    if(a->prec != NULL)
+        a->prec->succ = a->succ;
+    else
+        cache.recente = a->succ;
+    if(a->succ != NULL)
+        a->succ->prec = a->prec;
+    else
+        cache.vecchio = a->prec;
+    a->prec = a->succ = NULL;
+}
+
+/*
+ * Funzione che mette un albero in testa alla lista LRU (usato più di recente)
+ */
+void inTestaLRU(struct alberoSPF *a) {
+    a->prec = NULL;
+    a->succ = cache.recente;
+    if(cache.recente != NULL)
+        cache.recente->prec = a;
+    cache.recente = a;
+    if(cache.vecchio == NULL)
+        cache.vecchio = a;
+}
+
+/*
+ * Funzione che restituisce l'albero di una sorgente. Se è in cache ed è
+ * della generazione attuale della topologia non costa niente, se è vecchio
+ * viene ricalcolato, se manca viene calcolato e aggiunto eliminando gli
+ * alberi usati meno di recente finché la cache rientra nel budget.
+ *
+ * @param start ID del router di partenza
+ * @return albero aggiornato
+ */
+struct alberoSPF *alberoPerSorgente(int start) {
+    const struct csr *g = aggiornaCSR();
+    struct alberoSPF *a;
+    int i;
+
+    /* Indice per sorgente, allargato se sono comparsi nuovi router */
+    if(cache.numSorgenti < g->numNodi) {
+        cache.perSorgente = (struct alberoSPF **)realloc(cache.perSorgente, g->numNodi * sizeof(struct alberoSPF *));
+        for(i = cache.numSorgenti; i < g->numNodi; i++)
+            cache.perSorgente[i] = NULL;
+        cache.numSorgenti = g->numNodi;
+    }
+    a = cache.perSorgente[start];
+    if(a != NULL) {
+        staccaLRU(a);
+        inTestaLRU(a);
+        if(a->generazione == generazioneTopologia) {
+            cache.hit++;
+            return a;
+        }
+        cache.invalidati++;
+        cache.miss++;
+        ricalcolaAlbero(a);
+        return a;
+    }
+
+    cache.miss++;
+    a = creaAlbero(start);
+    ricalcolaAlbero(a);
+    cache.perSorgente[start] = a;
+    cache.memoria += memoriaAlbero(a);
+    cache.numAlberi++;
+    inTestaLRU(a);
+    /* Rispetto del budget, l'albero appena calcolato non viene mai eliminato */
+    while(cache.memoria > cache.budget && cache.vecchio != a) {
+        eliminaAlbero(cache.vecchio);
+        cache.eliminati++;
+    }
+    return a;
+}
+
+/*
+ * Funzione che elimina un albero dalla cache
+ */
+void eliminaAlbero(struct alberoSPF *a) {
+    staccaLRU(a);
+    cache.perSorgente[a->sorgente] = NULL;
+    cache.memoria -= memoriaAlbero(a);
+    cache.numAlberi--;
+    liberaAlbero(a);
+}
+
+/*
+ * Funzione che stampa i contatori della cache delle tabelle
+ */
+void mostraStatisticheCache() {
+    printf("Cache delle tabelle:\n");
+    printf("Alberi in cache: %d\n", cache.numAlberi);
+    printf("Memoria usata: %.1f MB su %.1f MB\n", cache.memoria / 1048576.0, cache.budget / 1048576.0);
+    printf("Hit: %lld\nMiss: %lld\n", cache.hit, cache.miss);
+    printf("Eliminati (LRU): %lld\nInvalidati (topologia cambiata): %lld\n", cache.eliminati, cache.invalidati);
+    printf("Generazione della topologia: %llu\n\n", generazioneTopologia);
+    if(aree.valida && aree.numAreeUsate >= 2) {
+        printf("Aree: %d, router di bordo: %d, area più grande: %d router\n", aree.numAreeUsate, aree.numBordi, aree.maxNodiArea);
+        printf("Sommari ricalcolati: %lld aree, %.3f s\n\n", aree.ricalcoli, aree.tempoSommari);
+    }
+    stampaMemoria();
+    if(formatoStatistiche != STATISTICHE_SPENTE) {
+        printf("\n");
+        stampaStatistiche(stdout, NULL, &statistiche);
+    }
+    printf("\n\nPremi invio per continuare...\n");
+    getchar();
+    getchar();
+}
+
+/*
+ * Funzione che propaga i costi minori a partire dai nodi già nella coda,
+ * come Dijkstra, fermandosi dove i costi non migliorano.
+ *
+ * @param g grafo in formato CSR
+ * @param a albero da riparare
+ * @return numero di nodi estratti dalla coda
+ */
+int propagaAlbero(const struct csr *g, struct alberoSPF *a) {
+    struct statoTabella *s = &a->stato;
+    int nodo, arrivo, costo, i, toccati = 0;
+
+    while(s->coda.dimensione > 0) {
+        nodo = estraiMinimo(&s->coda);
+        toccati++;
+        for(i = g->offset[nodo]; i < g->offset[nodo + 1]; i++) {
+            arrivo = g->arrivo[i];
+            costo = s->distanza[nodo] + g->costo[i];
+            if(costo >= s->distanza[arrivo])
+                continue;
+            if(s->distanza[arrivo] == INT_MAX)
+                s->ordine[s->numRaggiunti++] = arrivo;
+            else
+                scollegaFiglio(a, arrivo);
+            s->distanza[arrivo] = costo;
+            s->precedente[arrivo] = nodo;
+            s->nextHop[arrivo] = nodo == a->sorgente ? arrivo : s->nextHop[nodo];
+            collegaFiglio(a, arrivo, nodo);
+            segnaFib(a->sorgente, arrivo);
+            inserisciHeap(&s->coda, arrivo, costo);
+        }
+    }
+    return toccati;
+}
+
+/*
+ * Funzione che ripara un albero quando il link partenza -> arrivo è stato
+ * aggiunto o il suo costo è diminuito: migliorano solo arrivo e i nodi che
+ * ci passano attraverso.
+ *
+ * @param g grafo in formato CSR già aggiornato
+ * @param a albero da riparare
+ * @param partenza router di partenza del link
+ * @param arrivo router di arrivo del link
+ * @param costo nuovo costo del link
+ * @return numero di nodi toccati
+ */
+int riparaDiminuzione(const struct csr *g, struct alberoSPF *a, int partenza, int arrivo, int costo) {
+    struct statoTabella *s = &a->stato;
+
+    if(s->distanza[partenza] == INT_MAX || s->distanza[partenza] + costo >= s->distanza[arrivo])
+        return 0;
+    if(s->distanza[arrivo] == INT_MAX)
+        s->ordine[s->numRaggiunti++] = arrivo;
+    else
+        scollegaFiglio(a, arrivo);
+    s->distanza[arrivo] = s->distanza[partenza] + costo;
+    s->precedente[arrivo] = partenza;
+    s->nextHop[arrivo] = partenza == a->sorgente ? arrivo : s->nextHop[partenza];
+    collegaFiglio(a, arrivo, partenza);
+    segnaFib(a->sorgente, arrivo);
+    inserisciHeap(&s->coda, arrivo, s->distanza[arrivo]);
+    return propagaAlbero(g, a);
+}
+
+/*
+ * Funzione che ripara un albero quando il link partenza -> arrivo è stato
+ * rimosso o il suo costo è aumentato. Se il link era nell'albero tutto il
+ * sottoalbero di arrivo viene staccato e ricalcolato partendo dagli archi
+ * entranti che arrivano da fuori del sottoalbero.
+ *
+ * @param g grafo in formato CSR con gli archi entranti, già aggiornato
+ * @param a albero da riparare
+ * @param partenza router di partenza del link
+ * @param arrivo router di arrivo del link
+ * @param vecchioCosto costo che il link aveva prima della modifica
+ * @return numero di nodi toccati
+ */
+int riparaAumento(const struct csr *g, struct alberoSPF *a, int partenza, int arrivo, int vecchioCosto) {
+    struct statoTabella *s = &a->stato;
+    int *sottoalbero, numSottoalbero = 0, i, j, nodo, figlio, costo, raggiunti;
+
+    /* Il link non era usato dall'albero, nessun costo cambia */
+    if(arrivo == a->sorgente || s->distanza[partenza] == INT_MAX || s->precedente[arrivo] != partenza
+       || s->distanza[partenza] + vecchioCosto != s->distanza[arrivo])
+        return 0;
+
+    /* Ricerca del sottoalbero di arrivo (visita in ampiezza) */
+    if(cache.capacitaSottoalbero < g->numNodi) {
+        cache.capacitaSottoalbero = g->numNodi > 2 * cache.capacitaSottoalbero ? g->numNodi : 2 * cache.capacitaSottoalbero;
+        cache.sottoalbero = (int *)realloc(cache.sottoalbero, cache.capacitaSottoalbero * sizeof(int));
+    }
+    sottoalbero = cache.sottoalbero;
+    scollegaFiglio(a, arrivo);
+    sottoalbero[numSottoalbero++] = arrivo;
+    for(i = 0; i < numSottoalbero; i++)
+        for(figlio = a->primoFiglio[sottoalbero[i]]; figlio != -1; figlio = a->fratelloSucc[figlio])
+            sottoalbero[numSottoalbero++] = figlio;
+    for(i = 0; i < numSottoalbero; i++) {
+        s->distanza[sottoalbero[i]] = INT_MAX;
+        a->primoFiglio[sottoalbero[i]] = -1;
+        segnaFib(a->sorgente, sottoalbero[i]);
+    }
+
+    /* Ogni nodo del sottoalbero riparte dal miglior arco entrante che arriva
+       da un nodo rimasto fuori (quelli del sottoalbero ora hanno costo infinito) */
+    for(i = 0; i < numSottoalbero; i++) {
+        nodo = sottoalbero[i];
+        for(j = g->offsetEntrata[nodo]; j < g->offsetEntrata[nodo + 1]; j++) {
+            if(s->distanza[g->partenzaEntrata[j]] == INT_MAX)
+                continue;
+            costo = s->distanza[g->partenzaEntrata[j]] + g->costoEntrata[j];
+            if(costo < s->distanza[nodo]) {
+                s->distanza[nodo] = costo;
+                s->precedente[nodo] = g->partenzaEntrata[j];
+                s->nextHop[nodo] = g->partenzaEntrata[j] == a->sorgente ? nodo : s->nextHop[g->partenzaEntrata[j]];
+            }
+        }
+        if(s->distanza[nodo] != INT_MAX)
+            inserisciHeap(&s->coda, nodo, s->distanza[nodo]);
+    }
+    /* I figli vengono ricollegati alla fine, quando i padri sono definitivi */
+    for(i = 0; i < numSottoalbero; i++)
+        s->precedente[sottoalbero[i]] = s->distanza[sottoalbero[i]] == INT_MAX ? -1 : s->precedente[sottoalbero[i]];
+    propagaSottoalbero(g, a);
+    for(i = 0; i < numSottoalbero; i++)
+        if(s->distanza[sottoalbero[i]] != INT_MAX)
+            collegaFiglio(a, sottoalbero[i], s->precedente[sottoalbero[i]]);
+
+    /* I nodi rimasti irraggiungibili escono dalla tabella */
+    raggiunti = 0;
+    for(i = 0; i < s->numRaggiunti; i++)
+        if(s->distanza[s->ordine[i]] != INT_MAX)
+            s->ordine[raggiunti++] = s->ordine[i];
+    s->numRaggiunti = raggiunti;
+    return numSottoalbero;
+}
+
+/*
+ * Come propagaAlbero, ma senza aggiornare i figli: usata mentre il
+ * sottoalbero staccato viene ricalcolato, i figli vengono ricollegati dopo
+ */
+void propagaSottoalbero(const struct csr *g, struct alberoSPF *a) {
+    struct statoTabella *s = &a->stato;
+    int nodo, arrivo, costo, i;
+
+    while(s->coda.dimensione > 0) {
+        nodo = estraiMinimo(&s->coda);
+        for(i = g->offset[nodo]; i < g->offset[nodo + 1]; i++) {
+            arrivo = g->arrivo[i];
+            costo = s->distanza[nodo] + g->costo[i];
+            if(costo >= s->distanza[arrivo])
+                continue;
+            s->distanza[arrivo] = costo;
+            s->precedente[arrivo] = nodo;
+            s->nextHop[arrivo] = nodo == a->sorgente ? arrivo : s->nextHop[nodo];
+            inserisciHeap(&s->coda, arrivo, costo);
+        }
+    }
+}
+
+/*
+ * Funzione da chiamare subito dopo aver modificato un link: ripara gli alberi
+ * in cache che erano aggiornati prima della modifica (SPF incrementale),
+ * quelli più vecchi verranno ricalcolati quando servono.
+ *
+ * @param partenza router di partenza del link
+ * @param arrivo router di arrivo del link
+ * @param vecchioCosto costo prima della modifica, INT_MAX se il link è nuovo
+ * @param nuovoCosto costo dopo la modifica, INT_MAX se il link è stato rimosso
+ * @return numero totale di nodi toccati
+ */
+int aggiornaAlberi(int partenza, int arrivo, int vecchioCosto, int nuovoCosto) {
+    const struct csr *g = aggiornaEntrate();
+    struct alberoSPF *a;
+    int toccati = 0;
+
+    for(a = cache.recente; a != NULL; a = a->succ) {
+        if(a->generazione != generazioneTopologia - 1)
+            continue;
+        allargaAlbero(a, g->numNodi);
+        if(nuovoCosto < vecchioCosto)
+            toccati += riparaDiminuzione(g, a, partenza, arrivo, nuovoCosto);
+        else if(nuovoCosto > vecchioCosto)
+            toccati += riparaAumento(g, a, partenza, arrivo, vecchioCosto);
+        a->generazione = generazioneTopologia;
+    }
+    return toccati;
+}
+
+/*
+ * Funzione che stampa quanto lavoro ha richiesto l'aggiornamento degli
+ * alberi in cache dopo una modifica
+ */
+void stampaAggiornamento(int toccati) {
+    if(cache.numAlberi > 0)
+        printf("Tabelle in cache aggiornate: %d, nodi toccati: %d\n", cache.numAlberi, toccati);
+}
+
+/*
+ * Funzione che permette di cambiare il costo di una connessione esistente
+ * senza doverla rimuovere e aggiungere di nuovo
+ */
+void modificaCosto() {
+    char *rPartenza, *rArrivo;
+    int idPartenza, idArrivo, costo, vecchioCosto;
+
+    printf("Modifica costo connessione:\n");
+    printf("Inserisci router di partenza: ");
+    rPartenza = leggiParola();
+    printf("Inserisci router di arrivo: ");
+    rArrivo = leggiParola();
+    printf("Inserisci nuovo costo: ");
+    if(rPartenza == NULL || rArrivo == NULL || scanf("%d", &costo) != 1)
+        exit(EXIT_SUCCESS);
+    idPartenza = cercaNome(rPartenza);
+    idArrivo = cercaNome(rArrivo);
+    free(rPartenza);
+    free(rArrivo);
+    if(costo < 0) {
+        printf("\nIl costo non può essere negativo!\n");
+        return;
+    }
+
+    if(idPartenza >= 0 && idArrivo >= 0 && modificaCostoArco(idPartenza, idArrivo, costo, &vecchioCosto)) {
+        printf("\nCosto modificato con successo!\n");
+        stampaAggiornamento(aggiornaAlberi(idPartenza, idArrivo, vecchioCosto, costo));
+        return;
+    }
+    printf("\nConnessione non esistente!\n");
+}
+
+/*
+ * Funzione che salva le coordinate di un router (righe @router;x;y dei file)
+ */
+void impostaCoordinate(int nodo, double x, double y) {
+    int i;
+
+    if(nodo >= posizioni.capacita) {
+        i = posizioni.capacita;
+        posizioni.capacita = posizioni.capacita == 0 ? 64 : 2 * posizioni.capacita;
+        while(posizioni.capacita <= nodo)
+            posizioni.capacita *= 2;
+        posizioni.x = (double *)realloc(posizioni.x, posizioni.capacita * sizeof(double));
+        posizioni.y = (double *)realloc(posizioni.y, posizioni.capacita * sizeof(double));
+        posizioni.presente = (bool *)realloc(posizioni.presente, posizioni.capacita * sizeof(bool));
+        for(; i < posizioni.capacita; i++)
+            posizioni.presente[i] = false;
+    }
+    if(!posizioni.presente[nodo])
+        posizioni.numPresenti++;
+    posizioni.presente[nodo] = true;
+    posizioni.x[nodo] = x;
+    posizioni.y[nodo] = y;
+    posizioni.scalaValida = false;
+}
+
+/*
+ * Funzione che calcola il costo minimo per unità di distanza tra tutti i
+ * link: con questa scala la distanza in linea d'aria moltiplicata per scala
+ * non supera mai il costo vero, quindi la stima di A* è ammissibile e consistente
+ *
+ * @return true se tutti i router hanno le coordinate e si può usare A*
+ */
+bool aggiornaScala() {
+    const struct csr *g = aggiornaCSR();
+    double distanza;
+    int i, j;
+
+    if(posizioni.numPresenti < g->numNodi || g->numNodi == 0)
+        return false;
+    if(posizioni.scalaValida && posizioni.generazione == generazioneTopologia)
+        return true;
+    posizioni.scala = -1;
+    for(i = 0; i < g->numNodi; i++) {
+        for(j = g->offset[i]; j < g->offset[i + 1]; j++) {
+            distanza = sqrt((posizioni.x[i] - posizioni.x[g->arrivo[j]]) * (posizioni.x[i] - posizioni.x[g->arrivo[j]])
+                            + (posizioni.y[i] - posizioni.y[g->arrivo[j]]) * (posizioni.y[i] - posizioni.y[g->arrivo[j]]));
+            if(distanza > 0 && (posizioni.scala < 0 || g->costo[j] / distanza < posizioni.scala))
+                posizioni.scala = g->costo[j] / distanza;
+        }
+    }
+    /* Margine per gli errori di arrotondamento, senza link tra punti
+       distinti la stima resta 0 */
+    posizioni.scala = posizioni.scala > 0 ? posizioni.scala * (1 - 1e-9) : 0;
+    posizioni.scalaValida = true;
+    posizioni.generazione = generazioneTopologia;
+    return true;
+}
+
+/*
+ * Stima di A* del costo tra due router, arrotondata per difetto
+ */
+int stimaCosto(int nodo, int arrivo) {
+    double dx = posizioni.x[nodo] - posizioni.x[arrivo], dy = posizioni.y[nodo] - posizioni.y[arrivo];
+    double stima = posizioni.scala * sqrt(dx * dx + dy * dy);
+
+    return stima < INT_MAX / 4 ? (int)stima : INT_MAX / 4;
+}
+
+/*
+ * Potenziale di un nodo per A* bidirezionale: metà della differenza tra la
+ * stima verso arrivo e quella verso partenza, arrotondata per difetto.
+ * Con questo potenziale i costi ridotti restano non negativi in tutte e due
+ * le direzioni, quindi le due ricerche possono usare lo stesso criterio di
+ * arresto di Dijkstra bidirezionale.
+ */
+int potenziale(int nodo, int partenza, int arrivo) {
+    int differenza = stimaCosto(nodo, arrivo) - stimaCosto(nodo, partenza);
+
+    return differenza >= 0 ? differenza / 2 : -((1 - differenza) / 2);
+}
+
+/*
+ * Funzione che prepara uno stato per una nuova ricerca: azzera solo i nodi
+ * toccati dalla ricerca precedente e svuota la coda, che dopo una
+ * terminazione anticipata può contenere ancora dei nodi
+ */
+void azzeraRicerca(struct statoTabella *s, int numNodi) {
+    int i;
+
+    allargaStato(s, numNodi);
+    for(i = 0; i < s->numRaggiunti; i++)
+        s->distanza[s->ordine[i]] = INT_MAX;
+    for(i = 0; i < s->coda.dimensione; i++)
+        s->coda.posizione[s->coda.nodi[i]] = -1;
+    s->coda.dimensione = 0;
+    s->numRaggiunti = 0;
+}
+
+/*
+ * Funzione che aggiorna costo e precedente di un nodo e lo mette in coda
+ */
+void raggiungiNodo(struct statoTabella *s, int nodo, int costo, int precedente, int priorita) {
+    if(s->distanza[nodo] == INT_MAX)
+        s->ordine[s->numRaggiunti++] = nodo;
+    s->distanza[nodo] = costo;
+    s->precedente[nodo] = precedente;
+    inserisciHeap(&s->coda, nodo, priorita);
+}
+
+/*
+ * Funzione che cerca il percorso minimo tra due router senza calcolare
+ * tutta la tabella, con Dijkstra bidirezionale: una ricerca parte da
+ * partenza sugli archi uscenti e una da arrivo sugli archi entranti, e ci
+ * si ferma appena la somma dei due minimi in coda non può più migliorare il
+ * miglior percorso trovato. Se tutti i router hanno le coordinate le
+ * priorità sono spostate dal potenziale di A*, così le due ricerche vanno
+ * verso la destinazione invece di allargarsi in tutte le direzioni.
+ *
+ * @param partenza ID del router di partenza
+ * @param arrivo ID del router di arrivo
+ * @param percorso array con i router del percorso, da liberare con free
+ * @param numHop numero di router nel percorso (partenza e arrivo compresi)
+ * @param estratti numero di nodi estratti dalle code
+ * @return costo del percorso, INT_MAX se arrivo non è raggiungibile
+ */
+int cercaPercorso(int partenza, int arrivo, int **percorso, int *numHop, int *estratti) {
+    const struct csr *g = aggiornaEntrate();
+    struct statoTabella *a = &ricercaAvanti, *b = &ricercaIndietro, *s, *altra;
+    long long migliore = INT_MAX;
+    bool usaStima = aggiornaScala();
+    int nodo, vicino, costo, incontro = -1, i, numAvanti, numIndietro, segno;
+    const int *offsetLato, *vicinoLato, *costoLato;
+
+    *estratti = 0;
+    azzeraRicerca(a, g->numNodi);
+    azzeraRicerca(b, g->numNodi);
+    raggiungiNodo(a, partenza, 0, partenza, usaStima ? potenziale(partenza, partenza, arrivo) : 0);
+    raggiungiNodo(b, arrivo, 0, arrivo, usaStima ? -potenziale(arrivo, partenza, arrivo) : 0);
+    if(partenza == arrivo) {
+        migliore = 0;
+        incontro = partenza;
+    }
+    /* Le priorità sono costo + potenziale in avanti e costo - potenziale
+       all'indietro, nella somma i potenziali si annullano */
+    while(a->coda.dimensione > 0 && b->coda.dimensione > 0
+          && (long long)a->coda.valori[0] + b->coda.valori[0] < migliore) {
+        /* Avanza la ricerca con la coda più piccola */
+        if(a->coda.dimensione <= b->coda.dimensione) {
+            s = a;
+            altra = b;
+            segno = 1;
+            offsetLato = g->offset;
+            vicinoLato = g->arrivo;
+            costoLato = g->costo;
+        }
+        else {
+            s = b;
+            altra = a;
+            segno = -1;
+            offsetLato = g->offsetEntrata;
+            vicinoLato = g->partenzaEntrata;
+            costoLato = g->costoEntrata;
+        }
+        nodo = estraiMinimo(&s->coda);
+        (*estratti)++;
+        for(i = offsetLato[nodo]; i < offsetLato[nodo + 1]; i++) {
+            vicino = vicinoLato[i];
+            costo = s->distanza[nodo] + costoLato[i];
+            if(costo >= s->distanza[vicino])
+                continue;
+            raggiungiNodo(s, vicino, costo, nodo, usaStima ? costo + segno * potenziale(vicino, partenza, arrivo) : costo);
+            /* Il nodo è già stato raggiunto anche dall'altra ricerca */
+            if(altra->distanza[vicino] != INT_MAX && (long long)costo + altra->distanza[vicino] < migliore) {
+                migliore = (long long)costo + altra->distanza[vicino];
+                incontro = vicino;
+            }
+        }
+    }
+
+    *numHop = 0;
+    *percorso = NULL;
+    if(incontro < 0)
+        return INT_MAX;
+    /* Da incontro si torna indietro fino a partenza con la ricerca in avanti
+       e si va avanti fino ad arrivo con quella all'indietro */
+    for(numAvanti = 1, nodo = incontro; nodo != partenza; nodo = a->precedente[nodo])
+        numAvanti++;
+    for(numIndietro = 0, nodo = incontro; nodo != arrivo; nodo = b->precedente[nodo])
+        numIndietro++;
+    *numHop = numAvanti + numIndietro;
+    *percorso = (int *)malloc(*numHop * sizeof(int));
+    for(i = numAvanti - 1, nodo = incontro; i >= 0; i--, nodo = a->precedente[nodo])
+        (*percorso)[i] = nodo;
+    for(i = numAvanti, nodo = incontro; i < *numHop; i++) {
+        nodo = b->precedente[nodo];
+        (*percorso)[i] = nodo;
+    }
+    return (int)migliore;
+}
+
+/*
+ * Funzione che cerca il percorso con la gerarchia di contrazione se è
+ * attiva, altrimenti con cercaPercorso
+ *
+ * @param metodo nome del metodo usato, per la stampa
+ */
+int trovaPercorso(int partenza, int arrivo, int **percorso, int *numHop, int *estratti, const char **metodo) {
+    const struct gerarchia *ch = usaGerarchia ? aggiornaGerarchia() : NULL;
+
+    if(ch != NULL) {
+        *metodo = "gerarchia di contrazione";
+        return cercaPercorsoGerarchia(ch, partenza, arrivo, percorso, numHop, estratti);
+    }
+    *metodo = aggiornaScala() ? "A* bidirezionale" : "Dijkstra bidirezionale";
+    return cercaPercorso(partenza, arrivo, percorso, numHop, estratti);
+}
+
+/*
+ * Funzione che stampa un percorso tra due router con il costo
+ */
+void stampaPercorso(int partenza, int arrivo, int costo, const int *percorso, int numHop, int estratti, const char *metodo) {
+    int i;
+
+    if(costo == INT_MAX) {
+        printf("%s non è raggiungibile da %s\n", nomeNodo(arrivo), nomeNodo(partenza));
+        return;
+    }
+    printf("Percorso da %s a %s, costo %d:\n", nomeNodo(partenza), nomeNodo(arrivo), costo);
+    for(i = 0; i < numHop; i++)
+        printf("%s%s", nomeNodo(percorso[i]), i + 1 < numHop ? " -> " : "\n");
+    printf("Nodi estratti: %d su %d (%s)\n", estratti, aggiornaCSR()->numNodi, metodo);
+}
+
+/*
+ * Funzione del menu che chiede due router e stampa il percorso minimo tra loro
+ */
+void mostraPercorso() {
+    char *rPartenza, *rArrivo;
+    int idPartenza, idArrivo, costo, numHop, estratti, *percorso;
+    const char *metodo;
+
+    printf("Percorso tra due router:\n");
+    printf("Inserisci router di partenza: ");
+    rPartenza = leggiParola();
+    printf("Inserisci router di arrivo: ");
+    rArrivo = leggiParola();
+    if(rPartenza == NULL || rArrivo == NULL)
+        exit(EXIT_SUCCESS);
+    idPartenza = cercaNome(rPartenza);
+    idArrivo = cercaNome(rArrivo);
+    free(rPartenza);
+    free(rArrivo);
+
+    if(idPartenza < 0 || idArrivo < 0) {
+        printf("\nNodo non esistente!\n");
+        return;
+    }
+    costo = trovaPercorso(idPartenza, idArrivo, &percorso, &numHop, &estratti, &metodo);
+    printf("\n");
+    stampaPercorso(idPartenza, idArrivo, costo, percorso, numHop, estratti, metodo);
+    free(percorso);
+}
+
+/*
+ * Modalità per cercare un percorso senza menu:
+ * ./dijkstra --percorso R1 R2 [-s snapshot] [-g gerarchia] file...
+ * Con -g viene usata la gerarchia di contrazione, caricata dal file se è
+ * della stessa rete oppure costruita e salvata nel file.
+ *
+ * @param argc numero di argomenti dopo --percorso
+ * @param argv argomenti dopo --percorso
+ * @return codice di uscita del programma
+ */
+int modalitaPercorso(int argc, char **argv) {
+    int idPartenza, idArrivo, costo, numHop, estratti, *percorso, i;
+    const char *metodo;
+
+    for(i = 2; i < argc; i++) {
+        if(strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            usaGerarchia = true;
+            fileGerarchia = argv[++i];
+        }
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if(!caricaSnapshot(argv[++i])) {
+                fprintf(stderr, "Impossibile caricare lo snapshot %s\n", argv[i]);
+                return (EXIT_FAILURE);
+            }
+        }
+        else if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    idPartenza = cercaNome(argv[0]);
+    idArrivo = cercaNome(argv[1]);
+    if(idPartenza < 0 || idArrivo < 0) {
+        fprintf(stderr, "Nodo non esistente: %s\n", idPartenza < 0 ? argv[0] : argv[1]);
+        return (EXIT_FAILURE);
+    }
+    costo = trovaPercorso(idPartenza, idArrivo, &percorso, &numHop, &estratti, &metodo);
+    stampaPercorso(idPartenza, idArrivo, costo, percorso, numHop, estratti, metodo);
+    free(percorso);
+    return costo == INT_MAX ? (EXIT_FAILURE) : (EXIT_SUCCESS);
+}
+
+/*
+ * Funzione del menu che chiede un router e i limiti della ricerca e stampa
+ * la tabella parziale con le destinazioni trovate
+ */
+void mostraVicini() {
+    struct limitiRicerca limiti;
+    struct statoLimitato stato;
+    struct buffer testo = {NULL, 0, 0};
+    char *nome;
+    int start;
+
+    printf("Router vicini ad un nodo:\n");
+    printf("Inserisci nodo di partenza: ");
+    nome = leggiParola();
+    if(nome == NULL)
+        exit(EXIT_SUCCESS);
+    start = cercaNome(nome);
+    free(nome);
+    printf("Costo massimo (-1 per nessun limite): ");
+    if(scanf("%d", &limiti.costo) != 1)
+        exit(EXIT_SUCCESS);
+    printf("Numero massimo di hop (-1 per nessun limite): ");
+    if(scanf("%d", &limiti.hop) != 1)
+        exit(EXIT_SUCCESS);
+    printf("Numero di destinazioni più vicine (-1 per nessun limite): ");
+    if(scanf("%d", &limiti.numero) != 1)
+        exit(EXIT_SUCCESS);
+    if(start < 0 || !containsStart(start)) {
+        printf("\nNodo non esistente!\n");
+        return;
+    }
+
+    memset(&stato, 0, sizeof(stato));
+    calcolaTabellaLimitata(aggiornaCSR(), start, &limiti, &stato);
+    scriviRigheLimitate(&testo, &nomi, &stato);
+    printf("\nTabella di %s:\n", nomeNodo(start));
+    fwrite(testo.dati, 1, testo.usati, stdout);
+    printf("\nNextHop; destinazione; costo\n");
+    printf("Destinazioni: %d, router visitati: %d su %d\n", stato.numRisultati, stato.numVisitati, aggiornaCSR()->numNodi);
+    free(testo.dati);
+    liberaStatoLimitato(&stato);
+    printf("\n\nPremi invio per continuare...\n");
+    getchar();
+    getchar();
+}
+
+/*
+ * Modalità per la tabella parziale di un router senza menu:
+ * ./dijkstra --vicini R [-c costo] [-h hop] [-k numero] [-s snapshot] file...
+ * Scrive le destinazioni entro il costo -c, raggiungibili con al massimo -h
+ * hop e (con -k) solo le più vicine, nel formato delle tabelle. Su stderr
+ * scrive quanti router sono stati visitati.
+ *
+ * @param argc numero di argomenti dopo --vicini
+ * @param argv argomenti dopo --vicini
+ * @return codice di uscita del programma
+ */
+int modalitaVicini(int argc, char **argv) {
+    struct limitiRicerca limiti = {SENZA_LIMITE, SENZA_LIMITE, SENZA_LIMITE};
+    struct statoLimitato stato;
+    const struct csr *g;
+    struct buffer testo = {NULL, 0, 0};
+    double inizio;
+    int start, i;
+
+    for(i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+            limiti.costo = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-h") == 0 && i + 1 < argc)
+            limiti.hop = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+            limiti.numero = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if(!caricaSnapshot(argv[++i])) {
+                fprintf(stderr, "Impossibile caricare lo snapshot %s\n", argv[i]);
+                return (EXIT_FAILURE);
+            }
+        }
+        else if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    start = cercaNome(argv[0]);
+    if(start < 0) {
+        fprintf(stderr, "Nodo non esistente: %s\n", argv[0]);
+        return (EXIT_FAILURE);
+    }
+    g = aggiornaCSR();
+    memset(&stato, 0, sizeof(stato));
+    inizio = secondi();
+    calcolaTabellaLimitata(g, start, &limiti, &stato);
+    fprintf(stderr, "%d destinazioni, %d router visitati su %d, %.3f ms\n", stato.numRisultati,
+            stato.numVisitati, g->numNodi, (secondi() - inizio) * 1e3);
+    aggiungiStringa(&testo, "Tabella di ");
+    aggiungiStringa(&testo, argv[0]);
+    aggiungiStringa(&testo, ":\n");
+    scriviRigheLimitate(&testo, &nomi, &stato);
+    fwrite(testo.dati, 1, testo.usati, stdout);
+    free(testo.dati);
+    liberaStatoLimitato(&stato);
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * Funzione che aggiunge un arco alla lista di un nodo durante la costruzione
+ * della gerarchia, se l'arco verso vicino c'è già viene tenuto il costo minore
+ */
+void aggiungiArcoCH(struct archiCH *l, int vicino, int costo, int mezzo) {
+    int i;
+
+    for(i = 0; i < l->numero; i++) {
+        if(l->vicino[i] == vicino) {
+            if(costo < l->costo[i]) {
+                l->costo[i] = costo;
+                l->mezzo[i] = mezzo;
+            }
+            return;
+        }
+    }
+    if(l->numero == l->capacita) {
+        l->capacita = l->capacita == 0 ? 4 : 2 * l->capacita;
+        l->vicino = (int *)realloc(l->vicino, l->capacita * sizeof(int));
+        l->costo = (int *)realloc(l->costo, l->capacita * sizeof(int));
+        l->mezzo = (int *)realloc(l->mezzo, l->capacita * sizeof(int));
+    }
+    l->vicino[l->numero] = vicino;
+    l->costo[l->numero] = costo;
+    l->mezzo[l->numero] = mezzo;
+    l->numero++;
+}
+
+/*
+ * Funzione che toglie dalla lista di un nodo l'arco verso vicino
+ */
+void togliArcoCH(struct archiCH *l, int vicino) {
+    int i;
+
+    for(i = 0; i < l->numero; i++) {
+        if(l->vicino[i] == vicino) {
+            l->numero--;
+            l->vicino[i] = l->vicino[l->numero];
+            l->costo[i] = l->costo[l->numero];
+            l->mezzo[i] = l->mezzo[l->numero];
+            return;
+        }
+    }
+}
+
+/*
+ * Ricerca di un percorso testimone: Dijkstra da u sui nodi non ancora
+ * contratti, senza passare da v, fermato oltre limiteCosto o dopo
+ * limiteNodi nodi estratti o quando tutti i numObiettivi nodi segnati in
+ * obiettivo hanno il costo definitivo. Le distanze trovate sono percorsi
+ * veri, quindi se una è minore della scorciatoia la scorciatoia non serve.
+ */
+void ricercaTestimone(struct costruzioneCH *c, int u, int v, int limiteCosto, int limiteNodi, int numObiettivi) {
+    struct statoTabella *s = &c->testimone;
+    int nodo, costo, i, estratti = 0;
+
+    azzeraRicerca(s, c->numNodi);
+    raggiungiNodo(s, u, 0, u, 0);
+    while(s->coda.dimensione > 0 && s->coda.valori[0] <= limiteCosto && estratti++ < limiteNodi) {
+        nodo = estraiMinimo(&s->coda);
+        if(c->obiettivo[nodo] == c->turno && --numObiettivi == 0)
+            break;
+        for(i = 0; i < c->uscenti[nodo].numero; i++) {
+            if(c->uscenti[nodo].vicino[i] == v)
+                continue;
+            costo = s->distanza[nodo] + c->uscenti[nodo].costo[i];
+            if(costo < s->distanza[c->uscenti[nodo].vicino[i]])
+                raggiungiNodo(s, c->uscenti[nodo].vicino[i], costo, nodo, costo);
+        }
+    }
+}
+
+/*
+ * Funzione che contrae il nodo v: per ogni coppia di vicini u -> v -> w
+ * senza un percorso testimone più corto aggiunge la scorciatoia u -> w.
+ * Con simula true le scorciatoie vengono solo contate, serve per decidere
+ * l'ordine di contrazione.
+ *
+ * @return numero di scorciatoie necessarie
+ */
+int contraiNodo(struct costruzioneCH *c, int v, bool simula) {
+    struct archiCH *entranti = &c->entranti[v], *uscenti = &c->uscenti[v];
+    int i, j, u, w, costo, massimo = 0, scorciatoie = 0, numObiettivi;
+
+    for(j = 0; j < uscenti->numero; j++)
+        if(uscenti->costo[j] > massimo)
+            massimo = uscenti->costo[j];
+    for(i = 0; i < entranti->numero; i++) {
+        u = entranti->vicino[i];
+        /* La ricerca deve trovare gli altri vicini uscenti di v */
+        c->turno++;
+        numObiettivi = 0;
+        for(j = 0; j < uscenti->numero; j++) {
+            if(uscenti->vicino[j] != u) {
+                c->obiettivo[uscenti->vicino[j]] = c->turno;
+                numObiettivi++;
+            }
+        }
+        if(numObiettivi == 0)
+            continue;
+        ricercaTestimone(c, u, v, entranti->costo[i] + massimo, simula ? LIMITE_TESTIMONE_SIMULA : LIMITE_TESTIMONE,
+                         numObiettivi);
+        for(j = 0; j < uscenti->numero; j++) {
+            w = uscenti->vicino[j];
+            costo = entranti->costo[i] + uscenti->costo[j];
+            if(w == u || c->testimone.distanza[w] <= costo)
+                continue;
+            scorciatoie++;
+            if(!simula) {
+                aggiungiArcoCH(&c->uscenti[u], w, costo, v);
+                aggiungiArcoCH(&c->entranti[w], u, costo, v);
+            }
+        }
+    }
+    return scorciatoie;
+}
+
+/*
+ * Priorità di contrazione di un nodo, si contraggono prima i nodi che
+ * aggiungono meno scorciatoie di quanti archi tolgono, quelli con pochi
+ * vicini già contratti e quelli in basso nella gerarchia
+ */
+int prioritaCH(struct costruzioneCH *c, int v) {
+    return contraiNodo(c, v, true) - c->entranti[v].numero - c->uscenti[v].numero
+           + c->viciniContratti[v] + c->livello[v];
+}
+
+/*
+ * Funzione che cambia la priorità di un nodo già presente nel heap, in
+ * tutte e due le direzioni
+ */
+void cambiaPriorita(struct heap *h, int nodo, int valore) {
+    h->valori[h->posizione[nodo]] = valore;
+    heapSali(h, h->posizione[nodo]);
+    heapScendi(h, h->posizione[nodo]);
+}
+
+/*
+ * Funzione che copia le liste degli archi di tutti i nodi in formato CSR
+ */
+void compattaArchiCH(struct archiCH *liste, int numNodi, int **offset, int **vicino, int **costo, int **mezzo) {
+    int i, j, k = 0;
+
+    *offset = (int *)malloc((numNodi + 1) * sizeof(int));
+    (*offset)[0] = 0;
+    for(i = 0; i < numNodi; i++)
+        (*offset)[i + 1] = (*offset)[i] + liste[i].numero;
+    *vicino = (int *)malloc(((*offset)[numNodi] + 1) * sizeof(int));
+    *costo = (int *)malloc(((*offset)[numNodi] + 1) * sizeof(int));
+    *mezzo = (int *)malloc(((*offset)[numNodi] + 1) * sizeof(int));
+    for(i = 0; i < numNodi; i++) {
+        for(j = 0; j < liste[i].numero; j++, k++) {
+            (*vicino)[k] = liste[i].vicino[j];
+            (*costo)[k] = liste[i].costo[j];
+            (*mezzo)[k] = liste[i].mezzo[j];
+        }
+        free(liste[i].vicino);
+        free(liste[i].costo);
+        free(liste[i].mezzo);
+    }
+    free(liste);
+}
+
+/*
+ * Funzione che libera la memoria della gerarchia
+ */
+void liberaGerarchia(struct gerarchia *ch) {
+    free(ch->rango);
+    free(ch->offsetSu);
+    free(ch->arrivoSu);
+    free(ch->costoSu);
+    free(ch->mezzoSu);
+    free(ch->offsetGiu);
+    free(ch->partenzaGiu);
+    free(ch->costoGiu);
+    free(ch->mezzoGiu);
+    free(ch->arcoAvanti);
+    free(ch->arcoIndietro);
+    memset(ch, 0, sizeof(*ch));
+}
+
+/*
+ * Funzione che costruisce la gerarchia di contrazione della rete: i nodi
+ * vengono contratti uno alla volta nell'ordine dato da prioritaCH e ogni
+ * nodo tiene solo gli archi verso i nodi contratti dopo di lui (rango
+ * maggiore), scorciatoie comprese.
+ */
+void costruisciGerarchia() {
+    const struct csr *g = aggiornaCSRCompatto();
+    struct costruzioneCH c;
+    struct heap ordine;
+    int i, j, v, u, priorita, rango = 0;
+
+    liberaGerarchia(&gerarchia);
+    memset(&c, 0, sizeof(c));
+    c.numNodi = g->numNodi;
+    c.uscenti = (struct archiCH *)calloc(g->numNodi + 1, sizeof(struct archiCH));
+    c.entranti = (struct archiCH *)calloc(g->numNodi + 1, sizeof(struct archiCH));
+    c.viciniContratti = (int *)calloc(g->numNodi + 1, sizeof(int));
+    c.livello = (int *)calloc(g->numNodi + 1, sizeof(int));
+    c.obiettivo = (int *)calloc(g->numNodi + 1, sizeof(int));
+    for(i = 0; i < g->numNodi; i++) {
+        for(j = g->offset[i]; j < g->offset[i + 1]; j++) {
+            if(g->arrivo[j] == i)
+                continue;
+            aggiungiArcoCH(&c.uscenti[i], g->arrivo[j], g->costo[j], -1);
+            aggiungiArcoCH(&c.entranti[g->arrivo[j]], i, g->costo[j], -1);
+        }
+    }
+
+    gerarchia.rango = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    creaHeap(&ordine, g->numNodi, NULL);
+    for(i = 0; i < g->numNodi; i++)
+        inserisciHeap(&ordine, i, prioritaCH(&c, i));
+    while(ordine.dimensione > 0) {
+        /* Priorità aggiornate in modo pigro: se il nodo in cima è peggiorato
+           viene rimesso nel heap */
+        v = ordine.nodi[0];
+        priorita = prioritaCH(&c, v);
+        if(ordine.dimensione > 1 && priorita > ordine.valori[0]) {
+            cambiaPriorita(&ordine, v, priorita);
+            if(ordine.nodi[0] != v)
+                continue;
+        }
+        estraiMinimo(&ordine);
+        contraiNodo(&c, v, false);
+        gerarchia.rango[v] = rango++;
+        /* v esce dalle liste dei vicini, le sue restano com'erano: sono gli
+           archi verso nodi di rango maggiore */
+        for(i = 0; i < c.uscenti[v].numero; i++) {
+            u = c.uscenti[v].vicino[i];
+            togliArcoCH(&c.entranti[u], v);
+            c.viciniContratti[u]++;
+            if(c.livello[u] < c.livello[v] + 1)
+                c.livello[u] = c.livello[v] + 1;
+        }
+        for(i = 0; i < c.entranti[v].numero; i++) {
+            u = c.entranti[v].vicino[i];
+            togliArcoCH(&c.uscenti[u], v);
+            c.viciniContratti[u]++;
+            if(c.livello[u] < c.livello[v] + 1)
+                c.livello[u] = c.livello[v] + 1;
+        }
+        /* Le priorità dei vicini cambiano, quelle dei vicini con molti archi
+           costano troppo da ricalcolare ogni volta e restano pigre */
+        for(i = 0; i < c.uscenti[v].numero; i++) {
+            u = c.uscenti[v].vicino[i];
+            if(ordine.posizione[u] != -1 && c.uscenti[u].numero * c.entranti[u].numero <= LIMITE_AGGIORNA_VICINI)
+                cambiaPriorita(&ordine, u, prioritaCH(&c, u));
+        }
+        for(i = 0; i < c.entranti[v].numero; i++) {
+            u = c.entranti[v].vicino[i];
+            if(ordine.posizione[u] != -1 && c.uscenti[u].numero * c.entranti[u].numero <= LIMITE_AGGIORNA_VICINI)
+                cambiaPriorita(&ordine, u, prioritaCH(&c, u));
+        }
+    }
+    liberaHeap(&ordine);
+    liberaStato(&c.testimone);
+    free(c.viciniContratti);
+    free(c.livello);
+    free(c.obiettivo);
+
+    gerarchia.numNodi = g->numNodi;
+    compattaArchiCH(c.uscenti, g->numNodi, &gerarchia.offsetSu, &gerarchia.arrivoSu, &gerarchia.costoSu, &gerarchia.mezzoSu);
+    compattaArchiCH(c.entranti, g->numNodi, &gerarchia.offsetGiu, &gerarchia.partenzaGiu, &gerarchia.costoGiu, &gerarchia.mezzoGiu);
+    gerarchia.arcoAvanti = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    gerarchia.arcoIndietro = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    gerarchia.impronta = improntaTopologia();
+    gerarchia.generazione = generazioneTopologia;
+    gerarchia.valida = true;
+}
+
+/*
+ * Impronta della topologia (FNV-1a su CSR e nomi), salvata con la gerarchia
+ * per riconoscere un file costruito per un'altra rete
+ */
+unsigned long long improntaTopologia() {
+    const struct csr *g = aggiornaCSRCompatto();
+    unsigned long long h = 14695981039346656037ull;
+    size_t i;
+
+    for(i = 0; i <= (size_t)g->numNodi; i++)
+        h = (h ^ (unsigned int)g->offset[i]) * 1099511628211ull;
+    for(i = 0; i < (size_t)g->numArchi; i++) {
+        h = (h ^ (unsigned int)g->arrivo[i]) * 1099511628211ull;
+        h = (h ^ (unsigned int)g->costo[i]) * 1099511628211ull;
+    }
+    for(i = 0; i < nomi.usati; i++)
+        h = (h ^ (unsigned char)nomi.caratteri[i]) * 1099511628211ull;
+    return h;
+}
+
+/*
+ * Funzione che prepara le sezioni del file della gerarchia: puntatore ai
+ * dati e numero di interi di ognuna
+ */
+void sezioniGerarchia(struct gerarchia *ch, int ***array, size_t *numeri) {
+    int **campi[9] = {&ch->rango, &ch->offsetSu, &ch->arrivoSu, &ch->costoSu, &ch->mezzoSu,
+                      &ch->offsetGiu, &ch->partenzaGiu, &ch->costoGiu, &ch->mezzoGiu};
+    int i;
+
+    for(i = 0; i < 9; i++)
+        array[i] = campi[i];
+    numeri[0] = ch->numNodi;
+    numeri[1] = numeri[5] = ch->numNodi + 1;
+    numeri[2] = numeri[3] = numeri[4] = ch->offsetSu != NULL ? ch->offsetSu[ch->numNodi] : 0;
+    numeri[6] = numeri[7] = numeri[8] = ch->offsetGiu != NULL ? ch->offsetGiu[ch->numNodi] : 0;
+}
+
+/*
+ * Funzione che salva la gerarchia su file, con lo stesso schema dello
+ * snapshot: intestazione, sezioni allineate a 8 byte e checksum
+ *
+ * @param nomeFile file da scrivere
+ * @return false se il file non può essere scritto
+ */
+bool salvaGerarchia(const char *nomeFile) {
+    struct intestazioneGerarchia in;
+    int **array[9];
+    size_t numeri[9], totale = sizeof(in);
+    char *dati, *p;
+    FILE *fl;
+    int i;
+
+    sezioniGerarchia(&gerarchia, array, numeri);
+    for(i = 0; i < 9; i++)
+        totale += allinea8(numeri[i] * sizeof(int));
+    dati = (char *)calloc(1, totale);
+    p = dati + sizeof(in);
+    for(i = 0; i < 9; i++) {
+        memcpy(p, *array[i], numeri[i] * sizeof(int));
+        p += allinea8(numeri[i] * sizeof(int));
+    }
+    memset(&in, 0, sizeof(in));
+    memcpy(in.magic, MAGIC_GERARCHIA, 8);
+    in.versione = VERSIONE_GERARCHIA;
+    in.ordineByte = ORDINE_BYTE;
+    in.impronta = gerarchia.impronta;
+    in.numNodi = gerarchia.numNodi;
+    in.numSu = numeri[2];
+    in.numGiu = numeri[6];
+    in.checksum = checksumSnapshot(dati + sizeof(in), totale - sizeof(in));
+    memcpy(dati, &in, sizeof(in));
+
+    fl = fopen(nomeFile, "wb");
+    if(fl == NULL) {
+        free(dati);
+        return false;
+    }
+    if(fwrite(dati, 1, totale, fl) != totale) {
+        fclose(fl);
+        free(dati);
+        return false;
+    }
+    free(dati);
+    return fclose(fl) == 0;
+}
+
+/*
+ * Funzione che carica una gerarchia salvata con salvaGerarchia, solo se è
+ * stata costruita per la rete caricata adesso
+ *
+ * @param nomeFile file da leggere
+ * @return false se il file non esiste, non è valido o è di un'altra rete
+ */
+bool caricaGerarchia(const char *nomeFile) {
+    struct intestazioneGerarchia in;
+    struct gerarchia ch;
+    int **array[9];
+    size_t numeri[9], totale = 0;
+    char *dati, *p;
+    FILE *fl = fopen(nomeFile, "rb");
+    int i;
+
+    if(fl == NULL)
+        return false;
+    if(fread(&in, sizeof(in), 1, fl) != 1 || memcmp(in.magic, MAGIC_GERARCHIA, 8) != 0
+       || in.versione != VERSIONE_GERARCHIA || in.ordineByte != ORDINE_BYTE
+       || in.impronta != improntaTopologia() || in.numNodi != (unsigned long long)aggiornaCSR()->numNodi) {
+        fclose(fl);
+        return false;
+    }
+    /* Le dimensioni delle sezioni vengono dall'intestazione, sono controllate
+       dal checksum insieme ai dati */
+    memset(&ch, 0, sizeof(ch));
+    ch.numNodi = (int)in.numNodi;
+    sezioniGerarchia(&ch, array, numeri);
+    numeri[2] = numeri[3] = numeri[4] = in.numSu;
+    numeri[6] = numeri[7] = numeri[8] = in.numGiu;
+    for(i = 0; i < 9; i++)
+        totale += allinea8(numeri[i] * sizeof(int));
+    dati = (char *)malloc(totale + 1);
+    if(fread(dati, 1, totale, fl) != totale || checksumSnapshot(dati, totale) != in.checksum) {
+        free(dati);
+        fclose(fl);
+        return false;
+    }
+    fclose(fl);
+    for(i = 0, p = dati; i < 9; i++) {
+        *array[i] = (int *)malloc((numeri[i] + 1) * sizeof(int));
+        memcpy(*array[i], p, numeri[i] * sizeof(int));
+        p += allinea8(numeri[i] * sizeof(int));
+    }
+    free(dati);
+    if(ch.offsetSu[ch.numNodi] != (int)in.numSu || ch.offsetGiu[ch.numNodi] != (int)in.numGiu) {
+        liberaGerarchia(&ch);
+        return false;
+    }
+    ch.arcoAvanti = (int *)malloc((ch.numNodi + 1) * sizeof(int));
+    ch.arcoIndietro = (int *)malloc((ch.numNodi + 1) * sizeof(int));
+    ch.impronta = in.impronta;
+    ch.generazione = generazioneTopologia;
+    ch.valida = true;
+    liberaGerarchia(&gerarchia);
+    gerarchia = ch;
+    return true;
+}
+
+/*
+ * Funzione che restituisce la gerarchia aggiornata: se la rete è cambiata
+ * dall'ultima costruzione viene caricata dal file (se è della rete attuale)
+ * oppure ricostruita e salvata
+ */
+const struct gerarchia *aggiornaGerarchia() {
+    double inizio;
+
+    if(gerarchia.valida && gerarchia.generazione == generazioneTopologia)
+        return &gerarchia;
+    aggiornaCSR();
+    if(fileGerarchia != NULL && caricaGerarchia(fileGerarchia))
+        return &gerarchia;
+    inizio = secondi();
+    costruisciGerarchia();
+    fprintf(stderr, "Gerarchia costruita in %.3f s, %d archi verso l'alto (%d originali)\n",
+            secondi() - inizio, gerarchia.offsetSu[gerarchia.numNodi] + gerarchia.offsetGiu[gerarchia.numNodi],
+            aggiornaCSR()->numArchi);
+    if(fileGerarchia != NULL && !salvaGerarchia(fileGerarchia))
+        fprintf(stderr, "Impossibile scrivere %s\n", fileGerarchia);
+    return &gerarchia;
+}
+
+/*
+ * Funzione che aggiunge un nodo in fondo a una lista di nodi
+ */
+void aggiungiNodoLista(struct listaNodi *l, int nodo) {
+    if(l->numero == l->capacita) {
+        l->capacita = l->capacita == 0 ? 16 : 2 * l->capacita;
+        l->nodi = (int *)realloc(l->nodi, l->capacita * sizeof(int));
+    }
+    l->nodi[l->numero++] = nodo;
+}
+
+/*
+ * Funzione che aggiunge in fondo al percorso i nodi di un arco della
+ * gerarchia, espandendo le scorciatoie nei due archi da cui sono nate
+ * (u -> mezzo e mezzo -> w, mezzo ha rango minore di u e w). Il nodo u
+ * è già nel percorso.
+ */
+void espandiArco(const struct gerarchia *ch, int u, int w, int mezzo, struct listaNodi *percorso) {
+    int i;
+
+    if(mezzo < 0) {
+        aggiungiNodoLista(percorso, w);
+        return;
+    }
+    for(i = ch->offsetGiu[mezzo]; ch->partenzaGiu[i] != u; i++);
+    espandiArco(ch, u, mezzo, ch->mezzoGiu[i], percorso);
+    for(i = ch->offsetSu[mezzo]; ch->arrivoSu[i] != w; i++);
+    espandiArco(ch, mezzo, w, ch->mezzoSu[i], percorso);
+}
+
+/*
+ * Stall-on-demand: un nodo estratto da una ricerca della gerarchia non va
+ * espanso se un nodo di rango maggiore già raggiunto ha un arco verso di
+ * lui più corto, il suo costo non è quello minimo e da lui non passa il
+ * percorso minimo
+ *
+ * @param s stato della ricerca
+ * @param nodo nodo estratto
+ * @param offset, vicino, costo archi dai nodi di rango maggiore nella
+ *        direzione opposta a quella della ricerca
+ */
+bool nodoBloccato(const struct statoTabella *s, int nodo, const int *offset, const int *vicino, const int *costo) {
+    int i;
+
+    for(i = offset[nodo]; i < offset[nodo + 1]; i++)
+        if(s->distanza[vicino[i]] != INT_MAX && (long long)s->distanza[vicino[i]] + costo[i] < s->distanza[nodo])
+            return true;
+    return false;
+}
+
+/*
+ * Funzione che cerca il percorso minimo con la gerarchia di contrazione:
+ * due ricerche di Dijkstra che salgono solo verso nodi di rango maggiore,
+ * una da partenza e una da arrivo, che si incontrano nel nodo più alto del
+ * percorso. Ogni ricerca si ferma quando il suo minimo in coda supera il
+ * miglior percorso trovato.
+ *
+ * @param ch gerarchia aggiornata
+ * @param partenza ID del router di partenza
+ * @param arrivo ID del router di arrivo
+ * @param percorso array con i router del percorso, da liberare con free
+ * @param numHop numero di router nel percorso (partenza e arrivo compresi)
+ * @param estratti numero di nodi estratti dalle code
+ * @return costo del percorso, INT_MAX se arrivo non è raggiungibile
+ */
+int cercaPercorsoGerarchia(const struct gerarchia *ch, int partenza, int arrivo, int **percorso, int *numHop, int *estratti) {
+    struct statoTabella *a = &ricercaAvanti, *b = &ricercaIndietro;
+    struct listaNodi lista = {NULL, 0, 0}, indietro = {NULL, 0, 0};
+    long long migliore = INT_MAX;
+    int nodo, vicino, costo, incontro = -1, i;
+
+    *estratti = 0;
+    azzeraRicerca(a, ch->numNodi);
+    azzeraRicerca(b, ch->numNodi);
+    raggiungiNodo(a, partenza, 0, partenza, 0);
+    raggiungiNodo(b, arrivo, 0, arrivo, 0);
+    if(partenza == arrivo) {
+        migliore = 0;
+        incontro = partenza;
+    }
+    for(;;) {
+        if(a->coda.dimensione > 0 && a->coda.valori[0] < migliore) {
+            nodo = estraiMinimo(&a->coda);
+            (*estratti)++;
+            if(nodoBloccato(a, nodo, ch->offsetGiu, ch->partenzaGiu, ch->costoGiu))
+                continue;
+            for(i = ch->offsetSu[nodo]; i < ch->offsetSu[nodo + 1]; i++) {
+                vicino = ch->arrivoSu[i];
+                costo = a->distanza[nodo] + ch->costoSu[i];
+                if(costo >= a->distanza[vicino])
+                    continue;
+                raggiungiNodo(a, vicino, costo, nodo, costo);
+                ch->arcoAvanti[vicino] = i;
+                if(b->distanza[vicino] != INT_MAX && (long long)costo + b->distanza[vicino] < migliore) {
+                    migliore = (long long)costo + b->distanza[vicino];
+                    incontro = vicino;
+                }
+            }
+        }
+        else if(b->coda.dimensione > 0 && b->coda.valori[0] < migliore) {
+            nodo = estraiMinimo(&b->coda);
+            (*estratti)++;
+            if(nodoBloccato(b, nodo, ch->offsetSu, ch->arrivoSu, ch->costoSu))
+                continue;
+            for(i = ch->offsetGiu[nodo]; i < ch->offsetGiu[nodo + 1]; i++) {
+                vicino = ch->partenzaGiu[i];
+                costo = b->distanza[nodo] + ch->costoGiu[i];
+                if(costo >= b->distanza[vicino])
+                    continue;
+                raggiungiNodo(b, vicino, costo, nodo, costo);
+                ch->arcoIndietro[vicino] = i;
+                if(a->distanza[vicino] != INT_MAX && (long long)costo + a->distanza[vicino] < migliore) {
+                    migliore = (long long)costo + a->distanza[vicino];
+                    incontro = vicino;
+                }
+            }
+        }
+        else
+            break;
+    }
+
+    *numHop = 0;
+    *percorso = NULL;
+    if(incontro < 0)
+        return INT_MAX;
+    /* Salita da partenza a incontro: gli archi vengono presi al contrario
+       da incontro e poi espansi nell'ordine giusto */
+    for(nodo = incontro; nodo != partenza; nodo = a->precedente[nodo])
+        aggiungiNodoLista(&indietro, nodo);
+    aggiungiNodoLista(&lista, partenza);
+    for(i = indietro.numero - 1, nodo = partenza; i >= 0; nodo = indietro.nodi[i--])
+        espandiArco(ch, nodo, indietro.nodi[i], ch->mezzoSu[ch->arcoAvanti[indietro.nodi[i]]], &lista);
+    free(indietro.nodi);
+    /* Discesa da incontro ad arrivo */
+    for(nodo = incontro; nodo != arrivo; nodo = b->precedente[nodo])
+        espandiArco(ch, nodo, b->precedente[nodo], ch->mezzoGiu[ch->arcoIndietro[nodo]], &lista);
+    *percorso = lista.nodi;
+    *numHop = lista.numero;
+    return (int)migliore;
+}
+
+/*
+ * Benchmark dei percorsi tra due router:
+ * ./dijkstra --bench-percorsi [-n ricerche] [-g gerarchia] file...
+ * Confronta su coppie di router scelte a caso (seme fisso) la tabella
+ * completa, Dijkstra (o A*) bidirezionale e la gerarchia di contrazione,
+ * controllando che i costi siano uguali.
+ *
+ * @param argc numero di argomenti dopo --bench-percorsi
+ * @param argv argomenti dopo --bench-percorsi
+ * @return codice di uscita del programma
+ */
+int benchPercorsi(int argc, char **argv) {
+    const struct csr *g;
+    const struct gerarchia *ch;
+    struct statoTabella stato;
+    unsigned long long seme = 1;
+    double inizio, tempi[3] = {0, 0, 0};
+    long long estrattiTotali[3] = {0, 0, 0};
+    int ricerche = 1000, i, q, partenza, arrivo, costo, numHop, estratti, *percorso, errori = 0;
+
+    usaGerarchia = true;
+    for(i = 0; i < argc; i++) {
+        if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            ricerche = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+            fileGerarchia = argv[++i];
+        else if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    g = aggiornaCSR();
+    if(g->numNodi == 0)
+        return (EXIT_FAILURE);
+    ch = aggiornaGerarchia();
+    creaStato(&stato, g->numNodi);
+    for(q = 0; q < ricerche; q++) {
+        partenza = casualeTra(&seme, 0, g->numNodi - 1);
+        arrivo = casualeTra(&seme, 0, g->numNodi - 1);
+
+        inizio = secondi();
+        calcolaTabella(g, partenza, &stato);
+        tempi[0] += secondi() - inizio;
+        estrattiTotali[0] += stato.numRaggiunti;
+
+        inizio = secondi();
+        costo = cercaPercorso(partenza, arrivo, &percorso, &numHop, &estratti);
+        tempi[1] += secondi() - inizio;
+        estrattiTotali[1] += estratti;
+        free(percorso);
+        if(costo != stato.distanza[arrivo])
+            errori++;
+
+        inizio = secondi();
+        costo = cercaPercorsoGerarchia(ch, partenza, arrivo, &percorso, &numHop, &estratti);
+        tempi[2] += secondi() - inizio;
+        estrattiTotali[2] += estratti;
+        free(percorso);
+        if(costo != stato.distanza[arrivo])
+            errori++;
+    }
+    liberaStato(&stato);
+    printf("%d ricerche su %d nodi, %d archi\n", ricerche, g->numNodi, g->numArchi);
+    printf("  tabella completa:          %9.1f us, %lld nodi estratti\n", tempi[0] * 1e6 / ricerche, estrattiTotali[0] / ricerche);
+    printf("  %-26s %9.1f us, %lld nodi estratti\n", aggiornaScala() ? "A* bidirezionale:" : "Dijkstra bidirezionale:",
+           tempi[1] * 1e6 / ricerche, estrattiTotali[1] / ricerche);
+    printf("  gerarchia di contrazione:  %9.1f us, %lld nodi estratti (tempo con l'espansione del percorso)\n",
+           tempi[2] * 1e6 / ricerche, estrattiTotali[2] / ricerche);
+    if(errori > 0)
+        printf("  %d costi diversi dalla tabella completa!\n", errori);
+    return errori == 0 ? (EXIT_SUCCESS) : (EXIT_FAILURE);
+}
+
+/*
+ * Funzione che converte il nome di una rinumerazione nel suo tipo
+ *
+ * @param nome "nessuno", "bfs", "rcm" o "grado"
+ * @return tipo di rinumerazione, -1 se il nome non è valido
+ */
+int tipoOrdine(const char *nome) {
+    if(strcmp(nome, "nessuno") == 0)
+        return ORDINE_NESSUNO;
+    if(strcmp(nome, "bfs") == 0)
+        return ORDINE_BFS;
+    if(strcmp(nome, "rcm") == 0)
+        return ORDINE_RCM;
+    if(strcmp(nome, "grado") == 0)
+        return ORDINE_GRADO;
+    return -1;
+}
+
+/*
+ * Funzione che restituisce il nome di una rinumerazione, per le stampe
+ */
+const char *nomeOrdine(int tipo) {
+    switch(tipo) {
+        case ORDINE_BFS: return "bfs";
+        case ORDINE_RCM: return "rcm";
+        case ORDINE_GRADO: return "grado";
+    }
+    return "nessuno";
+}
+
+/*
+ * Funzione di confronto per qsort tra chiavi (valore << 32) | nodo
+ */
+int confrontaChiavi(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long *)a, y = *(const unsigned long long *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * Funzione che visita in ampiezza i nodi raggiungibili da partenza non
+ * ancora visitati e li aggiunge in fondo all'ordine. La coda della visita è
+ * l'ordine stesso.
+ *
+ * @param g grafo in formato CSR
+ * @param partenza primo nodo della visita, non ancora visitato
+ * @param perGrado true per aggiungere i vicini di ogni nodo in ordine di grado crescente (Cuthill-McKee)
+ * @param visitato nodi già nell'ordine
+ * @param ordine ordine dei nodi, ordine[k] = ID del nodo in posizione k
+ * @param numOrdinati nodi già nell'ordine, viene aggiornato
+ * @param chiavi spazio per numNodi chiavi, usato con perGrado
+ */
+void visitaOrdine(const struct csr *g, int partenza, bool perGrado, bool *visitato, int *ordine, int *numOrdinati, unsigned long long *chiavi) {
+    int testa = *numOrdinati, nodo, vicino, i, numVicini;
+
+    visitato[partenza] = true;
+    ordine[(*numOrdinati)++] = partenza;
+    while(testa < *numOrdinati) {
+        nodo = ordine[testa++];
+        numVicini = 0;
+        for(i = g->offset[nodo]; i < g->offset[nodo + 1]; i++) {
+            vicino = g->arrivo[i];
+            if(visitato[vicino])
+                continue;
+            visitato[vicino] = true;
+            if(perGrado)
+                chiavi[numVicini++] = (unsigned long long)(g->offset[vicino + 1] - g->offset[vicino]) << 32 | (unsigned int)vicino;
+            else
+                ordine[(*numOrdinati)++] = vicino;
+        }
+        if(perGrado) {
+            qsort(chiavi, numVicini, sizeof(unsigned long long), confrontaChiavi);
+            for(i = 0; i < numVicini; i++)
+                ordine[(*numOrdinati)++] = (int)(unsigned int)chiavi[i];
+        }
+    }
+}
+
+/*
+ * Funzione che calcola una rinumerazione dei nodi. Le visite seguono gli
+ * archi uscenti, i link dei file sono nei due versi.
+ *
+ * @param g grafo in formato CSR
+ * @param tipo ORDINE_NESSUNO, ORDINE_BFS, ORDINE_RCM o ORDINE_GRADO
+ * @param ordine numNodi posizioni, ordine[k] = ID attuale del nodo che diventa k
+ */
+void calcolaOrdine(const struct csr *g, int tipo, int *ordine) {
+    unsigned long long *chiavi = (unsigned long long *)malloc((g->numNodi + 1) * sizeof(unsigned long long));
+    int *inizi = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    bool *visitato = (bool *)calloc(g->numNodi + 1, sizeof(bool));
+    int numOrdinati = 0, grado, i, temp;
+
+    for(i = 0; i < g->numNodi; i++) {
+        grado = g->offset[i + 1] - g->offset[i];
+        /* Con ORDINE_GRADO i nodi vanno dal grado maggiore, con RCM ogni
+           componente parte da un nodo di grado minimo */
+        chiavi[i] = (unsigned long long)(tipo == ORDINE_GRADO ? INT_MAX - grado : grado) << 32 | (unsigned int)i;
+    }
+    if(tipo == ORDINE_GRADO || tipo == ORDINE_RCM)
+        qsort(chiavi, g->numNodi, sizeof(unsigned long long), confrontaChiavi);
+    for(i = 0; i < g->numNodi; i++)
+        inizi[i] = (int)(unsigned int)chiavi[i];
+
+    if(tipo == ORDINE_BFS || tipo == ORDINE_RCM) {
+        /* Una visita per ogni componente, dal primo nodo non visitato */
+        for(i = 0; i < g->numNodi; i++)
+            if(!visitato[inizi[i]])
+                visitaOrdine(g, inizi[i], tipo == ORDINE_RCM, visitato, ordine, &numOrdinati, chiavi);
+    }
+    else {
+        memcpy(ordine, inizi, g->numNodi * sizeof(int));
+    }
+    if(tipo == ORDINE_RCM) {
+        for(i = 0; i < g->numNodi / 2; i++) {
+            temp = ordine[i];
+            ordine[i] = ordine[g->numNodi - 1 - i];
+            ordine[g->numNodi - 1 - i] = temp;
+        }
+    }
+    free(chiavi);
+    free(inizi);
+    free(visitato);
+}
+
+/*
+ * Funzione di confronto per qsort tra archi, per partenza e poi arrivo
+ */
+int confrontaArchi(const void *a, const void *b) {
+    const struct arco *x = (const struct arco *)a, *y = (const struct arco *)b;
+
+    if(x->partenza != y->partenza)
+        return x->partenza < y->partenza ? -1 : 1;
+    if(x->arrivo != y->arrivo)
+        return x->arrivo < y->arrivo ? -1 : 1;
+    return x->costo < y->costo ? -1 : x->costo > y->costo;
+}
+
+/*
+ * Funzione che cambia gli ID di tutti i router: il router in posizione k
+ * dell'ordine diventa k. Vengono aggiornati nomi, archi, insieme degli
+ * archi e coordinate; la lista degli archi viene compattata e ordinata per
+ * partenza e arrivo, così anche gli archi di ogni nodo nel CSR sono in
+ * ordine di ID. La cache delle tabelle viene svuotata.
+ *
+ * @param ordine ordine[k] = ID attuale del router che diventa k, per tutti i router
+ */
+void rinumeraNodi(const int *ordine) {
+    int *nuovo = (int *)malloc((nomi.numNomi + 1) * sizeof(int));
+    size_t *inizio = (size_t *)malloc(nomi.capacitaNomi * sizeof(size_t) + 1);
+    double *x, *y;
+    bool *presente;
+    int capacita, i;
+
+    staccaSnapshot();
+    for(i = 0; i < nomi.numNomi; i++)
+        nuovo[ordine[i]] = i;
+
+    /* Nomi: cambia solo a quale ID punta ogni nome */
+    for(i = 0; i < nomi.numNomi; i++)
+        inizio[nuovo[i]] = nomi.inizio[i];
+    free(nomi.inizio);
+    nomi.inizio = inizio;
+    for(i = 0; i < nomi.capacitaSlot; i++)
+        if(nomi.slot[i] != -1)
+            nomi.slot[i] = nuovo[nomi.slot[i]];
+
+    /* Archi e insieme degli archi, che dipende dagli ID */
+    compattaArchi();
+    for(i = 0; i < rete.numSlot; i++) {
+        rete.archi[i].partenza = nuovo[rete.archi[i].partenza];
+        rete.archi[i].arrivo = nuovo[rete.archi[i].arrivo];
+    }
+    qsort(rete.archi, rete.numSlot, sizeof(struct arco), confrontaArchi);
+    ricostruisciInsiemeArchi();
+
+    if(posizioni.capacita > 0) {
+        /* Un router con coordinate può ricevere un ID oltre la capacità attuale */
+        capacita = posizioni.capacita;
+        while(capacita < nomi.numNomi)
+            capacita *= 2;
+        x = (double *)malloc(capacita * sizeof(double));
+        y = (double *)malloc(capacita * sizeof(double));
+        presente = (bool *)calloc(capacita, sizeof(bool));
+        for(i = 0; i < nomi.numNomi && i < posizioni.capacita; i++) {
+            if(posizioni.presente[i]) {
+                x[nuovo[i]] = posizioni.x[i];
+                y[nuovo[i]] = posizioni.y[i];
+                presente[nuovo[i]] = true;
+            }
+        }
+        free(posizioni.x);
+        free(posizioni.y);
+        free(posizioni.presente);
+        posizioni.x = x;
+        posizioni.y = y;
+        posizioni.presente = presente;
+        posizioni.capacita = capacita;
+    }
+
+    while(cache.recente != NULL)
+        eliminaAlbero(cache.recente);
+    rinumeraFib(nuovo);
+    /* Le aree vanno ricostruite con i nuovi ID */
+    for(i = 0; i < rete.numAree; i++)
+        segnaArea(i);
+    aree.valida = false;
+    rete.csrValido = false;
+    generazioneTopologia++;
+    free(nuovo);
+}
+
+/*
+ * Funzione che rinumera i router della rete caricata, chiamata dopo il
+ * caricamento dei file
+ *
+ * @param tipo ORDINE_NESSUNO (non fa niente), ORDINE_BFS, ORDINE_RCM o ORDINE_GRADO
+ */
+void riordinaRete(int tipo) {
+    const struct csr *g;
+    int *ordine;
+
+    if(tipo == ORDINE_NESSUNO || (g = aggiornaCSRCompatto())->numNodi == 0)
+        return;
+    ordine = (int *)malloc(g->numNodi * sizeof(int));
+    calcolaOrdine(g, tipo, ordine);
+    rinumeraNodi(ordine);
+    free(ordine);
+}
+
+/*
+ * Funzione che calcola la distanza media tra gli ID dei due estremi degli
+ * archi: più è bassa più le distanze lette da un nodo sono vicine in memoria
+ */
+double distanzaMediaArchi(const struct csr *g) {
+    double somma = 0;
+    int i, j;
+
+    for(i = 0; i < g->numNodi; i++)
+        for(j = g->offset[i]; j < g->offset[i + 1]; j++)
+            somma += abs(g->arrivo[j] - i);
+    return g->numArchi > 0 ? somma / g->numArchi : 0;
+}
+
+/*
+ * Funzione che apre un contatore hardware del processore per il thread
+ * attuale (solo Linux, perf_event_open). Il contatore parte fermo.
+ *
+ * @param tipo PERF_TYPE_HARDWARE o PERF_TYPE_HW_CACHE
+ * @param config evento da contare
+ * @return file descriptor del contatore, -1 se non disponibile
+ */
+int apriContatore(unsigned int tipo, unsigned long long config) {
+    struct perf_event_attr attributi;
+
+    memset(&attributi, 0, sizeof(attributi));
+    attributi.size = sizeof(attributi);
+    attributi.type = tipo;
+    attributi.config = config;
+    attributi.disabled = 1;
+    attributi.exclude_kernel = 1;
+    attributi.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attributi, 0, -1, -1, 0);
+}
+
+/*
+ * Funzione che legge il valore di un contatore aperto con apriContatore
+ *
+ * @return valore, -1 se il contatore non è disponibile
+ */
+long long leggiContatore(int fd) {
+    long long valore;
+
+    if(fd < 0 || read(fd, &valore, sizeof(valore)) != sizeof(valore))
+        return -1;
+    return valore;
+}
+
+/*
+ * Benchmark delle rinumerazioni:
+ * ./dijkstra --bench-ordine [-n campioni] file...
+ * Calcola le tabelle degli stessi router (scelti a caso con seme fisso) con
+ * gli ID dei file e dopo ogni rinumerazione, e stampa tempo per tabella,
+ * speedup, cache miss dai contatori hardware (se il sistema li permette,
+ * altrimenti n/d) e distanza media tra gli ID degli estremi degli archi.
+ * Controlla anche che i costi trovati siano gli stessi.
+ *
+ * @param argc numero di argomenti dopo --bench-ordine
+ * @param argv argomenti dopo --bench-ordine
+ * @return codice di uscita del programma
+ */
+int benchOrdine(int argc, char **argv) {
+    const char *eventi[] = {"miss LLC", "miss L1D"};
+    const unsigned long long config[] = {PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+    const unsigned int tipoEvento[] = {PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE};
+    const struct csr *g;
+    struct statoTabella stato;
+    unsigned long long seme = 1;
+    char **router;
+    long long somma, sommaBase = 0, miss, missBase[2] = {-1, -1};
+    double inizio, rinumerazione, tempo, tempoBase = 0;
+    int campioni = 100, numRouter = 0, tipo, fd[2], e, i, errori = 0, *candidati, numCandidati = 0;
+
+    for(i = 0; i < argc; i++) {
+        if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            campioni = atoi(argv[++i]);
+        else if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    g = aggiornaCSR();
+    if(g->numNodi == 0 || campioni < 1)
+        return (EXIT_FAILURE);
+
+    /* I router vengono ricordati per nome, gli ID cambiano ad ogni rinumerazione */
+    candidati = (int *)malloc(g->numNodi * sizeof(int));
+    for(i = 0; i < g->numNodi; i++)
+        if(g->offset[i + 1] > g->offset[i])
+            candidati[numCandidati++] = i;
+    router = (char **)malloc(campioni * sizeof(char *));
+    for(i = 0; i < campioni && numCandidati > 0; i++)
+        router[numRouter++] = strdup(nomeNodo(candidati[casualeTra(&seme, 0, numCandidati - 1)]));
+    free(candidati);
+    printf("%d nodi, %d archi, %d tabelle per ordine\n", g->numNodi, g->numArchi, numRouter);
+
+    for(tipo = ORDINE_NESSUNO; tipo <= ORDINE_GRADO; tipo++) {
+        inizio = secondi();
+        riordinaRete(tipo);
+        rinumerazione = secondi() - inizio;
+        g = aggiornaCSR();
+        creaStato(&stato, g->numNodi);
+        /* Una tabella di riscaldamento, poi la misura */
+        calcolaTabella(g, cercaNome(router[0]), &stato);
+        for(e = 0; e < 2; e++) {
+            fd[e] = apriContatore(tipoEvento[e], config[e]);
+            if(fd[e] >= 0)
+                ioctl(fd[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+        somma = 0;
+        inizio = secondi();
+        for(i = 0; i < numRouter; i++) {
+            calcolaTabella(g, cercaNome(router[i]), &stato);
+            for(e = 0; e < stato.numRaggiunti; e++)
+                somma += stato.distanza[stato.ordine[e]];
+        }
+        tempo = secondi() - inizio;
+        for(e = 0; e < 2; e++)
+            if(fd[e] >= 0)
+                ioctl(fd[e], PERF_EVENT_IOC_DISABLE, 0);
+        if(tipo == ORDINE_NESSUNO) {
+            tempoBase = tempo;
+            sommaBase = somma;
+        }
+
+        printf("  %-8s %9.1f us/tabella  speedup %.2fx", nomeOrdine(tipo), tempo * 1e6 / numRouter, tempoBase / tempo);
+        for(e = 0; e < 2; e++) {
+            miss = leggiContatore(fd[e]);
+            if(fd[e] >= 0)
+                close(fd[e]);
+            if(tipo == ORDINE_NESSUNO)
+                missBase[e] = miss;
+            if(miss < 0)
+                printf("  %s n/d", eventi[e]);
+            else if(missBase[e] > 0)
+                printf("  %s %lld/tabella (%+.0f%%)", eventi[e], miss / numRouter, 100.0 * (miss - missBase[e]) / missBase[e]);
+            else
+                printf("  %s %lld/tabella", eventi[e], miss / numRouter);
+        }
+        printf("  distanza archi %.0f  rinumerazione %.3f s\n", distanzaMediaArchi(g), rinumerazione);
+        if(somma != sommaBase) {
+            printf("  costi diversi dall'ordine dei file!\n");
+            errori++;
+        }
+        liberaStato(&stato);
+    }
+    for(i = 0; i < numRouter; i++)
+        free(router[i]);
+    free(router);
+    return errori == 0 ? (EXIT_SUCCESS) : (EXIT_FAILURE);
+}
+
+/*
+ * Funzione che copia la tabella globale dei nomi per una versione della rete
+ *
+ * @return copia da liberare con liberaVersione
+ */
+struct tabellaNomi *copiaNomi() {
+    struct tabellaNomi *t = (struct tabellaNomi *)malloc(sizeof(struct tabellaNomi));
+
+    *t = nomi;
+    t->capacitaCaratteri = nomi.usati + 1;
+    t->capacitaNomi = nomi.numNomi + 1;
+    t->caratteri = (char *)memcpy(malloc(t->capacitaCaratteri), nomi.caratteri, nomi.usati);
+    t->inizio = (size_t *)memcpy(malloc(t->capacitaNomi * sizeof(size_t)), nomi.inizio, nomi.numNomi * sizeof(size_t));
+    t->slot = (int *)memcpy(malloc(nomi.capacitaSlot * sizeof(int) + 1), nomi.slot, nomi.capacitaSlot * sizeof(int));
+    t->hashSlot = (unsigned int *)memcpy(malloc(nomi.capacitaSlot * sizeof(unsigned int) + 1), nomi.hashSlot,
+                                         nomi.capacitaSlot * sizeof(unsigned int));
+    return t;
+}
+
+/*
+ * Funzione che pubblica la rete attuale come nuova versione per i lettori
+ * e mette la precedente tra quelle da liberare. Va chiamata con
+ * mutexScrittura, dopo un gruppo di modifiche.
+ */
+void pubblicaVersione() {
+    const struct csr *g = aggiornaCSRCompatto();
+    struct versioneRete *v = (struct versioneRete *)calloc(1, sizeof(struct versioneRete));
+    struct versioneRete *vecchia = epoche.attuale;
+
+    /* Copia del CSR, quello globale resta dello scrittore */
+    v->csr.numNodi = g->numNodi;
+    v->csr.numArchi = g->numArchi;
+    v->csr.offset = (int *)memcpy(malloc((g->numNodi + 1) * sizeof(int)), g->offset, (g->numNodi + 1) * sizeof(int));
+    v->csr.arrivo = (int *)memcpy(malloc((g->numArchi + 1) * sizeof(int)), g->arrivo, g->numArchi * sizeof(int));
+    v->csr.costo = (int *)memcpy(malloc((g->numArchi + 1) * sizeof(int)), g->costo, g->numArchi * sizeof(int));
+    v->csr.costoMinimo = g->costoMinimo;
+    v->csr.costoMassimo = g->costoMassimo;
+    /* I nomi non vengono mai tolti, se il numero è lo stesso non sono cambiati */
+    v->nomi = vecchia != NULL && vecchia->nomi->numNomi == nomi.numNomi ? vecchia->nomi : copiaNomi();
+    v->numero = generazioneTopologia;
+    __atomic_store_n(&epoche.attuale, v, __ATOMIC_SEQ_CST);
+
+    if(vecchia != NULL) {
+        vecchia->liberaNomi = v->nomi != vecchia->nomi;
+        vecchia->epoca = __atomic_add_fetch(&epoche.globale, 1, __ATOMIC_SEQ_CST);
+        vecchia->succ = epoche.ritirate;
+        epoche.ritirate = vecchia;
+    }
+    liberaVersioniRitirate();
+}
+
+/*
+ * Funzione che libera la memoria di una versione della rete
+ */
+void liberaVersione(struct versioneRete *v) {
+    free(v->csr.offset);
+    free(v->csr.arrivo);
+    free(v->csr.costo);
+    if(v->liberaNomi) {
+        free(v->nomi->caratteri);
+        free(v->nomi->inizio);
+        free(v->nomi->slot);
+        free(v->nomi->hashSlot);
+        free(v->nomi);
+    }
+    free(v);
+}
+
+/*
+ * Funzione che libera le versioni sostituite che nessun lettore può più
+ * usare: quelle sostituite ad un'epoca non maggiore della minima epoca
+ * annunciata dai lettori attivi. Va chiamata con mutexScrittura.
+ */
+void liberaVersioniRitirate() {
+    unsigned long long minima = ULLONG_MAX, epoca;
+    struct versioneRete **v = &epoche.ritirate, *libera;
+    int i;
+
+    for(i = 0; i < epoche.numLettori; i++) {
+        epoca = __atomic_load_n(&epoche.lettori[i], __ATOMIC_SEQ_CST);
+        if(epoca != 0 && epoca < minima)
+            minima = epoca;
+    }
+    while(*v != NULL) {
+        if((*v)->epoca <= minima) {
+            libera = *v;
+            *v = libera->succ;
+            liberaVersione(libera);
+        }
+        else {
+            v = &(*v)->succ;
+        }
+    }
+}
+
+/*
+ * Funzione con cui un lettore inizia ad usare la versione attuale della
+ * rete, che resta valida fino a esciLettura anche se ne viene pubblicata
+ * un'altra. Non aspetta mai lo scrittore.
+ *
+ * @param lettore posizione del lettore in epoche.lettori
+ * @return versione da leggere
+ */
+const struct versioneRete *entraLettura(int lettore) {
+    /* L'epoca va annunciata prima di leggere la versione: uno scrittore che
+       non la vede ha già pubblicato la versione nuova */
+    __atomic_store_n(&epoche.lettori[lettore], __atomic_load_n(&epoche.globale, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&epoche.attuale, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * Funzione con cui un lettore smette di usare la sua versione della rete
+ */
+void esciLettura(int lettore) {
+    __atomic_store_n(&epoche.lettori[lettore], 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * Funzione che cambia l'accesso alla rete di un thread del server. Alla fine
+ * di un gruppo di modifiche la rete viene pubblicata in una nuova versione.
+ *
+ * @param l thread del server
+ * @param accesso ACCESSO_NESSUNO, ACCESSO_LETTURA o ACCESSO_SCRITTURA
+ */
+void cambiaAccesso(struct lavoratoreServer *l, int accesso) {
+    if(l->accesso == accesso)
+        return;
+    if(l->accesso == ACCESSO_SCRITTURA) {
+        if(l->modificata)
+            pubblicaVersione();
+        l->modificata = false;
+        pthread_mutex_unlock(&mutexScrittura);
+    }
+    else if(l->accesso == ACCESSO_LETTURA) {
+        esciLettura(l->indice);
+    }
+    if(accesso == ACCESSO_LETTURA)
+        l->versione = entraLettura(l->indice);
+    else if(accesso == ACCESSO_SCRITTURA)
+        pthread_mutex_lock(&mutexScrittura);
+    l->accesso = accesso;
+}
+
+/*
+ * Funzione che esegue una richiesta del server e ne scrive la risposta in
+ * l->uscita. Le richieste sono righe di testo:
+ * TABELLA R          -> OK n, poi n righe "nextHop; destinazione; costo"
+ * PERCORSO R1 R2     -> OK costo R1 ... R2
+ * AGGIUNGI R1 R2 c   -> OK (link nei due versi, come nel menu)
+ * RIMUOVI R1 R2      -> OK (solo il verso R1 -> R2, come nel menu)
+ * CARICA file        -> OK nodi archi
+ * VERSIONE           -> OK numero nodi archi della versione letta
+ * VICINI R [COSTO c] [HOP h] [K n] -> come TABELLA, solo le destinazioni nei limiti
+ * CHIUDI             -> chiude la connessione
+ * In caso di errore la risposta è una riga "ERR motivo".
+ *
+ * @param l thread del server
+ * @param riga richiesta terminata da '\0', viene modificata
+ * @return false se la connessione va chiusa
+ */
+bool eseguiRichiesta(struct lavoratoreServer *l, char *riga) {
+    char *salva, *comando, *a, *b, *c, *fine;
+    int idPartenza, idArrivo, costo, numHop, estratti, *percorso, i, valore;
+    struct limitiRicerca limiti;
+    const struct versioneRete *v;
+    const char *metodo;
+
+    comando = strtok_r(riga, " \t\r", &salva);
+    if(comando == NULL)
+        return true;
+    a = strtok_r(NULL, " \t\r", &salva);
+    b = strtok_r(NULL, " \t\r", &salva);
+    c = strtok_r(NULL, " \t\r", &salva);
+
+    if(strcmp(comando, "CHIUDI") == 0)
+        return false;
+    if(strcmp(comando, "TABELLA") == 0 && a != NULL) {
+        cambiaAccesso(l, ACCESSO_LETTURA);
+        v = l->versione;
+        idPartenza = cercaNomeIn(v->nomi, a);
+        if(idPartenza < 0 || v->csr.offset[idPartenza + 1] == v->csr.offset[idPartenza]) {
+            aggiungiStringa(&l->uscita, "ERR nodo non esistente\n");
+            return true;
+        }
+        allargaStato(&l->stato, v->csr.numNodi);
+        calcolaTabella(&v->csr, idPartenza, &l->stato);
+        aggiungiStringa(&l->uscita, "OK ");
+        aggiungiIntero(&l->uscita, l->stato.numRaggiunti);
+        aggiungiStringa(&l->uscita, "\n");
+        scriviRighe(&l->uscita, v->nomi, &l->stato);
+    }
+    else if(strcmp(comando, "VICINI") == 0 && a != NULL) {
+        /* I limiti sono coppie nome valore, b e c sono la prima */
+        limiti.costo = limiti.hop = limiti.numero = SENZA_LIMITE;
+        for(; b != NULL && c != NULL; b = strtok_r(NULL, " \t\r", &salva), c = strtok_r(NULL, " \t\r", &salva)) {
+            valore = (int)strtol(c, &fine, 10);
+            if(*fine != '\0' || valore < 0)
+                break;
+            if(strcmp(b, "COSTO") == 0)
+                limiti.costo = valore;
+            else if(strcmp(b, "HOP") == 0)
+                limiti.hop = valore;
+            else if(strcmp(b, "K") == 0)
+                limiti.numero = valore;
+            else
+                break;
+        }
+        if(b != NULL) {
+            aggiungiStringa(&l->uscita, "ERR limite non valido\n");
+            return true;
+        }
+        cambiaAccesso(l, ACCESSO_LETTURA);
+        v = l->versione;
+        idPartenza = cercaNomeIn(v->nomi, a);
+        if(idPartenza < 0 || v->csr.offset[idPartenza + 1] == v->csr.offset[idPartenza]) {
+            aggiungiStringa(&l->uscita, "ERR nodo non esistente\n");
+            return true;
+        }
+        calcolaTabellaLimitata(&v->csr, idPartenza, &limiti, &l->limitato);
+        aggiungiStringa(&l->uscita, "OK ");
+        aggiungiIntero(&l->uscita, l->limitato.numRisultati);
+        aggiungiStringa(&l->uscita, "\n");
+        scriviRigheLimitate(&l->uscita, v->nomi, &l->limitato);
+    }
+    else if(strcmp(comando, "VERSIONE") == 0) {
+        cambiaAccesso(l, ACCESSO_LETTURA);
+        riservaBuffer(&l->uscita, 64);
+        l->uscita.usati += sprintf(l->uscita.dati + l->uscita.usati, "OK %llu %d %d\n", l->versione->numero,
+                                   l->versione->csr.numNodi, l->versione->csr.numArchi);
+    }
+    else if(strcmp(comando, "PERCORSO") == 0 && b != NULL) {
+        /* La ricerca usa la rete globale e gli stati condivisi, quindi
+           viene fatta con l'accesso dello scrittore */
+        cambiaAccesso(l, ACCESSO_SCRITTURA);
+        idPartenza = cercaNome(a);
+        idArrivo = cercaNome(b);
+        if(idPartenza < 0 || idArrivo < 0) {
+            aggiungiStringa(&l->uscita, "ERR nodo non esistente\n");
+            return true;
+        }
+        costo = trovaPercorso(idPartenza, idArrivo, &percorso, &numHop, &estratti, &metodo);
+        if(costo == INT_MAX) {
+            aggiungiStringa(&l->uscita, "ERR non raggiungibile\n");
+        }
+        else {
+            aggiungiStringa(&l->uscita, "OK ");
+            aggiungiIntero(&l->uscita, costo);
+            for(i = 0; i < numHop; i++) {
+                aggiungiStringa(&l->uscita, " ");
+                aggiungiStringa(&l->uscita, nomeNodo(percorso[i]));
+            }
+            aggiungiStringa(&l->uscita, "\n");
+        }
+        free(percorso);
+    }
+    else if(strcmp(comando, "AGGIUNGI") == 0 && c != NULL) {
+        costo = (int)strtol(c, &fine, 10);
+        if(*fine != '\0' || costo < 0) {
+            aggiungiStringa(&l->uscita, "ERR costo non valido\n");
+            return true;
+        }
+        cambiaAccesso(l, ACCESSO_SCRITTURA);
+        idPartenza = internaNome(a);
+        idArrivo = internaNome(b);
+        /* Il CSR non è aggiornato dentro un gruppo di modifiche, il controllo
+           usa l'insieme degli archi presenti */
+        if(contaArco(idPartenza, idArrivo) > 0) {
+            aggiungiStringa(&l->uscita, "ERR connessione già esistente\n");
+            return true;
+        }
+        inserisciArco(idPartenza, idArrivo, costo);
+        inserisciArco(idArrivo, idPartenza, costo);
+        l->modificata = true;
+        aggiungiStringa(&l->uscita, "OK\n");
+    }
+    else if(strcmp(comando, "RIMUOVI") == 0 && b != NULL) {
+        cambiaAccesso(l, ACCESSO_SCRITTURA);
+        idPartenza = cercaNome(a);
+        idArrivo = cercaNome(b);
+        if(idPartenza < 0 || idArrivo < 0 || !rimuoviArco(idPartenza, idArrivo, NULL)) {
+            aggiungiStringa(&l->uscita, "ERR connessione non esistente\n");
+            return true;
+        }
+        l->modificata = true;
+        aggiungiStringa(&l->uscita, "OK\n");
+    }
+    else if(strcmp(comando, "CARICA") == 0 && a != NULL) {
+        cambiaAccesso(l, ACCESSO_SCRITTURA);
+        if(!caricaFile(a)) {
+            aggiungiStringa(&l->uscita, "ERR impossibile aprire il file\n");
+            return true;
+        }
+        l->modificata = true;
+        aggiungiStringa(&l->uscita, "OK ");
+        aggiungiIntero(&l->uscita, nomi.numNomi);
+        aggiungiStringa(&l->uscita, " ");
+        aggiungiIntero(&l->uscita, rete.numArchi);
+        aggiungiStringa(&l->uscita, "\n");
+    }
+    else {
+        aggiungiStringa(&l->uscita, "ERR richiesta non valida\n");
+    }
+    return true;
+}
+
+/*
+ * Funzione che risponde alle richieste di una connessione finché il client
+ * non la chiude. Ogni lettura può contenere più richieste (anche mandate
+ * senza aspettare le risposte): vengono eseguite tutte e le risposte
+ * spedite insieme, nello stesso ordine.
+ *
+ * @param l thread del server
+ * @param fd socket della connessione
+ */
+void serviConnessione(struct lavoratoreServer *l, int fd) {
+    char *inizio, *fineRiga, *fine;
+    bool continua = true;
+    ssize_t letti;
+
+    l->entrata.usati = 0;
+    while(continua) {
+        riservaBuffer(&l->entrata, 65536);
+        letti = read(fd, l->entrata.dati + l->entrata.usati, l->entrata.capacita - l->entrata.usati);
+        if(letti < 0 && errno == EINTR)
+            continue;
+        if(letti <= 0)
+            break;
+        l->entrata.usati += letti;
+        inizio = l->entrata.dati;
+        fine = l->entrata.dati + l->entrata.usati;
+        l->uscita.usati = 0;
+        while(continua && (fineRiga = (char *)memchr(inizio, '\n', fine - inizio)) != NULL) {
+            *fineRiga = '\0';
+            continua = eseguiRichiesta(l, inizio);
+            inizio = fineRiga + 1;
+        }
+        cambiaAccesso(l, ACCESSO_NESSUNO);
+        if(!spedisciTutto(fd, l->uscita.dati, l->uscita.usati))
+            break;
+        /* La richiesta incompleta resta per la prossima lettura */
+        l->entrata.usati = fine - inizio;
+        memmove(l->entrata.dati, inizio, l->entrata.usati);
+        if(l->entrata.usati > LIMITE_RICHIESTA)
+            break;
+    }
+    close(fd);
+}
+
+/*
+ * Funzione che spedisce tutti i byte di una risposta
+ *
+ * @return false se il client ha chiuso la connessione
+ */
+bool spedisciTutto(int fd, const char *dati, size_t dimensione) {
+    ssize_t spediti;
+
+    while(dimensione > 0) {
+        spediti = send(fd, dati, dimensione, MSG_NOSIGNAL);
+        if(spediti < 0 && errno == EINTR)
+            continue;
+        if(spediti <= 0)
+            return false;
+        dati += spediti;
+        dimensione -= spediti;
+    }
+    return true;
+}
+
+/*
+ * Funzione eseguita da ogni thread del server: accetta una connessione e la
+ * serve fino alla fine, poi passa alla prossima
+ *
+ * @param argomento struct lavoratoreServer del thread
+ */
+void *threadServer(void *argomento) {
+    struct lavoratoreServer *l = (struct lavoratoreServer *)argomento;
+    int fd;
+
+    for(;;) {
+        fd = accept(l->ascolto, NULL, NULL);
+        if(fd < 0 && errno == EINTR)
+            continue;
+        if(fd < 0)
+            break;
+        serviConnessione(l, fd);
+    }
+    return NULL;
+}
+
+/*
+ * Funzione chiamata con SIGINT e SIGTERM, rimuove il socket e termina
+ */
+void chiudiServer(int segnale) {
+    (void)segnale;
+    if(socketServer != NULL)
+        unlink(socketServer);
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * Modalità server, senza menu:
+ * ./dijkstra --server rete.sock [-j thread] [-O bfs|rcm|grado] [-s snapshot] file...
+ * Carica la rete e resta in ascolto sul socket Unix indicato, ogni thread
+ * (default: numero di core) serve una connessione alla volta con le
+ * richieste descritte in eseguiRichiesta.
+ *
+ * @param argc numero di argomenti dopo --server
+ * @param argv argomenti dopo --server
+ * @return codice di uscita del programma
+ */
+int modalitaServer(int argc, char **argv) {
+    struct sockaddr_un indirizzo;
+    struct lavoratoreServer *lavoratori;
+    pthread_t *thread;
+    int numThread = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int ascolto, numNodi, i;
+    const struct csr *g;
+
+    for(i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            numThread = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-O") == 0 && i + 1 < argc && tipoOrdine(argv[i + 1]) >= 0)
+            ordineNodi = tipoOrdine(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if(!caricaSnapshot(argv[++i])) {
+                fprintf(stderr, "Impossibile caricare lo snapshot %s\n", argv[i]);
+                return (EXIT_FAILURE);
+            }
+        }
+        else if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    if(numThread < 1)
+        numThread = 1;
+    riordinaRete(ordineNodi);
+
+    memset(&indirizzo, 0, sizeof(indirizzo));
+    indirizzo.sun_family = AF_UNIX;
+    if(strlen(argv[0]) >= sizeof(indirizzo.sun_path)) {
+        fprintf(stderr, "Percorso del socket troppo lungo: %s\n", argv[0]);
+        return (EXIT_FAILURE);
+    }
+    strcpy(indirizzo.sun_path, argv[0]);
+    ascolto = socket(AF_UNIX, SOCK_STREAM, 0);
+    /* Un socket rimasto da un avvio precedente viene sostituito */
+    unlink(argv[0]);
+    if(ascolto < 0 || bind(ascolto, (struct sockaddr *)&indirizzo, sizeof(indirizzo)) != 0
+       || listen(ascolto, ATTESA_SERVER) != 0) {
+        fprintf(stderr, "Impossibile aprire il socket %s: %s\n", argv[0], strerror(errno));
+        return (EXIT_FAILURE);
+    }
+    socketServer = argv[0];
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, chiudiServer);
+    signal(SIGTERM, chiudiServer);
+
+    g = aggiornaCSR();
+    numNodi = g->numNodi;
+    fprintf(stderr, "Server su %s: %d nodi, %d archi, %d thread\n", argv[0], g->numNodi, g->numArchi, numThread);
+    epoche.lettori = (unsigned long long *)calloc(numThread, sizeof(unsigned long long));
+    epoche.numLettori = numThread;
+    pubblicaVersione();
+    lavoratori = (struct lavoratoreServer *)calloc(numThread, sizeof(struct lavoratoreServer));
+    thread = (pthread_t *)malloc(numThread * sizeof(pthread_t));
+    for(i = 0; i < numThread; i++) {
+        lavoratori[i].ascolto = ascolto;
+        lavoratori[i].indice = i;
+        creaStato(&lavoratori[i].stato, numNodi);
+        pthread_create(&thread[i], NULL, threadServer, &lavoratori[i]);
+    }
+    for(i = 0; i < numThread; i++) {
+        pthread_join(thread[i], NULL);
+        liberaStato(&lavoratori[i].stato);
+        liberaStatoLimitato(&lavoratori[i].limitato);
+        free(lavoratori[i].entrata.dati);
+        free(lavoratori[i].uscita.dati);
+    }
+    free(lavoratori);
+    free(thread);
+    liberaVersioniRitirate();
+    epoche.attuale->liberaNomi = true;
+    liberaVersione(epoche.attuale);
+    free(epoche.lettori);
+    close(ascolto);
+    unlink(argv[0]);
+    return (EXIT_SUCCESS);
+}
+
+/*
+ * Funzione che sceglie l'area di un link aggiunto senza indicarla (menu,
+ * server): un'area in comune tra i due router, altrimenti la più piccola
+ * tra le aree dei due. Il risultato non dipende dal verso del link.
+ *
+ * @param partenza ID del router di partenza
+ * @param arrivo ID del router di arrivo
+ * @return area del link, 0 se i router non sono in nessuna area
+ */
+int areaComune(int partenza, int arrivo) {
+    int i, j, area = -1;
+
+    if(!aree.valida)
+        return 0;
+    if(partenza < aree.numNodi)
+        for(i = aree.offsetAppartiene[partenza]; i < aree.offsetAppartiene[partenza + 1]; i++) {
+            if(arrivo < aree.numNodi)
+                for(j = aree.offsetAppartiene[arrivo]; j < aree.offsetAppartiene[arrivo + 1]; j++)
+                    if(aree.areaAppartiene[i] == aree.areaAppartiene[j])
+                        return aree.areaAppartiene[i];
+            if(area == -1 || aree.areaAppartiene[i] < area)
+                area = aree.areaAppartiene[i];
+        }
+    if(arrivo < aree.numNodi)
+        for(j = aree.offsetAppartiene[arrivo]; j < aree.offsetAppartiene[arrivo + 1]; j++)
+            if(area == -1 || aree.areaAppartiene[j] < area)
+                area = aree.areaAppartiene[j];
+    return area == -1 ? 0 : area;
+}
+
+/*
+ * Funzione che segna come modificata un'area, i suoi sommari verranno
+ * ricalcolati alla prossima aggiornaAree
+ */
+void segnaArea(int area) {
+    if(area >= rete.capacitaAree) {
+        int vecchia = rete.capacitaAree;
+
+        while(area >= rete.capacitaAree)
+            rete.capacitaAree = rete.capacitaAree == 0 ? 16 : 2 * rete.capacitaAree;
+        rete.generazioneArea = (unsigned long long *)realloc(rete.generazioneArea, rete.capacitaAree * sizeof(unsigned long long));
+        memset(rete.generazioneArea + vecchia, 0, (rete.capacitaAree - vecchia) * sizeof(unsigned long long));
+    }
+    if(area >= rete.numAree)
+        rete.numAree = area + 1;
+    rete.generazioneArea[area]++;
+}
+
+/*
+ * Funzione che costruisce il CSR di un'area con ID locali, numerati
+ * nell'ordine in cui i router compaiono nei link.
+ *
+ * @param a area da ricostruire
+ * @param archi posizioni in rete.archi dei link dell'area
+ * @param numArchi numero di link dell'area
+ * @param locale array di lavoro grande quanto la rete, tutto a -1 (viene lasciato così)
+ */
+void ricostruisciArea(struct area *a, const int *archi, int numArchi, int *locale) {
+    const struct arco *x;
+    int i, *posizione;
+
+    a->numNodi = 0;
+    a->globale = (int *)realloc(a->globale, (2 * numArchi + 1) * sizeof(int));
+    for(i = 0; i < numArchi; i++) {
+        x = &rete.archi[archi[i]];
+        if(locale[x->partenza] == -1) {
+            locale[x->partenza] = a->numNodi;
+            a->globale[a->numNodi++] = x->partenza;
+        }
+        if(locale[x->arrivo] == -1) {
+            locale[x->arrivo] = a->numNodi;
+            a->globale[a->numNodi++] = x->arrivo;
+        }
+    }
+    /* Counting sort sul router di partenza, come in aggiornaCSR */
+    a->csr.numNodi = a->numNodi;
+    a->csr.numArchi = numArchi;
+    a->csr.offset = (int *)realloc(a->csr.offset, (a->numNodi + 1) * sizeof(int));
+    a->csr.arrivo = (int *)realloc(a->csr.arrivo, (numArchi + 1) * sizeof(int));
+    a->csr.costo = (int *)realloc(a->csr.costo, (numArchi + 1) * sizeof(int));
+    memset(a->csr.offset, 0, (a->numNodi + 1) * sizeof(int));
+    for(i = 0; i < numArchi; i++)
+        a->csr.offset[locale[rete.archi[archi[i]].partenza] + 1]++;
+    for(i = 0; i < a->numNodi; i++)
+        a->csr.offset[i + 1] += a->csr.offset[i];
+    posizione = (int *)malloc((a->numNodi + 1) * sizeof(int));
+    memcpy(posizione, a->csr.offset, (a->numNodi + 1) * sizeof(int));
+    for(i = 0; i < numArchi; i++) {
+        x = &rete.archi[archi[i]];
+        a->csr.arrivo[posizione[locale[x->partenza]]] = locale[x->arrivo];
+        a->csr.costo[posizione[locale[x->partenza]]++] = x->costo;
+    }
+    free(posizione);
+    aggiornaCostiEstremi(&a->csr);
+    for(i = 0; i < a->numNodi; i++)
+        locale[a->globale[i]] = -1;
+    a->sommariValidi = false;
+}
+
+/*
+ * Funzione che calcola i sommari di un'area: i cammini minimi interni
+ * all'area da ognuno dei suoi router di bordo
+ */
+void calcolaSommari(struct area *a) {
+    struct statoTabella stato;
+    size_t n = (size_t)a->numBordi * a->numNodi;
+    int r;
+
+    a->distanzaBordi = (int *)realloc(a->distanzaBordi, (n + 1) * sizeof(int));
+    a->precedenteBordi = (int *)realloc(a->precedenteBordi, (n + 1) * sizeof(int));
+    creaStato(&stato, a->numNodi);
+    for(r = 0; r < a->numBordi; r++) {
+        calcolaTabella(&a->csr, a->bordi[r], &stato);
+        memcpy(a->distanzaBordi + (size_t)r * a->numNodi, stato.distanza, a->numNodi * sizeof(int));
+        memcpy(a->precedenteBordi + (size_t)r * a->numNodi, stato.precedente, a->numNodi * sizeof(int));
+    }
+    liberaStato(&stato);
+    a->sommariValidi = true;
+}
+
+/*
+ * Funzione che aggiorna le aree della rete: vengono ricostruite solo le
+ * aree con link modificati dall'ultima chiamata, e ricalcolati i sommari
+ * di quelle aree e di quelle i cui router di bordo sono cambiati. Il grafo
+ * dei router di bordo viene sempre rifatto, costa quanto i sommari.
+ *
+ * @return aree della rete, NULL se il file non indica almeno due aree o se
+ *         ci sono costi non positivi (si usa Dijkstra su tutta la rete)
+ */
+const struct reteAree *aggiornaAree() {
+    const struct csr *g = aggiornaCSR();
+    struct reteAree *r = &aree;
+    struct area *a;
+    int i, j, k, t, x, b, d, *inizioArea, *archi, *locale;
+    bool cambiata;
+    double inizio;
+
+    if(r->valida && r->generazione == generazioneTopologia && r->numNodi == g->numNodi)
+        return r->numAreeUsate >= 2 && g->costoMinimo > 0 ? r : NULL;
+    /* Senza aree nel file non si costruisce niente */
+    if(rete.numAree <= 1 || g->costoMinimo <= 0) {
+        r->valida = false;
+        return NULL;
+    }
+    inizio = secondi();
+    if(r->numAree < rete.numAree) {
+        r->aree = (struct area *)realloc(r->aree, rete.numAree * sizeof(struct area));
+        memset(r->aree + r->numAree, 0, (rete.numAree - r->numAree) * sizeof(struct area));
+        r->numAree = rete.numAree;
+    }
+
+    /* Link divisi per area (counting sort) */
+    inizioArea = (int *)calloc(r->numAree + 1, sizeof(int));
+    archi = (int *)malloc((rete.numArchi + 1) * sizeof(int));
+    for(i = 0; i < rete.numSlot; i++)
+        if(rete.archi[i].partenza != ARCO_RIMOSSO)
+            inizioArea[rete.archi[i].area + 1]++;
+    for(k = 0; k < r->numAree; k++)
+        inizioArea[k + 1] += inizioArea[k];
+    for(i = 0; i < rete.numSlot; i++)
+        if(rete.archi[i].partenza != ARCO_RIMOSSO)
+            archi[inizioArea[rete.archi[i].area]++] = i;
+    for(k = r->numAree; k > 0; k--)
+        inizioArea[k] = inizioArea[k - 1];
+    inizioArea[0] = 0;
+
+    /* Ricostruzione delle sole aree modificate */
+    locale = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    for(i = 0; i < g->numNodi; i++)
+        locale[i] = -1;
+    r->numAreeUsate = 0;
+    r->maxNodiArea = 0;
+    for(k = 0; k < r->numAree; k++) {
+        a = &r->aree[k];
+        if(!r->valida || a->generazione != rete.generazioneArea[k]) {
+            ricostruisciArea(a, archi + inizioArea[k], inizioArea[k + 1] - inizioArea[k], locale);
+            a->generazione = rete.generazioneArea[k];
+        }
+        if(a->numNodi > 0)
+            r->numAreeUsate++;
+        if(a->numNodi > r->maxNodiArea)
+            r->maxNodiArea = a->numNodi;
+    }
+    free(inizioArea);
+    free(archi);
+    free(locale);
+
+    /* Aree di ogni router */
+    r->numNodi = g->numNodi;
+    r->offsetAppartiene = (int *)realloc(r->offsetAppartiene, (r->numNodi + 1) * sizeof(int));
+    memset(r->offsetAppartiene, 0, (r->numNodi + 1) * sizeof(int));
+    for(k = 0; k < r->numAree; k++)
+        for(x = 0; x < r->aree[k].numNodi; x++)
+            r->offsetAppartiene[r->aree[k].globale[x] + 1]++;
+    for(i = 0; i < r->numNodi; i++)
+        r->offsetAppartiene[i + 1] += r->offsetAppartiene[i];
+    r->areaAppartiene = (int *)realloc(r->areaAppartiene, (r->offsetAppartiene[r->numNodi] + 1) * sizeof(int));
+    r->localeAppartiene = (int *)realloc(r->localeAppartiene, (r->offsetAppartiene[r->numNodi] + 1) * sizeof(int));
+    for(k = 0; k < r->numAree; k++)
+        for(x = 0; x < r->aree[k].numNodi; x++) {
+            i = r->offsetAppartiene[r->aree[k].globale[x]]++;
+            r->areaAppartiene[i] = k;
+            r->localeAppartiene[i] = x;
+        }
+    for(i = r->numNodi; i > 0; i--)
+        r->offsetAppartiene[i] = r->offsetAppartiene[i - 1];
+    r->offsetAppartiene[0] = 0;
+
+    /* Router di bordo: quelli con link in più aree */
+    r->indiceBordo = (int *)realloc(r->indiceBordo, (r->numNodi + 1) * sizeof(int));
+    r->nodoBordo = (int *)realloc(r->nodoBordo, (r->numNodi + 1) * sizeof(int));
+    r->numBordi = 0;
+    for(i = 0; i < r->numNodi; i++) {
+        r->indiceBordo[i] = -1;
+        if(r->offsetAppartiene[i + 1] - r->offsetAppartiene[i] > 1) {
+            r->nodoBordo[r->numBordi] = i;
+            r->indiceBordo[i] = r->numBordi++;
+        }
+    }
+
+    /* Sommari delle aree modificate o con router di bordo diversi */
+    locale = (int *)malloc((r->maxNodiArea + 1) * sizeof(int));
+    for(k = 0; k < r->numAree; k++) {
+        a = &r->aree[k];
+        t = 0;
+        for(x = 0; x < a->numNodi; x++)
+            if(r->indiceBordo[a->globale[x]] != -1)
+                locale[t++] = x;
+        cambiata = t != a->numBordi || (t > 0 && memcmp(locale, a->bordi, t * sizeof(int)) != 0);
+        if(cambiata) {
+            a->numBordi = t;
+            a->bordi = (int *)realloc(a->bordi, (t + 1) * sizeof(int));
+            memcpy(a->bordi, locale, t * sizeof(int));
+        }
+        if(cambiata || !a->sommariValidi) {
+            calcolaSommari(a);
+            r->ricalcoli++;
+        }
+    }
+    free(locale);
+
+    /* Grafo dei router di bordo: un arco per ogni coppia di bordi collegata dentro un'area */
+    r->sopra.numNodi = r->numBordi;
+    r->sopra.offset = (int *)realloc(r->sopra.offset, (r->numBordi + 1) * sizeof(int));
+    memset(r->sopra.offset, 0, (r->numBordi + 1) * sizeof(int));
+    for(k = 0; k < r->numAree; k++) {
+        a = &r->aree[k];
+        for(j = 0; j < a->numBordi; j++)
+            for(t = 0; t < a->numBordi; t++)
+                if(t != j && a->distanzaBordi[(size_t)j * a->numNodi + a->bordi[t]] != INT_MAX)
+                    r->sopra.offset[r->indiceBordo[a->globale[a->bordi[j]]] + 1]++;
+    }
+    for(b = 0; b < r->numBordi; b++)
+        r->sopra.offset[b + 1] += r->sopra.offset[b];
+    r->sopra.numArchi = r->sopra.offset[r->numBordi];
+    r->sopra.arrivo = (int *)realloc(r->sopra.arrivo, (r->sopra.numArchi + 1) * sizeof(int));
+    r->sopra.costo = (int *)realloc(r->sopra.costo, (r->sopra.numArchi + 1) * sizeof(int));
+    r->areaSopra = (int *)realloc(r->areaSopra, (r->sopra.numArchi + 1) * sizeof(int));
+    r->rigaSopra = (int *)realloc(r->rigaSopra, (r->sopra.numArchi + 1) * sizeof(int));
+    r->localeSopra = (int *)realloc(r->localeSopra, (r->sopra.numArchi + 1) * sizeof(int));
+    for(k = 0; k < r->numAree; k++) {
+        a = &r->aree[k];
+        for(j = 0; j < a->numBordi; j++)
+            for(t = 0; t < a->numBordi; t++) {
+                d = a->distanzaBordi[(size_t)j * a->numNodi + a->bordi[t]];
+                if(t == j || d == INT_MAX)
+                    continue;
+                i = r->sopra.offset[r->indiceBordo[a->globale[a->bordi[j]]]]++;
+                r->sopra.arrivo[i] = r->indiceBordo[a->globale[a->bordi[t]]];
+                r->sopra.costo[i] = d;
+                r->areaSopra[i] = k;
+                r->rigaSopra[i] = j;
+                r->localeSopra[i] = a->bordi[t];
+            }
+    }
+    for(b = r->numBordi; b > 0; b--)
+        r->sopra.offset[b] = r->sopra.offset[b - 1];
+    r->sopra.offset[0] = 0;
+    aggiornaCostiEstremi(&r->sopra);
+
+    r->generazione = generazioneTopologia;
+    r->valida = true;
+    r->tempoSommari += secondi() - inizio;
+    return r->numAreeUsate >= 2 ? r : NULL;
+}
+
+/*
+ * Funzione che prepara la memoria di lavoro di calcolaTabellaAree per le
+ * aree indicate, viene allargata solo quando serve
+ */
+void preparaStatoAree(struct statoAree *sa, const struct reteAree *r) {
+    if(sa->capacitaNodi < r->maxNodiArea || sa->locale.distanza == NULL) {
+        if(sa->locale.distanza != NULL)
+            liberaStato(&sa->locale);
+        sa->capacitaNodi = r->maxNodiArea;
+        creaStato(&sa->locale, sa->capacitaNodi);
+        sa->migliore = (int *)realloc(sa->migliore, (sa->capacitaNodi + 1) * sizeof(int));
+        sa->rigaMigliore = (int *)realloc(sa->rigaMigliore, (sa->capacitaNodi + 1) * sizeof(int));
+    }
+    if(sa->capacitaBordi < r->numBordi || sa->coda.nodi == NULL) {
+        if(sa->coda.nodi != NULL)
+            liberaHeap(&sa->coda);
+        sa->capacitaBordi = r->numBordi;
+        creaHeap(&sa->coda, sa->capacitaBordi, NULL);
+        sa->distanzaSopra = (int *)realloc(sa->distanzaSopra, (sa->capacitaBordi + 1) * sizeof(int));
+        sa->arcoSopra = (int *)realloc(sa->arcoSopra, (sa->capacitaBordi + 1) * sizeof(int));
+    }
+}
+
+/*
+ * Funzione che libera la memoria di lavoro di calcolaTabellaAree
+ */
+void liberaStatoAree(struct statoAree *sa) {
+    if(sa->locale.distanza != NULL)
+        liberaStato(&sa->locale);
+    if(sa->coda.nodi != NULL)
+        liberaHeap(&sa->coda);
+    free(sa->migliore);
+    free(sa->rigaMigliore);
+    free(sa->distanzaSopra);
+    free(sa->arcoSopra);
+    memset(sa, 0, sizeof(*sa));
+}
+
+/*
+ * SPF a aree: Dijkstra nell'area della sorgente (se non è un router di
+ * bordo), Dijkstra sul grafo dei router di bordo partendo dai bordi
+ * raggiunti e infine, area per area, il costo di ogni router è il minimo
+ * tra quello locale e quelli dai bordi dell'area più i sommari. Le code di
+ * priorità contengono solo i router dell'area di partenza e quelli di
+ * bordo. Il risultato è lo stesso di calcolaTabella, a meno di next hop
+ * alternativi di pari costo; ordine non segue il costo.
+ *
+ * @param r aree della rete, da aggiornaAree
+ * @param start ID del router di partenza
+ * @param sa memoria di lavoro, non va condivisa tra thread
+ * @param s stato in cui salvare il risultato
+ */
+void calcolaTabellaAree(const struct reteAree *r, int start, struct statoAree *sa, struct statoTabella *s) {
+    const struct area *a;
+    int i, k, j, x, b, nodo, costo, areaStart = -1, localeStart, hop;
+    const int *distanza;
+    long long estratti = 0, rilassati = 0;
+    double inizio = formatoStatistiche != STATISTICHE_SPENTE ? secondi() : 0;
+
+    preparaStatoAree(sa, r);
+    for(i = 0; i < s->numRaggiunti; i++)
+        s->distanza[s->ordine[i]] = INT_MAX;
+    s->distanza[start] = 0;
+    s->precedente[start] = start;
+    s->nextHop[start] = start;
+    s->ordine[0] = start;
+    s->numRaggiunti = 1;
+
+    /* Router interno: Dijkstra nella sua area (ne ha una sola) */
+    if(r->indiceBordo[start] == -1 && r->offsetAppartiene[start] < r->offsetAppartiene[start + 1]) {
+        areaStart = r->areaAppartiene[r->offsetAppartiene[start]];
+        localeStart = r->localeAppartiene[r->offsetAppartiene[start]];
+        a = &r->aree[areaStart];
+        calcolaTabella(&a->csr, localeStart, &sa->locale);
+        estratti += sa->locale.numRaggiunti;
+        for(i = 0; i < sa->locale.numRaggiunti; i++)
+            rilassati += a->csr.offset[sa->locale.ordine[i] + 1] - a->csr.offset[sa->locale.ordine[i]];
+    }
+
+    /* Dijkstra sul grafo dei router di bordo */
+    for(b = 0; b < r->numBordi; b++)
+        sa->distanzaSopra[b] = INT_MAX;
+    if(areaStart == -1 && r->indiceBordo[start] != -1) {
+        b = r->indiceBordo[start];
+        sa->distanzaSopra[b] = 0;
+        sa->arcoSopra[b] = -1;
+        inserisciHeap(&sa->coda, b, 0);
+    }
+    else if(areaStart != -1) {
+        a = &r->aree[areaStart];
+        for(k = 0; k < a->numBordi; k++) {
+            costo = sa->locale.distanza[a->bordi[k]];
+            if(costo == INT_MAX)
+                continue;
+            b = r->indiceBordo[a->globale[a->bordi[k]]];
+            sa->distanzaSopra[b] = costo;
+            sa->arcoSopra[b] = -1;
+            inserisciHeap(&sa->coda, b, costo);
+        }
+    }
+    while(sa->coda.dimensione > 0) {
+        b = estraiMinimo(&sa->coda);
+        estratti++;
+        rilassati += r->sopra.offset[b + 1] - r->sopra.offset[b];
+        for(i = r->sopra.offset[b]; i < r->sopra.offset[b + 1]; i++) {
+            costo = sa->distanzaSopra[b] + r->sopra.costo[i];
+            x = r->sopra.arrivo[i];
+            if(costo >= sa->distanzaSopra[x])
+                continue;
+            sa->distanzaSopra[x] = costo;
+            sa->arcoSopra[x] = i;
+            inserisciHeap(&sa->coda, x, costo);
+        }
+    }
+
+    /* Combinazione area per area: i router di bordo hanno già il costo
+       minimo, gli altri prendono il migliore tra i bordi raggiunti */
+    for(k = 0; k < r->numAree; k++) {
+        a = &r->aree[k];
+        for(j = 0; j < a->numBordi; j++)
+            if(sa->distanzaSopra[r->indiceBordo[a->globale[a->bordi[j]]]] != INT_MAX)
+                break;
+        if(j == a->numBordi && k != areaStart)
+            continue;
+        for(x = 0; x < a->numNodi; x++) {
+            sa->migliore[x] = k == areaStart ? sa->locale.distanza[x] : INT_MAX;
+            sa->rigaMigliore[x] = -1;
+        }
+        for(j = 0; j < a->numBordi; j++) {
+            b = r->indiceBordo[a->globale[a->bordi[j]]];
+            if(sa->distanzaSopra[b] == INT_MAX)
+                continue;
+            distanza = a->distanzaBordi + (size_t)j * a->numNodi;
+            for(x = 0; x < a->numNodi; x++)
+                if(distanza[x] != INT_MAX && sa->distanzaSopra[b] + distanza[x] < sa->migliore[x]) {
+                    sa->migliore[x] = sa->distanzaSopra[b] + distanza[x];
+                    sa->rigaMigliore[x] = j;
+                }
+        }
+        for(x = 0; x < a->numNodi; x++) {
+            nodo = a->globale[x];
+            if(sa->migliore[x] == INT_MAX || nodo == start || r->indiceBordo[nodo] != -1)
+                continue;
+            s->distanza[nodo] = sa->migliore[x];
+            s->precedente[nodo] = a->globale[sa->rigaMigliore[x] == -1 ? sa->locale.precedente[x]
+                                  : a->precedenteBordi[(size_t)sa->rigaMigliore[x] * a->numNodi + x]];
+            s->nextHop[nodo] = -1;
+            s->ordine[s->numRaggiunti++] = nodo;
+        }
+    }
+    for(b = 0; b < r->numBordi; b++) {
+        nodo = r->nodoBordo[b];
+        if(sa->distanzaSopra[b] == INT_MAX || nodo == start)
+            continue;
+        s->distanza[nodo] = sa->distanzaSopra[b];
+        if(sa->arcoSopra[b] == -1) {
+            /* Raggiunto dentro l'area di partenza */
+            a = &r->aree[areaStart];
+            for(i = r->offsetAppartiene[nodo]; r->areaAppartiene[i] != areaStart; i++)
+                ;
+            s->precedente[nodo] = a->globale[sa->locale.precedente[r->localeAppartiene[i]]];
+        }
+        else {
+            i = sa->arcoSopra[b];
+            a = &r->aree[r->areaSopra[i]];
+            s->precedente[nodo] = a->globale[a->precedenteBordi[(size_t)r->rigaSopra[i] * a->numNodi + r->localeSopra[i]]];
+        }
+        s->nextHop[nodo] = -1;
+        s->ordine[s->numRaggiunti++] = nodo;
+    }
+
+    /* Next hop dai precedenti: si risale fino ad un router con il next hop
+       già noto (o figlio di start) e lo si assegna a tutta la catena */
+    for(i = 1; i < s->numRaggiunti; i++) {
+        for(x = s->ordine[i]; s->nextHop[x] == -1 && s->precedente[x] != start; x = s->precedente[x])
+            ;
+        hop = s->nextHop[x] == -1 ? x : s->nextHop[x];
+        for(x = s->ordine[i]; s->nextHop[x] == -1; x = s->precedente[x])
+            s->nextHop[x] = hop;
+    }
+
+    if(formatoStatistiche != STATISTICHE_SPENTE) {
+        memset(&s->contatori, 0, sizeof(s->contatori));
+        s->contatori.tabelle = 1;
+        s->contatori.nodiEstratti = estratti;
+        s->contatori.archiRilassati = rilassati;
+        s->contatori.piccoCoda = sa->locale.contatori.piccoCoda;
+        s->contatori.calcolo = secondi() - inizio;
+    }
+}
+
+/*
+ * Benchmark dell'SPF a aree:
+ * ./dijkstra --bench-aree [-n campioni] file...
+ * Calcola le tabelle di router scelti a caso (seme fisso) con Dijkstra su
+ * tutta la rete e con l'SPF a aree, controlla che i costi siano uguali e
+ * stampa il tempo per tabella. Poi cambia il costo di un link interno ad
+ * un'area e misura quante aree vengono ricalcolate e quanto costa.
+ *
+ * @param argc numero di argomenti dopo --bench-aree
+ * @param argv argomenti dopo --bench-aree
+ * @return codice di uscita del programma
+ */
+int benchAree(int argc, char **argv) {
+    const struct csr *g;
+    const struct reteAree *r;
+    struct statoTabella stato, statoAree;
+    struct statoAree sa;
+    unsigned long long seme = 1;
+    int campioni = 100, i, e, x, errori = 0, *router, vecchioCosto, costo;
+    long long ricalcoli;
+    double inizio, tempoDijkstra, tempoAree;
+
+    for(i = 0; i < argc; i++) {
+        if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            campioni = atoi(argv[++i]);
+        else if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    g = aggiornaCSR();
+    if(g->numNodi == 0 || campioni < 1)
+        return (EXIT_FAILURE);
+    inizio = secondi();
+    r = aggiornaAree();
+    if(r == NULL) {
+        fprintf(stderr, "Il file non indica almeno due aree (o ci sono costi non positivi)\n");
+        return (EXIT_FAILURE);
+    }
+    printf("%d nodi, %d archi, %d aree, %d router di bordo, area più grande %d router\n",
+           g->numNodi, g->numArchi, r->numAreeUsate, r->numBordi, r->maxNodiArea);
+    printf("Aree e sommari: %.3f s, %d archi tra i router di bordo\n", secondi() - inizio, r->sopra.numArchi);
+
+    router = (int *)malloc(campioni * sizeof(int));
+    for(i = 0; i < campioni; i++)
+        router[i] = casualeTra(&seme, 0, g->numNodi - 1);
+    creaStato(&stato, g->numNodi);
+    creaStato(&statoAree, g->numNodi);
+    memset(&sa, 0, sizeof(sa));
+    inizio = secondi();
+    for(i = 0; i < campioni; i++)
+        calcolaTabella(g, router[i], &stato);
+    tempoDijkstra = secondi() - inizio;
+    inizio = secondi();
+    for(i = 0; i < campioni; i++)
+        calcolaTabellaAree(r, router[i], &sa, &statoAree);
+    tempoAree = secondi() - inizio;
+    for(i = 0; i < campioni; i++) {
+        calcolaTabella(g, router[i], &stato);
+        calcolaTabellaAree(r, router[i], &sa, &statoAree);
+        if(stato.numRaggiunti != statoAree.numRaggiunti)
+            errori++;
+        for(e = 0; e < stato.numRaggiunti; e++)
+            if(stato.distanza[stato.ordine[e]] != statoAree.distanza[stato.ordine[e]])
+                errori++;
+    }
+    printf("  dijkstra %9.1f us/tabella\n", tempoDijkstra * 1e6 / campioni);
+    printf("  aree     %9.1f us/tabella  speedup %.2fx\n", tempoAree * 1e6 / campioni, tempoDijkstra / tempoAree);
+    if(errori > 0)
+        printf("  %d costi diversi da Dijkstra!\n", errori);
+
+    /* Modifica di un link: si ricalcola solo la sua area */
+    for(i = 0; i < rete.numSlot && rete.archi[i].partenza == ARCO_RIMOSSO; i++)
+        ;
+    if(i < rete.numSlot) {
+        x = i;
+        costo = rete.archi[x].costo + 1;
+        ricalcoli = r->ricalcoli;
+        modificaCostoArco(rete.archi[x].partenza, rete.archi[x].arrivo, costo, &vecchioCosto);
+        inizio = secondi();
+        r = aggiornaAree();
+        printf("Modifica di %s -> %s (area %d): %lld aree ricalcolate su %d, %.3f s\n",
+               nomeNodo(rete.archi[x].partenza), nomeNodo(rete.archi[x].arrivo), rete.archi[x].area,
+               r->ricalcoli - ricalcoli, r->numAreeUsate, secondi() - inizio);
+        g = aggiornaCSR();
+        for(i = 0; i < campioni; i++) {
+            calcolaTabella(g, router[i], &stato);
+            calcolaTabellaAree(r, router[i], &sa, &statoAree);
+            for(e = 0; e < stato.numRaggiunti; e++)
+                if(stato.distanza[stato.ordine[e]] != statoAree.distanza[stato.ordine[e]])
+                    errori++;
+        }
+        if(errori > 0)
+            printf("  costi diversi da Dijkstra dopo la modifica!\n");
+    }
+    liberaStato(&stato);
+    liberaStato(&statoAree);
+    liberaStatoAree(&sa);
+    free(router);
+    return errori == 0 ? (EXIT_SUCCESS) : (EXIT_FAILURE);
+}
+
+/*
+ * Funzione che svuota lo stato di una ricerca limitata in tempo
+ * proporzionale ai router visitati dalla ricerca precedente. Gli slot
+ * vengono liberati al contrario dell'ordine di inserimento, così la
+ * sequenza di slot provati per ogni router resta intatta finché serve.
+ */
+void azzeraStatoLimitato(struct statoLimitato *s) {
+    int i, j;
+
+    for(i = s->numVisitati - 1; i >= 0; i--) {
+        j = (int)((s->nodo[i] * 0x9E3779B97F4A7C15ull) >> 32) & (s->capacitaSlot - 1);
+        while(s->slot[j] != i)
+            j = (j + 1) & (s->capacitaSlot - 1);
+        s->slot[j] = -1;
+    }
+    for(i = 0; i < s->coda.dimensione; i++)
+        s->coda.posizione[s->coda.nodi[i]] = -1;
+    s->coda.dimensione = 0;
+    s->numVisitati = 0;
+    s->numRisultati = 0;
+}
+
+/*
+ * Funzione che libera la memoria di una ricerca limitata
+ */
+void liberaStatoLimitato(struct statoLimitato *s) {
+    free(s->slot);
+    free(s->nodo);
+    free(s->distanza);
+    free(s->nextHop);
+    free(s->ordine);
+    free(s->coda.nodi);
+    free(s->coda.valori);
+    free(s->coda.posizione);
+    free(s->frontiera);
+    free(s->nodoGiro);
+    free(s->costoGiro);
+    free(s->hopGiro);
+    free(s->giro);
+    memset(s, 0, sizeof(*s));
+}
+
+/*
+ * Funzione che restituisce l'indice locale di un router nella ricerca
+ * limitata, aggiungendolo (non raggiunto) se non è ancora stato visitato.
+ * Gli array crescono raddoppiando, quindi i puntatori ottenuti prima della
+ * chiamata non sono più validi.
+ *
+ * @param s stato della ricerca
+ * @param nodo ID globale del router
+ * @return indice locale del router
+ */
+int indiceLimitato(struct statoLimitato *s, int nodo) {
+    int i, j, k;
+
+    /* La hash table resta piena al massimo a metà */
+    if(2 * (s->numVisitati + 1) > s->capacitaSlot) {
+        s->capacitaSlot = s->capacitaSlot == 0 ? 64 : 2 * s->capacitaSlot;
+        s->slot = (int *)realloc(s->slot, s->capacitaSlot * sizeof(int));
+        for(j = 0; j < s->capacitaSlot; j++)
+            s->slot[j] = -1;
+        for(k = 0; k < s->numVisitati; k++) {
+            j = (int)((s->nodo[k] * 0x9E3779B97F4A7C15ull) >> 32) & (s->capacitaSlot - 1);
+            while(s->slot[j] != -1)
+                j = (j + 1) & (s->capacitaSlot - 1);
+            s->slot[j] = k;
+        }
+    }
+    j = (int)((nodo * 0x9E3779B97F4A7C15ull) >> 32) & (s->capacitaSlot - 1);
+    while(s->slot[j] != -1 && s->nodo[s->slot[j]] != nodo)
+        j = (j + 1) & (s->capacitaSlot - 1);
+    if(s->slot[j] != -1)
+        return s->slot[j];
+
+    /* Nuovo router visitato */
+    if(s->numVisitati == s->capacita) {
+        s->capacita = s->capacita == 0 ? 32 : 2 * s->capacita;
+        s->nodo = (int *)realloc(s->nodo, s->capacita * sizeof(int));
+        s->distanza = (int *)realloc(s->distanza, s->capacita * sizeof(int));
+        s->nextHop = (int *)realloc(s->nextHop, s->capacita * sizeof(int));
+        s->ordine = (int *)realloc(s->ordine, s->capacita * sizeof(int));
+        s->coda.nodi = (int *)realloc(s->coda.nodi, s->capacita * sizeof(int));
+        s->coda.valori = (int *)realloc(s->coda.valori, s->capacita * sizeof(int));
+        s->coda.posizione = (int *)realloc(s->coda.posizione, s->capacita * sizeof(int));
+        s->frontiera = (int *)realloc(s->frontiera, s->capacita * sizeof(int));
+        s->nodoGiro = (int *)realloc(s->nodoGiro, s->capacita * sizeof(int));
+        s->costoGiro = (int *)realloc(s->costoGiro, s->capacita * sizeof(int));
+        s->hopGiro = (int *)realloc(s->hopGiro, s->capacita * sizeof(int));
+        s->giro = (int *)realloc(s->giro, s->capacita * sizeof(int));
+    }
+    i = s->numVisitati++;
+    s->slot[j] = i;
+    s->nodo[i] = nodo;
+    s->distanza[i] = INT_MAX;
+    s->coda.posizione[i] = -1;
+    s->giro[i] = 0;
+    return i;
+}
+
+/*
+ * Ricerca limitata: tabella parziale di start con le sole destinazioni entro
+ * i limiti. Senza limite di hop è Dijkstra che non inserisce in coda i
+ * router oltre il costo massimo e si ferma dopo numero destinazioni. Con il
+ * limite di hop è Bellman-Ford a giri: al giro h si estendono di un hop i
+ * soli router migliorati al giro prima, col costo che avevano alla fine di
+ * quel giro, così il costo di ogni destinazione è il minimo tra i percorsi
+ * con al massimo hop link (non sempre quello della tabella completa); poi
+ * si tengono le numero più vicine. La memoria dipende solo dai router
+ * visitati, cioè le destinazioni e i loro vicini.
+ *
+ * @param g grafo in formato CSR
+ * @param start ID del router di partenza
+ * @param limiti limiti della ricerca
+ * @param s stato in cui salvare il risultato, quello precedente viene azzerato qui
+ */
+void calcolaTabellaLimitata(const struct csr *g, int start, const struct limitiRicerca *limiti, struct statoLimitato *s) {
+    unsigned long long *chiavi;
+    int u, v, i, k, nodo, costo, giro, numFrontiera, fine;
+
+    azzeraStatoLimitato(s);
+    u = indiceLimitato(s, start);
+    s->distanza[u] = 0;
+    s->nextHop[u] = start;
+    if(limiti->numero == 0)
+        return;
+
+    if(limiti->hop == SENZA_LIMITE) {
+        inserisciHeap(&s->coda, u, 0);
+        while(s->coda.dimensione > 0) {
+            u = estraiMinimo(&s->coda);
+            s->ordine[s->numRisultati++] = u;
+            if(s->numRisultati == limiti->numero)
+                break;
+            nodo = s->nodo[u];
+            for(i = g->offset[nodo]; i < g->offset[nodo + 1]; i++) {
+                costo = s->distanza[u] + g->costo[i];
+                if(limiti->costo != SENZA_LIMITE && costo > limiti->costo)
+                    continue;
+                v = indiceLimitato(s, g->arrivo[i]);
+                if(costo >= s->distanza[v])
+                    continue;
+                s->distanza[v] = costo;
+                s->nextHop[v] = nodo == start ? g->arrivo[i] : s->nextHop[u];
+                inserisciHeap(&s->coda, v, costo);
+            }
+        }
+        return;
+    }
+
+    s->frontiera[0] = u;
+    numFrontiera = 1;
+    for(giro = 1; giro <= limiti->hop && numFrontiera > 0; giro++) {
+        for(k = 0; k < numFrontiera; k++) {
+            v = s->frontiera[k];
+            s->nodoGiro[k] = s->nodo[v];
+            s->costoGiro[k] = s->distanza[v];
+            s->hopGiro[k] = s->nextHop[v];
+        }
+        fine = numFrontiera;
+        numFrontiera = 0;
+        for(k = 0; k < fine; k++) {
+            nodo = s->nodoGiro[k];
+            for(i = g->offset[nodo]; i < g->offset[nodo + 1]; i++) {
+                costo = s->costoGiro[k] + g->costo[i];
+                if(limiti->costo != SENZA_LIMITE && costo > limiti->costo)
+                    continue;
+                v = indiceLimitato(s, g->arrivo[i]);
+                if(costo >= s->distanza[v])
+                    continue;
+                s->distanza[v] = costo;
+                s->nextHop[v] = nodo == start ? g->arrivo[i] : s->hopGiro[k];
+                if(s->giro[v] != giro) {
+                    s->giro[v] = giro;
+                    s->frontiera[numFrontiera++] = v;
+                }
+            }
+        }
+    }
+    /* Destinazioni in ordine di costo: chiave (costo << 32) | indice */
+    chiavi = (unsigned long long *)malloc(s->numVisitati * sizeof(unsigned long long));
+    for(k = 0; k < s->numVisitati; k++)
+        chiavi[k] = ((unsigned long long)((long long)s->distanza[k] - INT_MIN) << 32) | (unsigned int)k;
+    qsort(chiavi, s->numVisitati, sizeof(unsigned long long), confrontaChiavi);
+    s->numRisultati = limiti->numero != SENZA_LIMITE && limiti->numero < s->numVisitati ? limiti->numero : s->numVisitati;
+    for(k = 0; k < s->numRisultati; k++)
+        s->ordine[k] = (int)(chiavi[k] & 0xffffffffu);
+    free(chiavi);
+}
+
+/*
+ * Funzione che scrive nel buffer le righe "nextHop; destinazione; costo"
+ * di una ricerca limitata, come scriviRighe
+ *
+ * @param b buffer
+ * @param t nomi dei router
+ * @param s stato con la tabella parziale
+ */
+void scriviRigheLimitate(struct buffer *b, const struct tabellaNomi *t, const struct statoLimitato *s) {
+    int i, k;
+
+    for(i = 0; i < s->numRisultati; i++) {
+        k = s->ordine[i];
+        aggiungiStringa(b, nomeIn(t, s->nextHop[k]));
+        aggiungiStringa(b, "; ");
+        aggiungiStringa(b, nomeIn(t, s->nodo[k]));
+        aggiungiStringa(b, "; ");
+        aggiungiIntero(b, s->distanza[k]);
+        aggiungiStringa(b, "\n");
+    }
+}
+
+/*
+ * Funzione chiamata dalle riparazioni degli alberi: la destinazione nodo
+ * della sorgente va ricontrollata alla prossima scrittura dei delta
+ */
+void segnaFib(int sorgente, int nodo) {
+    struct fibSorgente *f;
+
+    if(!fib.attiva || sorgente >= fib.numSorgenti)
+        return;
+    f = &fib.perSorgente[sorgente];
+    if(f->tutto || f->costo == NULL)
+        return;
+    if(nodo >= f->numNodi) {
+        f->tutto = true;
+        return;
+    }
+    if(!f->segnato[nodo]) {
+        f->segnato[nodo] = 1;
+        f->sporchi[f->numSporchi++] = nodo;
+    }
+}
+
+/*
+ * Funzione chiamata quando l'albero di una sorgente viene ricalcolato da
+ * zero: tutte le sue destinazioni vanno ricontrollate
+ */
+void segnaFibTutto(int sorgente) {
+    if(fib.attiva && sorgente < fib.numSorgenti)
+        fib.perSorgente[sorgente].tutto = true;
+}
+
+/*
+ * Funzione che allarga la FIB di una sorgente a numNodi destinazioni, le
+ * nuove non sono nella tabella. La sorgente va ricontrollata tutta perché
+ * le destinazioni nuove non potevano essere segnate.
+ */
+void allargaFib(struct fibSorgente *f, int numNodi) {
+    int i;
+
+    f->nextHop = (int *)realloc(f->nextHop, numNodi * sizeof(int));
+    f->costo = (int *)realloc(f->costo, numNodi * sizeof(int));
+    f->sporchi = (int *)realloc(f->sporchi, numNodi * sizeof(int));
+    f->segnato = (unsigned char *)realloc(f->segnato, numNodi);
+    for(i = f->numNodi; i < numNodi; i++) {
+        f->nextHop[i] = -1;
+        f->costo[i] = INT_MAX;
+    }
+    memset(f->segnato, 0, numNodi);
+    f->numSporchi = 0;
+    f->numNodi = numNodi;
+    f->tutto = true;
+}
+
+/*
+ * Funzione che scrive nel buffer una riga cambiata della tabella di una
+ * sorgente (o, con tipo DELTA_SORGENTE, l'inizio delle righe della
+ * sorgente destinazione). Nel formato testo: "+ nextHop; destinazione;
+ * costo" per le aggiunte, "~ ..." per le modifiche e "- destinazione" per
+ * i ritiri.
+ *
+ * @param b buffer
+ * @param tipo DELTA_SORGENTE, DELTA_AGGIUNTA, DELTA_MODIFICA o DELTA_RITIRO
+ * @param destinazione ID della destinazione
+ * @param nextHop nuovo next hop (solo aggiunte e modifiche)
+ * @param costo nuovo costo (solo aggiunte e modifiche)
+ */
+void scriviRigaDelta(struct buffer *b, int tipo, int destinazione, int nextHop, int costo) {
+    int valori[3] = {destinazione, nextHop, costo};
+    int numValori = tipo == DELTA_RITIRO || tipo == DELTA_SORGENTE ? 1 : 3;
+
+    if(fib.formato == FIB_BINARIO) {
+        riservaBuffer(b, 1 + sizeof(valori));
+        b->dati[b->usati++] = (char)tipo;
+        memcpy(b->dati + b->usati, valori, numValori * sizeof(int));
+        b->usati += numValori * sizeof(int);
+        return;
+    }
+    if(tipo == DELTA_SORGENTE) {
+        aggiungiStringa(b, "Delta di ");
+        aggiungiStringa(b, nomeNodo(destinazione));
+        aggiungiStringa(b, ":\n");
+        return;
+    }
+    aggiungiStringa(b, tipo == DELTA_AGGIUNTA ? "+ " : tipo == DELTA_MODIFICA ? "~ " : "- ");
+    if(tipo != DELTA_RITIRO) {
+        aggiungiStringa(b, nomeNodo(nextHop));
+        aggiungiStringa(b, "; ");
+    }
+    aggiungiStringa(b, nomeNodo(destinazione));
+    if(tipo != DELTA_RITIRO) {
+        aggiungiStringa(b, "; ");
+        aggiungiIntero(b, costo);
+    }
+    aggiungiStringa(b, "\n");
+}
+
+/*
+ * Funzione che scrive su fib.output, in una sola passata su tutti i router,
+ * le righe delle tabelle cambiate dall'ultima scrittura e aggiorna la FIB.
+ * Per ogni sorgente si ricontrollano solo le destinazioni segnate dalle
+ * riparazioni incrementali degli alberi (tutte se l'albero è stato
+ * ricalcolato da zero), quindi l'output e il confronto sono proporzionali
+ * alle righe cambiate. La prima scrittura di una sorgente contiene tutta la
+ * tabella, come aggiunte.
+ *
+ * @return numero di righe cambiate
+ */
+long long scriviDeltaFib() {
+    const struct csr *g = aggiornaCSR();
+    struct buffer testo = {NULL, 0, 0};
+    struct fibSorgente *f;
+    struct alberoSPF *a;
+    long long righe = 0;
+    int s, i, d, numDestinazioni, righeSorgente, nextHop, costo, lunghezza;
+
+    if(fib.numSorgenti < g->numNodi) {
+        fib.perSorgente = (struct fibSorgente *)realloc(fib.perSorgente, g->numNodi * sizeof(struct fibSorgente));
+        memset(fib.perSorgente + fib.numSorgenti, 0, (g->numNodi - fib.numSorgenti) * sizeof(struct fibSorgente));
+        fib.numSorgenti = g->numNodi;
+    }
+    /* Nel formato binario i router sono ID, i nomi nuovi vengono scritti prima */
+    if(fib.formato == FIB_BINARIO) {
+        for(; fib.nomiScritti < nomi.numNomi; fib.nomiScritti++) {
+            lunghezza = (int)strlen(nomeNodo(fib.nomiScritti));
+            riservaBuffer(&testo, 1 + 2 * sizeof(int) + lunghezza);
+            testo.dati[testo.usati++] = DELTA_NOME;
+            memcpy(testo.dati + testo.usati, &fib.nomiScritti, sizeof(int));
+            memcpy(testo.dati + testo.usati + sizeof(int), &lunghezza, sizeof(int));
+            memcpy(testo.dati + testo.usati + 2 * sizeof(int), nomeNodo(fib.nomiScritti), lunghezza);
+            testo.usati += 2 * sizeof(int) + lunghezza;
+        }
+    }
+
+    for(s = 0; s < g->numNodi; s++) {
+        f = &fib.perSorgente[s];
+        if(f->costo == NULL && !containsStart(s))
+            continue;
+        /* L'albero è aggiornato in modo incrementale se era in cache */
+        a = alberoPerSorgente(s);
+        if(f->numNodi < g->numNodi)
+            allargaFib(f, g->numNodi);
+        righeSorgente = 0;
+        numDestinazioni = f->tutto ? g->numNodi : f->numSporchi;
+        for(i = 0; i < numDestinazioni; i++) {
+            d = f->tutto ? i : f->sporchi[i];
+            f->segnato[d] = 0;
+            nextHop = a->stato.distanza[d] == INT_MAX ? -1 : a->stato.nextHop[d];
+            costo = a->stato.distanza[d];
+            if(nextHop == f->nextHop[d] && costo == f->costo[d])
+                continue;
+            if(righeSorgente++ == 0)
+                scriviRigaDelta(&testo, DELTA_SORGENTE, s, 0, 0);
+            scriviRigaDelta(&testo, nextHop == -1 ? DELTA_RITIRO : f->nextHop[d] == -1 ? DELTA_AGGIUNTA : DELTA_MODIFICA,
+                            d, nextHop, costo);
+            f->nextHop[d] = nextHop;
+            f->costo[d] = costo;
+        }
+        f->numSporchi = 0;
+        f->tutto = false;
+        righe += righeSorgente;
+        if(righeSorgente > 0 && fib.formato == FIB_TESTO)
+            aggiungiStringa(&testo, "\n");
+        /* L'output viene scritto a blocchi grandi */
+        if(testo.usati > (1 << 20)) {
+            fwrite(testo.dati, 1, testo.usati, fib.output);
+            fib.byte += testo.usati;
+            testo.usati = 0;
+        }
+    }
+
+    if(fib.formato == FIB_BINARIO) {
+        riservaBuffer(&testo, 1 + sizeof(int));
+        testo.dati[testo.usati++] = DELTA_FINE;
+        lunghezza = (int)righe;
+        memcpy(testo.dati + testo.usati, &lunghezza, sizeof(int));
+        testo.usati += sizeof(int);
+    }
+    else {
+        aggiungiStringa(&testo, "Fine delta: ");
+        aggiungiIntero(&testo, (int)righe);
+        aggiungiStringa(&testo, " righe\n\n");
+    }
+    fwrite(testo.dati, 1, testo.usati, fib.output);
+    fflush(fib.output);
+    fib.byte += testo.usati;
+    fib.righe += righe;
+    free(testo.dati);
+    return righe;
+}
+
+/*
+ * Funzione che porta la FIB ai nuovi ID dopo una rinumerazione dei router.
+ * Nel formato binario i nomi vengono scritti di nuovo con i nuovi ID.
+ *
+ * @param nuovo nuovo[id] = nuovo ID del router id
+ */
+void rinumeraFib(const int *nuovo) {
+    struct fibSorgente *perSorgente, *f, *n;
+    int s, d;
+
+    if(!fib.attiva || fib.numSorgenti == 0)
+        return;
+    perSorgente = (struct fibSorgente *)calloc(nomi.numNomi, sizeof(struct fibSorgente));
+    for(s = 0; s < fib.numSorgenti; s++) {
+        f = &fib.perSorgente[s];
+        if(f->costo == NULL)
+            continue;
+        n = &perSorgente[nuovo[s]];
+        allargaFib(n, nomi.numNomi);
+        for(d = 0; d < f->numNodi; d++) {
+            n->nextHop[nuovo[d]] = f->nextHop[d] == -1 ? -1 : nuovo[f->nextHop[d]];
+            n->costo[nuovo[d]] = f->costo[d];
+        }
+        free(f->nextHop);
+        free(f->costo);
+        free(f->sporchi);
+        free(f->segnato);
+    }
+    free(fib.perSorgente);
+    fib.perSorgente = perSorgente;
+    fib.numSorgenti = nomi.numNomi;
+    fib.nomiScritti = 0;
+}
+
+/*
+ * Modalità per i delta delle tabelle, senza menu:
+ * ./dijkstra --delta-fib [-b] [-o output] [-s snapshot] file... < modifiche
+ * Scrive le tabelle di tutti i router, poi legge da standard input una
+ * modifica per riga:
+ * AGGIUNGI R1 R2 c   link nei due versi, come nel menu
+ * RIMUOVI R1 R2      solo il verso R1 -> R2, come nel menu
+ * COSTO R1 R2 c      nuovo costo del link R1 -> R2
+ * CARICA file        aggiunge le connessioni del file
+ * DELTA              scrive i delta delle modifiche lette finora
+ * Alla fine dell'input vengono scritti gli ultimi delta. Con -b l'output è
+ * binario (record DELTA_*). Gli alberi di tutti i router restano in cache,
+ * senza limite di memoria salvo --cache-mb N, e vengono riparati ad ogni
+ * modifica. Su stderr vengono scritte righe e byte di ogni scrittura.
+ *
+ * @param argc numero di argomenti dopo --delta-fib
+ * @param argv argomenti dopo --delta-fib
+ * @return codice di uscita del programma
+ */
+int modalitaDeltaFib(int argc, char **argv) {
+    char *riga = NULL, *salva, *comando, *a, *b, *c;
+    size_t capacita = 0;
+    const char *nomeOutput = NULL;
+    int i, idPartenza, idArrivo, costo, vecchioCosto, numRiga = 0, errori = 0;
+    long long righe, byte;
+    double inizio;
+    bool fine;
+
+    fib.formato = FIB_TESTO;
+    cache.budget = (size_t)-1;
+    for(i = 0; i < argc; i++) {
+        if(strcmp(argv[i], "-b") == 0)
+            fib.formato = FIB_BINARIO;
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            nomeOutput = argv[++i];
+        else if(strcmp(argv[i], "--cache-mb") == 0 && i + 1 < argc)
+            cache.budget = (size_t)atoi(argv[++i]) << 20;
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if(!caricaSnapshot(argv[++i])) {
+                fprintf(stderr, "Impossibile caricare lo snapshot %s\n", argv[i]);
+                return (EXIT_FAILURE);
+            }
+        }
+        else if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    fib.output = nomeOutput != NULL ? fopen(nomeOutput, "wb") : stdout;
+    if(fib.output == NULL) {
+        fprintf(stderr, "Impossibile creare il file %s\n", nomeOutput);
+        return (EXIT_FAILURE);
+    }
+    fib.attiva = true;
+
+    inizio = secondi();
+    righe = scriviDeltaFib();
+    fprintf(stderr, "Tabelle iniziali: %lld righe, %lld byte, %.3f s\n", righe, fib.byte, secondi() - inizio);
+    for(;;) {
+        fine = getline(&riga, &capacita, stdin) == -1;
+        numRiga++;
+        comando = fine ? NULL : strtok_r(riga, " \t\r\n", &salva);
+        if(fine || (comando != NULL && strcmp(comando, "DELTA") == 0)) {
+            byte = fib.byte;
+            inizio = secondi();
+            righe = scriviDeltaFib();
+            fprintf(stderr, "Delta: %lld righe, %lld byte, %.3f s\n", righe, fib.byte - byte, secondi() - inizio);
+            if(fine)
+                break;
+            continue;
+        }
+        if(comando == NULL)
+            continue;
+        a = strtok_r(NULL, " \t\r\n", &salva);
+        b = strtok_r(NULL, " \t\r\n", &salva);
+        c = strtok_r(NULL, " \t\r\n", &salva);
+        idPartenza = a != NULL ? cercaNome(a) : -1;
+        idArrivo = b != NULL ? cercaNome(b) : -1;
+        if(strcmp(comando, "AGGIUNGI") == 0 && c != NULL && atoi(c) >= 0 && (idPartenza < 0 || idArrivo < 0 || contaArco(idPartenza, idArrivo) == 0)) {
+            costo = atoi(c);
+            idPartenza = internaNome(a);
+            idArrivo = internaNome(b);
+            inserisciArco(idPartenza, idArrivo, costo);
+            aggiornaAlberi(idPartenza, idArrivo, INT_MAX, costo);
+            inserisciArco(idArrivo, idPartenza, costo);
+            aggiornaAlberi(idArrivo, idPartenza, INT_MAX, costo);
+        }
+        else if(strcmp(comando, "RIMUOVI") == 0 && idPartenza >= 0 && idArrivo >= 0
+                && rimuoviArco(idPartenza, idArrivo, &vecchioCosto)) {
+            aggiornaAlberi(idPartenza, idArrivo, vecchioCosto, INT_MAX);
+        }
+        else if(strcmp(comando, "COSTO") == 0 && c != NULL && atoi(c) >= 0 && idPartenza >= 0 && idArrivo >= 0
+                && modificaCostoArco(idPartenza, idArrivo, atoi(c), &vecchioCosto)) {
+            aggiornaAlberi(idPartenza, idArrivo, vecchioCosto, atoi(c));
+        }
+        else if(strcmp(comando, "CARICA") == 0 && a != NULL && caricaFile(a)) {
+            riordinaRete(ordineNodi);
+        }
+        else {
+            fprintf(stderr, "Riga %d: modifica non valida\n", numRiga);
+            errori++;
+        }
+    }
+    free(riga);
+    if(fib.output != stdout)
+        fclose(fib.output);
+    return errori == 0 ? (EXIT_SUCCESS) : (EXIT_FAILURE);
+}
+
+/*
+ * Funzione che calcola i bit necessari per i valori da 0 a valore
+ *
+ * @param valore valore massimo da rappresentare
+ * @return numero di bit, almeno 1
+ */
+int bitNecessari(unsigned long long valore) {
+    int bit = 1;
+
+    while(bit < 64 && (valore >> bit) != 0)
+        bit++;
+    return bit;
+}
+
+/*
+ * Funzione che legge un campo di bit (al massimo 32) che può stare a
+ * cavallo di due parole da 64 bit
+ *
+ * @param parole inizio della riga
+ * @param posizione primo bit del campo
+ * @param bit larghezza del campo
+ * @return valore del campo
+ */
+unsigned long long leggiCampo(const unsigned long long *parole, unsigned long long posizione, int bit) {
+    const unsigned long long *p = parole + (posizione >> 6);
+    int spostamento = (int)(posizione & 63);
+    unsigned long long valore = p[0] >> spostamento;
+
+    if(spostamento + bit > 64)
+        valore |= p[1] << (64 - spostamento);
+    return valore & ((1ull << bit) - 1);
+}
+
+/*
+ * Funzione che scrive un campo di bit (al massimo 32), lasciando invariati
+ * gli altri bit delle parole
+ *
+ * @param parole inizio della riga
+ * @param posizione primo bit del campo
+ * @param bit larghezza del campo
+ * @param valore valore da scrivere, troncato a bit bit
+ */
+void scriviCampo(unsigned long long *parole, unsigned long long posizione, int bit, unsigned long long valore) {
+    unsigned long long *p = parole + (posizione >> 6), maschera = (1ull << bit) - 1;
+    int spostamento = (int)(posizione & 63);
+
+    valore &= maschera;
+    p[0] = (p[0] & ~(maschera << spostamento)) | (valore << spostamento);
+    if(spostamento + bit > 64)
+        p[1] = (p[1] & ~(maschera >> (64 - spostamento))) | (valore >> (64 - spostamento));
+}
+
+/*
+ * Funzione eseguita da ogni thread che costruisce la FIB compatta: prende
+ * lavoro->corsie sorgenti alla volta, ne calcola le tabelle e scrive le loro
+ * righe. Le righe iniziano su parole diverse, quindi i thread non scrivono
+ * mai nella stessa parola.
+ *
+ * @param argomento struct lavoroFibCompatta condivisa
+ */
+void *threadFibCompatta(void *argomento) {
+    struct lavoroFibCompatta *lavoro = (struct lavoroFibCompatta *)argomento;
+    const struct csr *g = lavoro->g;
+    struct fibCompatta *f = lavoro->f;
+    struct statoTabella stati[NUM_CORSIE];
+    struct statoMultiplo multiplo;
+    unsigned long long *riga, *rigaCosto;
+    long long costoMinimo = LLONG_MAX, costoMassimo = LLONG_MIN, costo;
+    int sorgenti[NUM_CORSIE], *posizione, k, l, i, numero, s, d;
+
+    /* posizione[v] = posizione + 1 del primo arco verso v della sorgente */
+    posizione = (int *)calloc(g->numNodi + 1, sizeof(int));
+    for(l = 0; l < lavoro->corsie; l++)
+        creaStato(&stati[l], g->numNodi);
+    if(lavoro->corsie > 1)
+        creaStatoMultiplo(&multiplo, g->numNodi);
+    for(;;) {
+        pthread_mutex_lock(&lavoro->mutex);
+        k = lavoro->prossima;
+        lavoro->prossima += lavoro->corsie;
+        pthread_mutex_unlock(&lavoro->mutex);
+        if(k >= g->numNodi)
+            break;
+        numero = g->numNodi - k < lavoro->corsie ? g->numNodi - k : lavoro->corsie;
+        for(l = 0; l < numero; l++)
+            sorgenti[l] = k + l;
+        if(lavoro->corsie > 1)
+            calcolaTabelleMultiple(g, sorgenti, numero, &multiplo, stati);
+        else
+            calcolaTabella(g, k, &stati[0]);
+
+        for(l = 0; l < numero; l++) {
+            s = sorgenti[l];
+            for(i = g->offset[s + 1] - 1; i >= g->offset[s]; i--)
+                posizione[g->arrivo[i]] = i - g->offset[s] + 1;
+            riga = f->vicini + (size_t)s * f->paroleVicino;
+            rigaCosto = f->costi + (size_t)s * f->paroleCosto;
+            for(i = 0; i < stati[l].numRaggiunti; i++) {
+                d = stati[l].ordine[i];
+                if(d == s)
+                    continue;
+                scriviCampo(riga, (unsigned long long)d * f->bitVicino, f->bitVicino, posizione[stati[l].nextHop[d]]);
+                if(f->bitCosto > 0) {
+                    costo = stati[l].distanza[d];
+                    scriviCampo(rigaCosto, (unsigned long long)d * f->bitCosto, f->bitCosto, (unsigned long long)(costo - f->costoBase));
+                    if(costo < costoMinimo)
+                        costoMinimo = costo;
+                    if(costo > costoMassimo)
+                        costoMassimo = costo;
+                }
+            }
+            for(i = g->offset[s]; i < g->offset[s + 1]; i++)
+                posizione[g->arrivo[i]] = 0;
+        }
+    }
+    free(posizione);
+    for(l = 0; l < lavoro->corsie; l++)
+        liberaStato(&stati[l]);
+    if(lavoro->corsie > 1)
+        liberaStatoMultiplo(&multiplo);
+    pthread_mutex_lock(&lavoro->mutex);
+    if(costoMinimo < lavoro->costoMinimo)
+        lavoro->costoMinimo = costoMinimo;
+    if(costoMassimo > lavoro->costoMassimo)
+        lavoro->costoMassimo = costoMassimo;
+    pthread_mutex_unlock(&lavoro->mutex);
+    return NULL;
+}
+
+/*
+ * Funzione che restringe i campi dei costi ai costi trovati davvero. Il
+ * nuovo campo di ogni coppia non sta mai dopo quello vecchio e non va oltre
+ * l'inizio del vecchio campo successivo, quindi le righe possono essere
+ * riscritte sul posto, dalla prima coppia all'ultima.
+ *
+ * @param f FIB compatta con i costi appena calcolati
+ * @param costoMinimo costo minimo trovato (maggiore di costoMassimo se nessuno)
+ * @param costoMassimo costo massimo trovato
+ */
+void restringiCosti(struct fibCompatta *f, long long costoMinimo, long long costoMassimo) {
+    unsigned long long valore;
+    size_t paroleCosto;
+    int bitCosto, s, d;
+
+    if(costoMinimo > costoMassimo)
+        costoMinimo = costoMassimo = 0;
+    bitCosto = bitNecessari((unsigned long long)(costoMassimo - costoMinimo));
+    if(bitCosto == f->bitCosto && costoMinimo == f->costoBase)
+        return;
+    paroleCosto = ((size_t)f->numNodi * bitCosto + 63) / 64;
+    for(s = 0; s < f->numNodi; s++) {
+        for(d = 0; d < f->numNodi; d++) {
+            valore = 0;
+            if(leggiCampo(f->vicini + (size_t)s * f->paroleVicino, (unsigned long long)d * f->bitVicino, f->bitVicino) != 0)
+                valore = leggiCampo(f->costi + (size_t)s * f->paroleCosto, (unsigned long long)d * f->bitCosto, f->bitCosto)
+                         + f->costoBase - costoMinimo;
+            scriviCampo(f->costi + (size_t)s * paroleCosto, (unsigned long long)d * bitCosto, bitCosto, valore);
+        }
+    }
+    f->bitCosto = bitCosto;
+    f->costoBase = costoMinimo;
+    f->paroleCosto = paroleCosto;
+}
+
+/*
+ * Funzione che costruisce il file della FIB compatta della rete attuale.
+ * Il file viene mappato in scrittura e riempito dai thread, così le
+ * tabelle non devono stare tutte in memoria. Prima del calcolo i costi
+ * sono limitati solo da numNodi - 1 archi al costo massimo: alla fine i
+ * campi vengono ristretti e il file accorciato.
+ *
+ * @param nomeFile file da creare
+ * @param costi true per salvare anche i costi
+ * @param numThread numero di thread da usare
+ * @return false se il file non può essere scritto
+ */
+bool costruisciFibCompatta(const char *nomeFile, bool costi, int numThread) {
+    const struct csr *g = aggiornaCSRCompatto();
+    struct lavoroFibCompatta lavoro;
+    struct intestazioneFib in;
+    struct fibCompatta f;
+    long long costoMassimo;
+    size_t dimensione;
+    pthread_t *thread;
+    char *dati;
+    int fd, i, gradoMassimo = 0;
+
+    for(i = 0; i < g->numNodi; i++)
+        if(g->offset[i + 1] - g->offset[i] > gradoMassimo)
+            gradoMassimo = g->offset[i + 1] - g->offset[i];
+    memset(&f, 0, sizeof(f));
+    f.numNodi = g->numNodi;
+    f.bitVicino = bitNecessari(gradoMassimo);
+    f.paroleVicino = ((size_t)g->numNodi * f.bitVicino + 63) / 64;
+    if(costi && g->numNodi > 0) {
+        costoMassimo = (long long)(g->numNodi - 1) * g->costoMassimo;
+        if(costoMassimo > INT_MAX)
+            costoMassimo = INT_MAX;
+        f.bitCosto = bitNecessari((unsigned long long)(costoMassimo - f.costoBase));
+        f.paroleCosto = ((size_t)g->numNodi * f.bitCosto + 63) / 64;
+    }
+    dimensione = sizeof(in) + (size_t)g->numNodi * (f.paroleVicino + f.paroleCosto) * sizeof(unsigned long long);
+    fd = open(nomeFile, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+        return false;
+    if(ftruncate(fd, dimensione) != 0) {
+        close(fd);
+        return false;
+    }
+    dati = (char *)mmap(NULL, dimensione, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(dati == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    f.vicini = (unsigned long long *)(dati + sizeof(in));
+    f.costi = f.vicini + (size_t)g->numNodi * f.paroleVicino;
+
+    lavoro.g = g;
+    lavoro.f = &f;
+    lavoro.corsie = corsieBatch < 1 ? 1 : corsieBatch > NUM_CORSIE ? NUM_CORSIE : corsieBatch;
+    lavoro.prossima = 0;
+    lavoro.costoMinimo = LLONG_MAX;
+    lavoro.costoMassimo = LLONG_MIN;
+    pthread_mutex_init(&lavoro.mutex, NULL);
+    if(numThread < 1)
+        numThread = 1;
+    thread = (pthread_t *)malloc(numThread * sizeof(pthread_t));
+    for(i = 0; i < numThread; i++)
+        pthread_create(&thread[i], NULL, threadFibCompatta, &lavoro);
+    for(i = 0; i < numThread; i++)
+        pthread_join(thread[i], NULL);
+    free(thread);
+    pthread_mutex_destroy(&lavoro.mutex);
+    if(f.bitCosto > 0)
+        restringiCosti(&f, lavoro.costoMinimo, lavoro.costoMassimo);
+
+    memset(&in, 0, sizeof(in));
+    memcpy(in.magic, MAGIC_FIB, 8);
+    in.versione = VERSIONE_FIB;
+    in.ordineByte = ORDINE_BYTE;
+    in.impronta = improntaTopologia();
+    in.numNodi = g->numNodi;
+    in.bitVicino = f.bitVicino;
+    in.bitCosto = f.bitCosto;
+    in.costoBase = f.costoBase;
+    in.paroleVicino = f.paroleVicino;
+    in.paroleCosto = f.paroleCosto;
+    memcpy(dati, &in, sizeof(in));
+    munmap(dati, dimensione);
+    dimensione = sizeof(in) + (size_t)g->numNodi * (f.paroleVicino + f.paroleCosto) * sizeof(unsigned long long);
+    if(ftruncate(fd, dimensione) != 0) {
+        close(fd);
+        return false;
+    }
+    return close(fd) == 0;
+}
+
+/*
+ * Funzione che apre una FIB compatta costruita per la rete caricata adesso:
+ * il file viene mappato in sola lettura e le pagine vengono lette dal disco
+ * solo quando una ricerca le usa.
+ *
+ * @param nomeFile file da aprire
+ * @param costi true se servono anche i costi
+ * @return false se il file non esiste, non è valido, è di un'altra rete o
+ *         non ha i costi richiesti
+ */
+bool apriFibCompatta(const char *nomeFile, bool costi) {
+    const struct csr *g = aggiornaCSRCompatto();
+    struct intestazioneFib in;
+    struct stat info;
+    char *dati;
+    int fd;
+
+    fd = open(nomeFile, O_RDONLY);
+    if(fd < 0)
+        return false;
+    if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(in)) {
+        close(fd);
+        return false;
+    }
+    dati = (char *)mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(dati == MAP_FAILED)
+        return false;
+    memcpy(&in, dati, sizeof(in));
+    if(memcmp(in.magic, MAGIC_FIB, 8) != 0 || in.versione != VERSIONE_FIB || in.ordineByte != ORDINE_BYTE
+       || in.numNodi != (unsigned long long)g->numNodi || in.impronta != improntaTopologia()
+       || in.bitVicino < 1 || in.bitVicino > 32 || in.bitCosto > 32 || (costi && in.bitCosto == 0)
+       || sizeof(in) + in.numNodi * (in.paroleVicino + in.paroleCosto) * sizeof(unsigned long long) != (size_t)info.st_size) {
+        munmap(dati, info.st_size);
+        return false;
+    }
+    chiudiFibCompatta();
+    fibCompatta.dati = dati;
+    fibCompatta.dimensione = info.st_size;
+    fibCompatta.numNodi = (int)in.numNodi;
+    fibCompatta.bitVicino = (int)in.bitVicino;
+    fibCompatta.bitCosto = (int)in.bitCosto;
+    fibCompatta.costoBase = in.costoBase;
+    fibCompatta.paroleVicino = in.paroleVicino;
+    fibCompatta.paroleCosto = in.paroleCosto;
+    fibCompatta.vicini = (unsigned long long *)(dati + sizeof(in));
+    fibCompatta.costi = fibCompatta.vicini + in.numNodi * in.paroleVicino;
+    fibCompatta.offset = g->offset;
+    fibCompatta.arrivo = g->arrivo;
+    return true;
+}
+
+/*
+ * Funzione che chiude la FIB compatta aperta, se c'è
+ */
+void chiudiFibCompatta() {
+    if(fibCompatta.dati != NULL)
+        munmap(fibCompatta.dati, fibCompatta.dimensione);
+    memset(&fibCompatta, 0, sizeof(fibCompatta));
+}
+
+/*
+ * Funzione che cerca nella FIB compatta next hop e costo da una sorgente a
+ * una destinazione, in tempo costante
+ *
+ * @param f FIB compatta aperta
+ * @param sorgente ID del router della tabella
+ * @param destinazione ID della destinazione
+ * @param costo costo del percorso, INT_MAX se non raggiungibile o se i costi
+ *        non sono salvati
+ * @return ID del next hop, -1 se la destinazione non è raggiungibile
+ */
+int cercaFibCompatta(const struct fibCompatta *f, int sorgente, int destinazione, int *costo) {
+    unsigned long long posizione;
+
+    *costo = INT_MAX;
+    if(sorgente == destinazione) {
+        *costo = 0;
+        return sorgente;
+    }
+    posizione = leggiCampo(f->vicini + (size_t)sorgente * f->paroleVicino,
+                           (unsigned long long)destinazione * f->bitVicino, f->bitVicino);
+    if(posizione == 0)
+        return -1;
+    if(f->bitCosto > 0)
+        *costo = (int)((long long)leggiCampo(f->costi + (size_t)sorgente * f->paroleCosto,
+                                             (unsigned long long)destinazione * f->bitCosto, f->bitCosto) + f->costoBase);
+    return f->arrivo[f->offset[sorgente] + posizione - 1];
+}
+
+/*
+ * Modalità per le tabelle compatte di tutti i router, senza menu:
+ * ./dijkstra --fib-compatta rete.fib [-c] [-j thread] [-m corsie] [-n ricerche] [-s snapshot] file... < richieste
+ * Se rete.fib non è stato costruito per questa rete (o con -c non ha i
+ * costi) viene costruito, altrimenti viene solo mappato. Poi legge da
+ * standard input una coppia "R1 R2" per riga e scrive "nextHop; R2; costo"
+ * dalla tabella di R1. Con -n invece misura -n ricerche su coppie casuali e
+ * controlla i costi di qualche tabella contro Dijkstra.
+ *
+ * @param argc numero di argomenti dopo --fib-compatta
+ * @param argv argomenti dopo --fib-compatta
+ * @return codice di uscita del programma
+ */
+int modalitaFibCompatta(int argc, char **argv) {
+    const struct csr *g;
+    struct statoTabella stato;
+    struct buffer testo = {NULL, 0, 0};
+    unsigned long long seme = 1, controllo = 0;
+    char *riga = NULL, *salva, *a, *b;
+    size_t capacita = 0;
+    bool costi = false;
+    double inizio;
+    int numThread = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int ricerche = 0, i, q, partenza, arrivo, nextHop, costo, errori = 0;
+
+    for(i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-c") == 0)
+            costi = true;
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            numThread = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+            corsieBatch = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            ricerche = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if(!caricaSnapshot(argv[++i])) {
+                fprintf(stderr, "Impossibile caricare lo snapshot %s\n", argv[i]);
+                return (EXIT_FAILURE);
+            }
+        }
+        else if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    g = aggiornaCSR();
+    if(g->numNodi == 0) {
+        fprintf(stderr, "Rete vuota\n");
+        return (EXIT_FAILURE);
+    }
+    if(!apriFibCompatta(argv[0], costi)) {
+        inizio = secondi();
+        if(!costruisciFibCompatta(argv[0], costi, numThread) || !apriFibCompatta(argv[0], costi)) {
+            fprintf(stderr, "Impossibile scrivere %s\n", argv[0]);
+            return (EXIT_FAILURE);
+        }
+        fprintf(stderr, "FIB compatta costruita in %.3f s\n", secondi() - inizio);
+    }
+    fprintf(stderr, "FIB compatta: %d router, %d bit per next hop, %d bit per costo, %.1f MB (%.2f byte per riga)\n",
+            fibCompatta.numNodi, fibCompatta.bitVicino, fibCompatta.bitCosto, fibCompatta.dimensione / 1048576.0,
+            (double)fibCompatta.dimensione / ((double)g->numNodi * g->numNodi));
+
+    if(ricerche > 0) {
+        inizio = secondi();
+        for(q = 0; q < ricerche; q++) {
+            partenza = casualeTra(&seme, 0, g->numNodi - 1);
+            arrivo = casualeTra(&seme, 0, g->numNodi - 1);
+            controllo += (unsigned int)cercaFibCompatta(&fibCompatta, partenza, arrivo, &costo) + (unsigned int)costo;
+        }
+        printf("%d ricerche su %d router: %.1f ns per ricerca (controllo %llu)\n", ricerche, g->numNodi,
+               (secondi() - inizio) * 1e9 / ricerche, controllo);
+        /* Le tabelle di qualche router confrontate con Dijkstra */
+        creaStato(&stato, g->numNodi);
+        for(q = 0; q < 10; q++) {
+            partenza = casualeTra(&seme, 0, g->numNodi - 1);
+            calcolaTabella(g, partenza, &stato);
+            for(arrivo = 0; arrivo < g->numNodi; arrivo++) {
+                nextHop = cercaFibCompatta(&fibCompatta, partenza, arrivo, &costo);
+                if((nextHop < 0) != (stato.distanza[arrivo] == INT_MAX)
+                   || (fibCompatta.bitCosto > 0 && nextHop >= 0 && costo != stato.distanza[arrivo]))
+                    errori++;
+            }
+        }
+        liberaStato(&stato);
+        if(errori > 0)
+            printf("  %d righe diverse dalla tabella di Dijkstra!\n", errori);
+        chiudiFibCompatta();
+        return errori == 0 ? (EXIT_SUCCESS) : (EXIT_FAILURE);
+    }
+
+    while(getline(&riga, &capacita, stdin) != -1) {
+        a = strtok_r(riga, " \t\r\n", &salva);
+        b = a != NULL ? strtok_r(NULL, " \t\r\n", &salva) : NULL;
+        if(b == NULL)
+            continue;
+        partenza = cercaNome(a);
+        arrivo = cercaNome(b);
+        if(partenza < 0 || arrivo < 0) {
+            aggiungiStringa(&testo, "Nodo non esistente: ");
+            aggiungiStringa(&testo, partenza < 0 ? a : b);
+            aggiungiStringa(&testo, "\n");
+            errori++;
+            continue;
+        }
+        nextHop = cercaFibCompatta(&fibCompatta, partenza, arrivo, &costo);
+        if(nextHop < 0) {
+            aggiungiStringa(&testo, b);
+            aggiungiStringa(&testo, " non è raggiungibile da ");
+            aggiungiStringa(&testo, a);
+            aggiungiStringa(&testo, "\n");
+        }
+        else {
+            aggiungiStringa(&testo, nomeNodo(nextHop));
+            aggiungiStringa(&testo, "; ");
+            aggiungiStringa(&testo, b);
+            if(costo != INT_MAX) {
+                aggiungiStringa(&testo, "; ");
+                aggiungiIntero(&testo, costo);
+            }
+            aggiungiStringa(&testo, "\n");
+        }
+        svuotaBuffer(&testo, stdout, false);
+    }
+    svuotaBuffer(&testo, stdout, true);
+    free(testo.dati);
+    free(riga);
+    chiudiFibCompatta();
+    return errori == 0 ? (EXIT_SUCCESS) : (EXIT_FAILURE);
+}
+
+/*
+ * Funzione che controlla se un arco è tolto dal guasto
+ *
+ * @param gu guasto
+ * @param partenza router di partenza dell'arco
+ * @param arrivo router di arrivo dell'arco
+ * @return true se l'arco non esiste nello scenario del guasto
+ */
+bool arcoGuasto(const struct guasto *gu, int partenza, int arrivo) {
+    if(gu->arrivo == -1)
+        return partenza == gu->partenza || arrivo == gu->partenza;
+    return (partenza == gu->partenza && arrivo == gu->arrivo) || (partenza == gu->arrivo && arrivo == gu->partenza);
+}
+
+/*
+ * Funzione che valuta un guasto sull'albero di base di una sorgente senza
+ * modificarlo: solo i sottoalberi appesi agli archi guasti (o al router
+ * guasto) vengono staccati e ricalcolati nella vista, partendo dagli archi
+ * entranti che arrivano dal resto dell'albero, come in riparaAumento. Le
+ * differenze con l'albero di base vengono sommate nel guasto.
+ *
+ * @param g grafo in formato CSR con gli archi entranti
+ * @param a albero di base della sorgente
+ * @param gu guasto da valutare
+ * @param v vista del thread
+ * @return numero di nodi ricalcolati
+ */
+int valutaGuasto(const struct csr *g, const struct alberoSPF *a, struct guasto *gu, struct vistaGuasto *v) {
+    const struct statoTabella *s = &a->stato;
+    int radici[2], numRadici = 0, numSottoalbero = 0, i, j, nodo, figlio, partenza, costo, nextHop;
+
+    if(gu->arrivo == -1) {
+        /* Il guasto della sorgente non cambia le tabelle degli altri */
+        if(gu->partenza == a->sorgente)
+            return 0;
+        if(s->distanza[gu->partenza] != INT_MAX)
+            radici[numRadici++] = gu->partenza;
+    }
+    else {
+        if(s->distanza[gu->partenza] != INT_MAX && s->precedente[gu->arrivo] == gu->partenza)
+            radici[numRadici++] = gu->arrivo;
+        if(s->distanza[gu->arrivo] != INT_MAX && s->precedente[gu->partenza] == gu->arrivo)
+            radici[numRadici++] = gu->partenza;
+    }
+    if(numRadici == 0)
+        return 0;
+
+    /* Sottoalberi staccati (visita in ampiezza dei figli) */
+    if(v->turno == INT_MAX) {
+        memset(v->segno, 0, (g->numNodi + 1) * sizeof(int));
+        v->turno = 0;
+    }
+    v->turno++;
+    for(i = 0; i < numRadici; i++) {
+        v->sottoalbero[numSottoalbero++] = radici[i];
+        v->segno[radici[i]] = v->turno;
+    }
+    for(i = 0; i < numSottoalbero; i++) {
+        for(figlio = a->primoFiglio[v->sottoalbero[i]]; figlio != -1; figlio = a->fratelloSucc[figlio]) {
+            v->sottoalbero[numSottoalbero++] = figlio;
+            v->segno[figlio] = v->turno;
+        }
+    }
+
+    /* Ogni nodo staccato riparte dal miglior arco entrante che arriva da un
+       nodo rimasto attaccato, il cui costo non cambia. A parità di costo
+       viene tenuto il next hop di base, per non contare cambi inutili */
+    for(i = 0; i < numSottoalbero; i++) {
+        nodo = v->sottoalbero[i];
+        v->distanza[nodo] = INT_MAX;
+        v->nextHop[nodo] = -1;
+        for(j = g->offsetEntrata[nodo]; j < g->offsetEntrata[nodo + 1]; j++) {
+            partenza = g->partenzaEntrata[j];
+            if(v->segno[partenza] == v->turno || s->distanza[partenza] == INT_MAX || arcoGuasto(gu, partenza, nodo))
+                continue;
+            costo = s->distanza[partenza] + g->costoEntrata[j];
+            nextHop = partenza == a->sorgente ? nodo : s->nextHop[partenza];
+            if(costo < v->distanza[nodo] || (costo == v->distanza[nodo] && nextHop == s->nextHop[nodo])) {
+                v->distanza[nodo] = costo;
+                v->nextHop[nodo] = nextHop;
+            }
+        }
+        if(v->distanza[nodo] != INT_MAX)
+            inserisciHeap(&v->coda, nodo, v->distanza[nodo]);
+    }
+    while(v->coda.dimensione > 0) {
+        nodo = estraiMinimo(&v->coda);
+        for(j = g->offset[nodo]; j < g->offset[nodo + 1]; j++) {
+            figlio = g->arrivo[j];
+            if(v->segno[figlio] != v->turno || arcoGuasto(gu, nodo, figlio))
+                continue;
+            costo = v->distanza[nodo] + g->costo[j];
+            if(costo < v->distanza[figlio]) {
+                v->distanza[figlio] = costo;
+                v->nextHop[figlio] = v->nextHop[nodo];
+                inserisciHeap(&v->coda, figlio, costo);
+            }
+            else if(costo == v->distanza[figlio] && v->nextHop[nodo] == s->nextHop[figlio] && v->coda.posizione[figlio] != -1)
+                v->nextHop[figlio] = v->nextHop[nodo];
+        }
+    }
+
+    /* Confronto con l'albero di base, il router guasto non è una destinazione */
+    for(i = 0; i < numSottoalbero; i++) {
+        nodo = v->sottoalbero[i];
+        if(gu->arrivo == -1 && nodo == gu->partenza)
+            continue;
+        if(v->distanza[nodo] == INT_MAX) {
+            gu->irraggiungibili++;
+            gu->cambiate++;
+            continue;
+        }
+        if(v->distanza[nodo] > s->distanza[nodo]) {
+            costo = v->distanza[nodo] - s->distanza[nodo];
+            gu->aumentate++;
+            gu->aumentoTotale += costo;
+            if(costo > gu->aumentoMassimo)
+                gu->aumentoMassimo = costo;
+        }
+        if(v->distanza[nodo] != s->distanza[nodo] || v->nextHop[nodo] != s->nextHop[nodo])
+            gu->cambiate++;
+    }
+    return numSottoalbero;
+}
+
+/*
+ * Funzione eseguita da ogni thread dell'analisi di resilienza: prende un
+ * guasto alla volta e lo valuta sugli alberi di tutte le sorgenti con la
+ * propria vista, quindi ogni guasto è scritto da un solo thread.
+ *
+ * @param argomento struct lavoroResilienza condivisa
+ */
+void *threadResilienza(void *argomento) {
+    struct lavoroResilienza *lavoro = (struct lavoroResilienza *)argomento;
+    const struct csr *g = lavoro->g;
+    struct vistaGuasto v;
+    long long toccati = 0;
+    int k, i;
+
+    v.distanza = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    v.nextHop = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    v.segno = (int *)calloc(g->numNodi + 1, sizeof(int));
+    v.sottoalbero = (int *)malloc((g->numNodi + 1) * sizeof(int));
+    v.turno = 0;
+    creaHeap(&v.coda, g->numNodi, NULL);
+    for(;;) {
+        pthread_mutex_lock(&lavoro->mutex);
+        k = lavoro->prossimo++;
+        pthread_mutex_unlock(&lavoro->mutex);
+        if(k >= lavoro->numGuasti)
+            break;
+        for(i = 0; i < lavoro->numAlberi; i++)
+            toccati += valutaGuasto(g, lavoro->alberi[i], &lavoro->guasti[k], &v);
+    }
+    free(v.distanza);
+    free(v.nextHop);
+    free(v.segno);
+    free(v.sottoalbero);
+    liberaHeap(&v.coda);
+    pthread_mutex_lock(&lavoro->mutex);
+    lavoro->toccati += toccati;
+    pthread_mutex_unlock(&lavoro->mutex);
+    return NULL;
+}
+
+/*
+ * Funzione che legge la lista dei guasti, uno per riga: "R1 R2" per il
+ * link tra R1 e R2, "R" per il router R con tutti i suoi link
+ *
+ * @param nomeFile file con i guasti
+ * @param guasti vettore allocato con i guasti letti
+ * @return numero di guasti, -1 se il file non esiste o ha righe non valide
+ */
+int leggiGuasti(const char *nomeFile, struct guasto **guasti) {
+    FILE *fl = fopen(nomeFile, "r");
+    char *riga = NULL, *salva, *a, *b;
+    size_t capacita = 0;
+    int numGuasti = 0, capacitaGuasti = 0, numRiga = 0, errori = 0;
+
+    *guasti = NULL;
+    if(fl == NULL)
+        return -1;
+    while(getline(&riga, &capacita, fl) != -1) {
+        numRiga++;
+        a = strtok_r(riga, " \t\r\n", &salva);
+        if(a == NULL || a[0] == '#')
+            continue;
+        b = strtok_r(NULL, " \t\r\n", &salva);
+        if(cercaNome(a) < 0 || (b != NULL && (cercaNome(b) < 0 || cercaNome(b) == cercaNome(a)))) {
+            fprintf(stderr, "%s, riga %d: guasto non valido\n", nomeFile, numRiga);
+            errori++;
+            continue;
+        }
+        if(numGuasti == capacitaGuasti) {
+            capacitaGuasti = capacitaGuasti == 0 ? 16 : 2 * capacitaGuasti;
+            *guasti = (struct guasto *)realloc(*guasti, capacitaGuasti * sizeof(struct guasto));
+        }
+        memset(&(*guasti)[numGuasti], 0, sizeof(struct guasto));
+        (*guasti)[numGuasti].partenza = cercaNome(a);
+        (*guasti)[numGuasti].arrivo = b != NULL ? cercaNome(b) : -1;
+        numGuasti++;
+    }
+    free(riga);
+    fclose(fl);
+    return errori == 0 ? numGuasti : -1;
+}
+
+/*
+ * Funzione che prepara un guasto per ogni link della rete: le coppie di
+ * router collegati vengono prese una volta sola, in qualunque verso
+ *
+ * @param g grafo in formato CSR
+ * @param guasti vettore allocato con i guasti
+ * @return numero di guasti
+ */
+int tuttiLink(const struct csr *g, struct guasto **guasti) {
+    unsigned long long *chiavi = (unsigned long long *)malloc((g->numArchi + 1) * sizeof(unsigned long long));
+    int numChiavi = 0, numGuasti = 0, i, j, minore, maggiore;
+
+    for(i = 0; i < g->numNodi; i++) {
+        for(j = g->offset[i]; j < g->offset[i + 1]; j++) {
+            if(g->arrivo[j] == i)
+                continue;
+            minore = i < g->arrivo[j] ? i : g->arrivo[j];
+            maggiore = i < g->arrivo[j] ? g->arrivo[j] : i;
+            chiavi[numChiavi++] = (unsigned long long)minore << 32 | (unsigned int)maggiore;
+        }
+    }
+    qsort(chiavi, numChiavi, sizeof(unsigned long long), confrontaChiavi);
+    *guasti = (struct guasto *)calloc(numChiavi + 1, sizeof(struct guasto));
+    for(i = 0; i < numChiavi; i++) {
+        if(i > 0 && chiavi[i] == chiavi[i - 1])
+            continue;
+        (*guasti)[numGuasti].partenza = (int)(chiavi[i] >> 32);
+        (*guasti)[numGuasti].arrivo = (int)(chiavi[i] & 0xffffffffu);
+        numGuasti++;
+    }
+    free(chiavi);
+    return numGuasti;
+}
+
+/*
+ * Funzione che scrive nel buffer la riga dei risultati di un guasto
+ */
+void scriviGuasto(struct buffer *b, const struct guasto *gu) {
+    char numeri[128];
+
+    aggiungiStringa(b, nomeNodo(gu->partenza));
+    if(gu->arrivo != -1) {
+        aggiungiStringa(b, " - ");
+        aggiungiStringa(b, nomeNodo(gu->arrivo));
+    }
+    else
+        aggiungiStringa(b, " (router)");
+    /* I contatori sommano le coppie di tutte le tabelle e possono superare INT_MAX */
+    snprintf(numeri, sizeof(numeri), ": %lld destinazioni cambiate, %lld costi aumentati", gu->cambiate, gu->aumentate);
+    aggiungiStringa(b, numeri);
+    if(gu->aumentate > 0) {
+        snprintf(numeri, sizeof(numeri), " (totale +%lld, massimo +%d)", gu->aumentoTotale, gu->aumentoMassimo);
+        aggiungiStringa(b, numeri);
+    }
+    snprintf(numeri, sizeof(numeri), ", %lld irraggiungibili", gu->irraggiungibili);
+    aggiungiStringa(b, numeri);
+    aggiungiStringa(b, gu->irraggiungibili > 0 ? ", rete partizionata\n" : "\n");
+}
+
+/*
+ * Modalità di analisi dei guasti, senza menu:
+ * ./dijkstra --resilienza [-f guasti.txt] [-j thread] [-r R1,R2,...] [-s snapshot] file...
+ * Per ogni guasto della lista (default: ogni link della rete) scrive quante
+ * destinazioni cambiano next hop o costo, quanti costi aumentano e quante
+ * destinazioni diventano irraggiungibili, sommando le tabelle di tutti i
+ * router (o di quelli passati con -r). Gli alberi di base vengono calcolati
+ * una volta sola, poi i guasti vengono valutati in parallelo senza toccare
+ * la rete, ricalcolando solo i sottoalberi che usavano il link o il router
+ * guasto.
+ *
+ * @param argc numero di argomenti dopo --resilienza
+ * @param argv argomenti dopo --resilienza
+ * @return codice di uscita del programma
+ */
+int modalitaResilienza(int argc, char **argv) {
+    struct lavoroResilienza lavoro;
+    struct buffer testo = {NULL, 0, 0};
+    const struct guasto *peggiore = NULL;
+    const char *fileGuasti = NULL;
+    char *router = NULL, *nome;
+    pthread_t *thread;
+    double inizio, tempoBase;
+    int numThread = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int i, id, partizioni = 0;
+
+    for(i = 0; i < argc; i++) {
+        if(strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            fileGuasti = argv[++i];
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            numThread = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            router = argv[++i];
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if(!caricaSnapshot(argv[++i])) {
+                fprintf(stderr, "Impossibile caricare lo snapshot %s\n", argv[i]);
+                return (EXIT_FAILURE);
+            }
+        }
+        else if(!caricaFile(argv[i])) {
+            fprintf(stderr, "Impossibile aprire il file %s\n", argv[i]);
+            return (EXIT_FAILURE);
+        }
+    }
+    if(numThread < 1)
+        numThread = 1;
+    lavoro.g = aggiornaEntrate();
+    lavoro.numGuasti = fileGuasti != NULL ? leggiGuasti(fileGuasti, &lavoro.guasti) : tuttiLink(lavoro.g, &lavoro.guasti);
+    if(lavoro.numGuasti < 0) {
+        fprintf(stderr, "Impossibile leggere i guasti da %s\n", fileGuasti);
+        free(lavoro.guasti);
+        return (EXIT_FAILURE);
+    }
+
+    /* Alberi di base dalla cache, senza limite di memoria perché i thread
+       li usano tutti fino alla fine */
+    inizio = secondi();
+    cache.budget = (size_t)-1;
+    lavoro.alberi = (struct alberoSPF **)malloc((lavoro.g->numNodi + 1) * sizeof(struct alberoSPF *));
+    lavoro.numAlberi = 0;
+    if(router == NULL) {
+        for(i = 0; i < lavoro.g->numNodi; i++)
+            if(containsStart(i))
+                lavoro.alberi[lavoro.numAlberi++] = alberoPerSorgente(i);
+    }
+    else {
+        for(nome = strtok(router, ","); nome != NULL; nome = strtok(NULL, ",")) {
+            id = cercaNome(nome);
+            if(id < 0 || !containsStart(id)) {
+                fprintf(stderr, "Nodo non esistente: %s\n", nome);
+                free(lavoro.alberi);
+                free(lavoro.guasti);
+                return (EXIT_FAILURE);
+            }
+            if(lavoro.numAlberi < lavoro.g->numNodi)
+                lavoro.alberi[lavoro.numAlberi++] = alberoPerSorgente(id);
+        }
+    }
+    tempoBase = secondi() - inizio;
+
+    inizio = secondi();
+    lavoro.prossimo = 0;
+    lavoro.toccati = 0;
+    pthread_mutex_init(&lavoro.mutex, NULL);
+    thread = (pthread_t *)malloc(numThread * sizeof(pthread_t));
+    for(i = 0; i < numThread; i++)
+        pthread_create(&thread[i], NULL, threadResilienza, &lavoro);
+    for(i = 0; i < numThread; i++)
+        pthread_join(thread[i], NULL);
+    free(thread);
+    pthread_mutex_destroy(&lavoro.mutex);
+
+    for(i = 0; i < lavoro.numGuasti; i++) {
+        scriviGuasto(&testo, &lavoro.guasti[i]);
+        svuotaBuffer(&testo, stdout, false);
+        if(lavoro.guasti[i].irraggiungibili > 0)
+            partizioni++;
+        if(peggiore == NULL || lavoro.guasti[i].cambiate > peggiore->cambiate)
+            peggiore = &lavoro.guasti[i];
+    }
+    aggiungiStringa(&testo, "\nGuasti che partizionano la rete: ");
+    aggiungiIntero(&testo, partizioni);
+    aggiungiStringa(&testo, " su ");
+    aggiungiIntero(&testo, lavoro.numGuasti);
+    aggiungiStringa(&testo, "\n");
+    if(peggiore != NULL && peggiore->cambiate > 0) {
+        aggiungiStringa(&testo, "Guasto con più destinazioni cambiate: ");
+        scriviGuasto(&testo, peggiore);
+    }
+    svuotaBuffer(&testo, stdout, true);
+    fprintf(stderr, "%d guasti su %d tabelle: alberi di base %.3f s, guasti %.3f s con %d thread, %lld nodi ricalcolati\n",
+            lavoro.numGuasti, lavoro.numAlberi, tempoBase, secondi() - inizio, numThread, lavoro.toccati);
+    free(testo.dati);
+    free(lavoro.alberi);
+    free(lavoro.guasti);
+    return (EXIT_SUCCESS);
 }